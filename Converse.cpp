@@ -426,6 +426,10 @@ void Converse::stop()
 
     reset(); // free memory
 
+    KoreanTranslation *korean = Game::get_game()->get_korean_translation();
+    if(korean)
+        korean->flushUntranslatedLog(); // write lines missed during the conversation
+
     if(Game::get_game()->using_new_converse_gump())
     {
     	scroll->Hide();
@@ -789,35 +793,36 @@ void ConvScript::read_script()
     unsigned char *undec_script = 0; // item as it appears in library
     unsigned char *dec_script = 0; // decoded
     uint32 undec_len = 0, dec_len = 0;
-    U6Lzw decoder;
     uint8 gametype=src->get_game_type();
 
     undec_len = src->get_item_size(src_index);
     if(undec_len > 4)
     {
-	undec_script = src->get_item(src_index);
 	if (gametype==NUVIE_GAME_U6) {
 	    // decode
-	    if(!(undec_script[0] == 0 && undec_script[1] == 0
-			&& undec_script[2] == 0 && undec_script[3] == 0))
-	    {
+	    dec_script = src->get_item_lzw(src_index, dec_len);
+	    if(dec_script)
 		compressed = true;
-		dec_script =
-		    decoder.decompress_buffer(undec_script, undec_len, dec_len);
-		free(undec_script);
-	    }
 	    else
 	    {
-		compressed = false;
-		dec_len = undec_len - 4;
-		dec_script = (unsigned char *)malloc(dec_len);
-		memcpy(dec_script, undec_script + 4, dec_len);
+		dec_len = 0;
+		undec_script = src->get_item(src_index);
+		// stored uncompressed, anything else failed to decode
+		if(undec_script && undec_script[0] == 0 && undec_script[1] == 0
+		   && undec_script[2] == 0 && undec_script[3] == 0)
+		{
+		    compressed = false;
+		    dec_len = undec_len - 4;
+		    dec_script = (unsigned char *)malloc(dec_len);
+		    memcpy(dec_script, undec_script + 4, dec_len);
+		}
 		free(undec_script);
 	    }
 	}
 	else
 	{
 	    // MD/SE compression handled by lzc library
+		undec_script = src->get_item(src_index);
 		compressed = false;
 		dec_len = undec_len;
 		dec_script = undec_script;
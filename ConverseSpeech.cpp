@@ -110,26 +110,19 @@ void ConverseSpeech::play_speech(uint16 actor_num, uint16 sample_num)
 
 NuvieIOBuffer *ConverseSpeech::load_speech(std::string filename, uint16 sample_num)
 {
- unsigned char *compressed_data, *raw_audio, *wav_data;
+ unsigned char *raw_audio, *wav_data;
  sint16 *converted_audio;
  uint32 decomp_size;
  uint32 upsampled_size;
  sint16 sample=0, prev_sample;
  U6Lib_n sam_file;
- U6Lzw lzw;
  NuvieIOBuffer *wav_buffer = 0;
  uint32 j, k;
 
  if(!sam_file.open(filename, 4))
    return NULL;
 
- compressed_data = sam_file.get_item(sample_num, NULL);
- if(compressed_data == NULL)
-   return NULL;
-
- raw_audio = lzw.decompress_buffer(compressed_data, sam_file.get_item_size(sample_num), decomp_size);
-
- free(compressed_data);
+ raw_audio = sam_file.get_item_lzw(sample_num, decomp_size);
 
  if(raw_audio != NULL)
   {
@@ -2490,6 +2490,11 @@ inline Uint32 Event::TimeLeft() {
     //printf("FPS: %f %d\n", fps, (uint32)(now - fps_timestamp));
     fps_counter_widget->setFps(fps);
     fps_timestamp = now;
+    DEBUG(0, LEVEL_DEBUGGING, "Timers: %d queued (peak %d), fired per frame peak %d; game time %d queued (peak %d), fired peak %d\n",
+          time_queue->get_size(), time_queue->get_max_size(), time_queue->get_max_fired(),
+          game_time_queue->get_size(), game_time_queue->get_max_size(), game_time_queue->get_max_fired());
+    time_queue->reset_stats();
+    game_time_queue->reset_stats();
   } else
     fps_counter++;
 
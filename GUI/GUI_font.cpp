@@ -242,7 +242,10 @@ void GUI_Font::TextOutScaled(SDL_Surface* context, int x, int y, const char* tex
             if (dest_x < 0 || dest_x >= context->w || dest_y < 0 || dest_y >= context->h)
               continue;
 
-            if (context->format->BytesPerPixel == 2) {
+            if (context->format->BytesPerPixel == 1) {
+              Uint8 *dest_ptr = (Uint8*)context->pixels + dest_y * context->pitch + dest_x;
+              *dest_ptr = (Uint8)pixel;
+            } else if (context->format->BytesPerPixel == 2) {
               Uint16 *dest_ptr = (Uint16*)((Uint8*)context->pixels + dest_y * context->pitch + dest_x * 2);
               *dest_ptr = (Uint16)pixel;
             } else if (context->format->BytesPerPixel == 4) {
@@ -718,6 +718,8 @@ void Game::play()
      // Check for autosave (1 minute interval)
      save_manager->check_autosave();
 
+     script->update_gc();
+
      event->wait();
    }
   return;
@@ -16,6 +16,9 @@
 #include <set>
 #include <cctype>
 #include <vector>
+#include <sys/stat.h>
+
+#include "SDL.h"
 
 #include "nuvieDefs.h"
 
@@ -36,6 +39,12 @@ static std::string toLowercase(const std::string &str)
     return result;
 }
 
+// Text files the catalog is built from
+static const char *korean_text_files[] = {
+    "look_items_ko.txt", "ui_texts_ko.txt", "npc_dialogues_ko.txt", "dialogues_ko.txt",
+    "compound_dialogues.txt", "books_ko.txt", "spells_ko.txt", "keywords_ko.txt", NULL
+};
+
 KoreanTranslation::KoreanTranslation(Configuration *cfg)
 {
     config = cfg;
@@ -44,6 +53,7 @@ KoreanTranslation::KoreanTranslation(Configuration *cfg)
 
 KoreanTranslation::~KoreanTranslation()
 {
+    flushUntranslatedLog();
 }
 
 bool KoreanTranslation::init()
@@ -69,6 +79,67 @@ bool KoreanTranslation::init()
 
     ConsoleAddInfo("KoreanTranslation: Looking for files in: %s", data_path.c_str());
 
+    uint32 start_ticks = SDL_GetTicks();
+    bool built = false;
+    std::string catalog_path;
+    build_path(data_path, KOREAN_CATALOG_FILENAME, catalog_path);
+
+    if (!isCatalogCurrent(catalog_path) || !catalog.load(catalog_path, KOREAN_CATALOG_VERSION))
+    {
+        loadTextFiles();
+        buildCatalog();
+        built = true;
+        if (!catalog.save(catalog_path))
+            DEBUG(0, LEVEL_WARNING, "KoreanTranslation: Cannot write %s, the catalog will be rebuilt next time\n", catalog_path.c_str());
+    }
+
+    enabled = (catalog.get_num_entries(KT_LOOK) > 0);
+
+    ConsoleAddInfo("KoreanTranslation: %s in %d ms: %d entries (%d look, %d ui, %d npc, %d dialogue, %d keyword), %d KB",
+                   built ? "Built catalog from text files" : "Loaded catalog", SDL_GetTicks() - start_ticks,
+                   catalog.get_num_entries(), catalog.get_num_entries(KT_LOOK), catalog.get_num_entries(KT_UI),
+                   catalog.get_num_entries(KT_NPC_DIALOGUE), catalog.get_num_entries(KT_DIALOGUE),
+                   catalog.get_num_entries(KT_KEYWORD), catalog.get_size() / 1024);
+
+    if (enabled)
+    {
+        ConsoleAddInfo("KoreanTranslation: Korean translation system initialized - ENABLED");
+    }
+    else
+    {
+        ConsoleAddInfo("KoreanTranslation: No translation files found - DISABLED");
+    }
+
+    return enabled;
+}
+
+// The catalog is current if it is newer than every text file.
+bool KoreanTranslation::isCatalogCurrent(const std::string &catalog_path)
+{
+    struct stat catalog_stat, text_stat;
+
+    if (stat(catalog_path.c_str(), &catalog_stat) != 0)
+        return false;
+
+    for (int i = 0; korean_text_files[i]; i++)
+    {
+        std::string text_path;
+        build_path(data_path, korean_text_files[i], text_path);
+        if (stat(text_path.c_str(), &text_stat) == 0 && text_stat.st_mtime >= catalog_stat.st_mtime)
+        {
+            ConsoleAddInfo("KoreanTranslation: %s changed, rebuilding catalog", korean_text_files[i]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Parse every text file into the translation maps.
+bool KoreanTranslation::loadTextFiles()
+{
+    bool loaded_look = false;
+
     // Try to load translation files
     std::string look_path;
     build_path(data_path, "look_items_ko.txt", look_path);
@@ -77,8 +148,8 @@ bool KoreanTranslation::init()
 
     if (loadLookTranslations(look_path))
     {
-        enabled = true;
-        ConsoleAddInfo("KoreanTranslation: Loaded look translations! enabled=true");
+        loaded_look = true;
+        ConsoleAddInfo("KoreanTranslation: Loaded look translations!");
     }
     else
     {
@@ -138,16 +209,92 @@ bool KoreanTranslation::init()
         ConsoleAddInfo("KoreanTranslation: Loaded keyword translations");
     }
 
-    if (enabled)
+    return loaded_look;
+}
+
+// Move the translation maps into the catalog.
+void KoreanTranslation::buildCatalog()
+{
+    std::set<std::string> added;
+
+    catalog.clear();
+
+    for (std::map<uint16, std::string>::iterator it = look_translations.begin(); it != look_translations.end(); ++it)
+        catalog.add(KT_LOOK, it->first, "", it->second);
+    for (std::map<std::string, std::string>::iterator it = item_names.begin(); it != item_names.end(); ++it)
     {
-        ConsoleAddInfo("KoreanTranslation: Korean translation system initialized - ENABLED");
+        catalog.add(KT_ITEM_NAME, 0, it->first, it->second);
+        std::string lower_name = toLowercase(it->first);
+        if (added.insert(lower_name).second)
+            catalog.add(KT_ITEM_NAME_LOWER, 0, lower_name, it->second);
     }
-    else
+    for (std::map<std::string, std::string>::iterator it = npc_names.begin(); it != npc_names.end(); ++it)
+        catalog.add(KT_NPC_NAME, 0, it->first, it->second);
+    for (std::map<std::string, std::string>::iterator it = keywords.begin(); it != keywords.end(); ++it)
+        catalog.add(KT_KEYWORD, 0, it->first, it->second);
+    for (std::map<uint16, std::map<std::string, std::string> >::iterator npc_it = npc_dialogues.begin(); npc_it != npc_dialogues.end(); ++npc_it)
     {
-        ConsoleAddInfo("KoreanTranslation: No translation files found - DISABLED");
+        for (std::map<std::string, std::string>::iterator it = npc_it->second.begin(); it != npc_it->second.end(); ++it)
+            catalog.add(KT_NPC_DIALOGUE, npc_it->first, it->first, it->second);
+    }
+    for (std::map<std::string, std::string>::iterator it = ui_texts.begin(); it != ui_texts.end(); ++it)
+        catalog.add(KT_UI, 0, it->first, it->second);
+    for (std::map<uint16, std::string>::iterator it = book_translations.begin(); it != book_translations.end(); ++it)
+        catalog.add(KT_BOOK, it->first, "", it->second);
+    for (std::map<uint16, std::string>::iterator it = spell_translations.begin(); it != spell_translations.end(); ++it)
+        catalog.add(KT_SPELL, it->first, "", it->second);
+    added.clear();
+    for (std::map<uint16, std::map<std::string, std::string> >::iterator npc_it = dialogue_translations.begin(); npc_it != dialogue_translations.end(); ++npc_it)
+    {
+        for (std::map<std::string, std::string>::iterator it = npc_it->second.begin(); it != npc_it->second.end(); ++it)
+        {
+            catalog.add(KT_DIALOGUE, npc_it->first, it->first, it->second);
+            if (added.insert(it->first).second)
+                catalog.add(KT_DIALOGUE_ANY_NPC, 0, it->first, it->second);
+        }
+    }
+    for (std::map<uint16, std::map<std::string, std::string> >::iterator npc_it = dialogue_canonical.begin(); npc_it != dialogue_canonical.end(); ++npc_it)
+    {
+        for (std::map<std::string, std::string>::iterator it = npc_it->second.begin(); it != npc_it->second.end(); ++it)
+            catalog.add(KT_DIALOGUE_CANONICAL, npc_it->first, it->first, it->second);
     }
 
-    return enabled;
+    catalog.build(KOREAN_CATALOG_VERSION);
+
+    look_translations.clear();
+    item_names.clear();
+    npc_names.clear();
+    keywords.clear();
+    npc_dialogues.clear();
+    ui_texts.clear();
+    book_translations.clear();
+    spell_translations.clear();
+    dialogue_translations.clear();
+    dialogue_canonical.clear();
+}
+
+bool KoreanTranslation::findText(uint16 table, uint16 group, const std::string &key, uint32 key_hash, std::string &text)
+{
+    uint32 length;
+    const char *value = catalog.find_hashed(table, group, key.c_str(), (uint32)key.length(), key_hash, &length);
+
+    if (value == NULL)
+        return false;
+
+    text.assign(value, length);
+    return true;
+}
+
+bool KoreanTranslation::findText(uint16 table, uint16 group, const std::string &key, std::string &text)
+{
+    uint32 length;
+    const char *value = catalog.find(table, group, key, &length);
+
+    if (value == NULL)
+        return false;
+
+    text.assign(value, length);
+    return true;
 }
 
 bool KoreanTranslation::loadLookTranslations(const std::string &filename)
@@ -333,11 +480,9 @@ std::string KoreanTranslation::getLookText(uint16 item_index)
     if (!enabled)
         return "";
 
-    std::map<uint16, std::string>::iterator it = look_translations.find(item_index);
-    if (it != look_translations.end())
-    {
-        return it->second;
-    }
+    std::string text;
+    if (findText(KT_LOOK, item_index, "", text))
+        return text;
     return "";
 }
 
@@ -346,11 +491,9 @@ std::string KoreanTranslation::getNPCName(const std::string &english_name)
     if (!enabled)
         return english_name;
 
-    std::map<std::string, std::string>::iterator it = npc_names.find(english_name);
-    if (it != npc_names.end())
-    {
-        return it->second;
-    }
+    std::string text;
+    if (findText(KT_NPC_NAME, 0, english_name, text))
+        return text;
     return english_name;
 }
 
@@ -359,15 +502,9 @@ std::string KoreanTranslation::getNPCDialogue(uint16 npc_num, const std::string
     if (!enabled)
         return "";
 
-    std::map<uint16, std::map<std::string, std::string>>::iterator npc_it = npc_dialogues.find(npc_num);
-    if (npc_it != npc_dialogues.end())
-    {
-        std::map<std::string, std::string>::iterator kw_it = npc_it->second.find(keyword);
-        if (kw_it != npc_it->second.end())
-        {
-            return kw_it->second;
-        }
-    }
+    std::string text;
+    if (findText(KT_NPC_DIALOGUE, npc_num, keyword, text))
+        return text;
     return "";
 }
 
@@ -376,11 +513,9 @@ std::string KoreanTranslation::getUIText(const std::string &key)
     if (!enabled)
         return "";
 
-    std::map<std::string, std::string>::iterator it = ui_texts.find(key);
-    if (it != ui_texts.end())
-    {
-        return it->second;
-    }
+    std::string text;
+    if (findText(KT_UI, 0, key, text))
+        return text;
     return "";
 }
 
@@ -437,50 +572,29 @@ std::string KoreanTranslation::translate(const std::string &english_text)
         }
     }
 
+    std::string text;
+
     // First check UI texts
-    std::map<std::string, std::string>::iterator it = ui_texts.find(english_text);
-    if (it != ui_texts.end())
-    {
-        return it->second;
-    }
+    if (findText(KT_UI, 0, english_text, text))
+        return text;
 
     // Check NPC names
-    it = npc_names.find(english_text);
-    if (it != npc_names.end())
-    {
-        return it->second;
-    }
+    if (findText(KT_NPC_NAME, 0, english_text, text))
+        return text;
 
     // Check item names (from look_items_ko.txt)
-    it = item_names.find(english_text);
-    if (it != item_names.end())
-    {
-        return it->second;
-    }
-
-    // Debug: log when searching for item names
-    if (english_text == "thread" || english_text == "cloth") {
-    }
+    if (findText(KT_ITEM_NAME, 0, english_text, text))
+        return text;
 
     // Also try case-insensitive match for item names
     std::string lower_text = toLowercase(english_text);
-    for (std::map<std::string, std::string>::iterator iter = item_names.begin();
-         iter != item_names.end(); ++iter)
-    {
-        if (toLowercase(iter->first) == lower_text)
-        {
-            return iter->second;
-        }
-    }
+    if (findText(KT_ITEM_NAME_LOWER, 0, lower_text, text))
+        return text;
 
     // Try dialogue translations (for shop items stored as NPC dialogues)
-    for (std::map<uint16, std::map<std::string, std::string> >::iterator npc_it = dialogue_translations.begin();
-         npc_it != dialogue_translations.end(); ++npc_it)
-    {
-        std::map<std::string, std::string>::iterator it = npc_it->second.find(lower_text);
-        if (it != npc_it->second.end())
-            return it->second;
-    }
+    uint32 hash = normalizeDialogue(english_text, scratch_key, false);
+    if (findText(KT_DIALOGUE_ANY_NPC, 0, scratch_key, hash, text))
+        return text;
 
     // Not found - return original text without logging (too noisy)
     return english_text;
@@ -488,12 +602,12 @@ std::string KoreanTranslation::translate(const std::string &english_text)
 
 bool KoreanTranslation::hasLookTranslation(uint16 item_index)
 {
-    return look_translations.find(item_index) != look_translations.end();
+    return catalog.find(KT_LOOK, item_index, "") != NULL;
 }
 
 bool KoreanTranslation::hasNPCName(const std::string &english_name)
 {
-    return npc_names.find(english_name) != npc_names.end();
+    return catalog.find(KT_NPC_NAME, 0, english_name) != NULL;
 }
 
 // Check if the last character of a Korean string has a final consonant (받침/종성)
@@ -647,41 +761,74 @@ std::string KoreanTranslation::getParticle_euroro(const std::string &korean_word
     return "\xEC\x9C\xBC\xEB\xA1\x9C";  // euro
 }
 
-// Normalize text for comparison: collapse whitespace/newlines around * separators
-static std::string normalizeDialogueText(const std::string &text)
+/* Write the lookup key for a line of dialogue into key and return its hash.
+ * Speech tags (~P12, ~L12) and item tags (+33Book+) are dropped, ASCII is
+ * lowercased and whitespace and '{' are trimmed from both ends, '*' and
+ * quotes from the end, as translateDialogue() drops stray closing quotes.
+ * A canonical key also drops quotes, '@', '{', spaces and carriage returns
+ * and turns each run of newlines and '*' into a single '*', so lines that
+ * only differ in those match. The loader and the lookups both use this.
+ */
+uint32 KoreanTranslation::normalizeDialogue(const std::string &text, std::string &key, bool canonical)
 {
-    std::string result;
-    result.reserve(text.length());
+    const char *src = text.c_str();
+    size_t len = text.length();
+    bool separator = false;
 
-    for (size_t i = 0; i < text.length(); i++)
+    key.clear();
+
+    for (size_t i = 0; i < len; i++)
     {
-        char c = text[i];
-        if (c == '\r')
-            continue; // Skip carriage returns
-        if (c == '\n' || c == '*')
+        char c = src[i];
+
+        if (c == '~' && i + 1 < len && (src[i + 1] == 'P' || src[i + 1] == 'L'))
         {
-            // Skip whitespace and * between quoted parts
-            // But preserve the separator concept by collapsing to single *
-            while (i + 1 < text.length() &&
-                   (text[i+1] == '\n' || text[i+1] == '\r' || text[i+1] == '*' || text[i+1] == ' '))
-                i++;
-            // Only add separator if we're between content
-            if (!result.empty() && result.back() != '*' && i + 1 < text.length())
-                result += '*';
+            for (i += 2; i < len && src[i] >= '0' && src[i] <= '9'; i++)
+                ;
+            i--;
+            continue;
         }
-        else
+        if (c == '+' && i + 1 < len && src[i + 1] >= '0' && src[i + 1] <= '9')
         {
-            result += c;
+            size_t close_pos = text.find('+', i + 1);
+            if (close_pos != std::string::npos)
+            {
+                i = close_pos;
+                continue;
+            }
         }
+
+        if (canonical)
+        {
+            if (c == '"' || c == '\'' || c == '@' || c == '{' || c == ' ' || c == '\r')
+                continue;
+            if (c == '\n' || c == '*')
+            {
+                separator = true;
+                continue;
+            }
+            if (separator && !key.empty())
+                key += '*';
+            separator = false;
+        }
+
+        key += (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
     }
 
-    // Trim leading/trailing whitespace and *
-    while (!result.empty() && (result[0] == ' ' || result[0] == '*'))
-        result.erase(0, 1);
-    while (!result.empty() && (result.back() == ' ' || result.back() == '*'))
-        result.pop_back();
+    if (!canonical)
+    {
+        size_t end = key.length();
+        while (end > 0 && (key[end - 1] == ' ' || key[end - 1] == '\n' || key[end - 1] == '\r' || key[end - 1] == '*' || key[end - 1] == '{' || key[end - 1] == '"' || key[end - 1] == '\''))
+            end--;
+        key.resize(end);
+
+        size_t start = 0;
+        while (start < end && (key[start] == ' ' || key[start] == '\n' || key[start] == '\r' || key[start] == '{'))
+            start++;
+        key.erase(0, start);
+    }
 
-    return result;
+    return TranslationCatalog::hash_key(key.c_str(), (uint32)key.length());
 }
 
 bool KoreanTranslation::loadDialogueTranslations(const std::string &filename)
@@ -696,6 +843,7 @@ bool KoreanTranslation::loadDialogueTranslations(const std::string &filename)
     // Don't clear - allow multiple files to be loaded (dialogues_ko.txt + compound_dialogues.txt)
     std::string line;
     int loaded = 0;
+    std::map<std::pair<uint16, std::string>, size_t> key_text_length; // length of the line each exact key came from
 
     while (std::getline(file, line))
     {
@@ -734,53 +882,23 @@ bool KoreanTranslation::loadDialogueTranslations(const std::string &filename)
 
         if (!english_text.empty())
         {
-            // Store with lowercase key for case-insensitive matching
-            std::string lower_key = toLowercase(english_text);
-            dialogue_translations[npc_num][lower_key] = korean_text;
-
-            // Also store normalized version for multiline matching
-            std::string normalized = toLowercase(normalizeDialogueText(english_text));
-            if (normalized != lower_key && !normalized.empty())
-                dialogue_translations[npc_num][normalized] = korean_text;
-
-            // Also store version with all quotes removed (for fuzzy matching)
-            std::string no_quotes_key;
-            for (size_t i = 0; i < english_text.size(); i++)
+            // Store the exact and the canonical key, lookups try both. When
+            // lines share an exact key the shortest wins, so a later "text"*
+            // doesn't replace "text", but a later copy of the same line does.
+            // Lines that only differ in markup share a canonical key, the first wins.
+            normalizeDialogue(english_text, scratch_key, false);
+            if (!scratch_key.empty())
             {
-                if (english_text[i] != '"' && english_text[i] != '\'')
-                    no_quotes_key += english_text[i];
-            }
-            std::string lower_no_quotes = toLowercase(no_quotes_key);
-            if (lower_no_quotes != lower_key && !lower_no_quotes.empty())
-                dialogue_translations[npc_num][lower_no_quotes] = korean_text;
-
-            // Store FM Towns compatible key: @ removed AND spaces before punctuation removed (combined)
-            std::string fmtowns_key = english_text;
-            // Remove @ symbols
-            size_t at_pos;
-            while ((at_pos = fmtowns_key.find('@')) != std::string::npos)
-                fmtowns_key.erase(at_pos, 1);
-            // Remove spaces before punctuation
-            size_t sp_pos;
-            while ((sp_pos = fmtowns_key.find(" ?")) != std::string::npos)
-                fmtowns_key.erase(sp_pos, 1);
-            while ((sp_pos = fmtowns_key.find(" !")) != std::string::npos)
-                fmtowns_key.erase(sp_pos, 1);
-            while ((sp_pos = fmtowns_key.find(" .")) != std::string::npos)
-                fmtowns_key.erase(sp_pos, 1);
-            std::string lower_fmtowns = toLowercase(fmtowns_key);
-            if (lower_fmtowns != lower_key && !lower_fmtowns.empty())
-                dialogue_translations[npc_num][lower_fmtowns] = korean_text;
-
-            // Store key with all spaces AND quotes removed (handles spacing differences)
-            std::string no_spaces_key;
-            for (size_t i = 0; i < lower_no_quotes.size(); i++)
-            {
-                if (lower_no_quotes[i] != ' ')
-                    no_spaces_key += lower_no_quotes[i];
+                size_t &text_length = key_text_length[std::make_pair(npc_num, scratch_key)];
+                if (text_length == 0 || english_text.length() <= text_length)
+                {
+                    text_length = english_text.length();
+                    dialogue_translations[npc_num][scratch_key] = korean_text;
+                }
             }
-            if (!no_spaces_key.empty() && no_spaces_key != lower_no_quotes)
-                dialogue_translations[npc_num][no_spaces_key] = korean_text;
+            normalizeDialogue(english_text, scratch_key, true);
+            if (!scratch_key.empty())
+                dialogue_canonical[npc_num].insert(std::make_pair(scratch_key, korean_text));
 
             // If this contains compound text with \n*\n or *, also register individual parts
             // This allows both combined and split forms to work
@@ -843,8 +961,13 @@ bool KoreanTranslation::loadDialogueTranslations(const std::string &filename)
                             eng_part.pop_back();
                         if (!eng_part.empty())
                         {
-                            std::string part_key = toLowercase(eng_part);
-                            dialogue_translations[npc_num][part_key] = kor_part;
+                            // A whole line with the same text keeps its own translation
+                            normalizeDialogue(eng_part, scratch_key, false);
+                            if (!scratch_key.empty())
+                                dialogue_translations[npc_num].insert(std::make_pair(scratch_key, kor_part));
+                            normalizeDialogue(eng_part, scratch_key, true);
+                            if (!scratch_key.empty())
+                                dialogue_canonical[npc_num].insert(std::make_pair(scratch_key, kor_part));
                         }
                     }
                 }
@@ -856,211 +979,88 @@ bool KoreanTranslation::loadDialogueTranslations(const std::string &filename)
 
     file.close();
 
-    // Debug: list which NPCs have translations
-    for (std::map<uint16, std::map<std::string, std::string> >::iterator it = dialogue_translations.begin();
-         it != dialogue_translations.end(); ++it)
-    {
-    }
-
     return loaded > 0;
 }
 
 // Helper function to look up a single dialogue line
 std::string KoreanTranslation::lookupSingleDialogue(uint16 npc_num, const std::string &text)
 {
-    std::string trimmed = text;
-
-    // Remove FM Towns speech tags (~P and ~L followed by numbers)
-    // These are in the format ~P123 or ~L123
-    size_t tag_pos;
-    while ((tag_pos = trimmed.find("~P")) != std::string::npos)
-    {
-        size_t end_pos = tag_pos + 2;
-        while (end_pos < trimmed.length() && trimmed[end_pos] >= '0' && trimmed[end_pos] <= '9')
-            end_pos++;
-        trimmed.erase(tag_pos, end_pos - tag_pos);
-    }
-    while ((tag_pos = trimmed.find("~L")) != std::string::npos)
-    {
-        size_t end_pos = tag_pos + 2;
-        while (end_pos < trimmed.length() && trimmed[end_pos] >= '0' && trimmed[end_pos] <= '9')
-            end_pos++;
-        trimmed.erase(tag_pos, end_pos - tag_pos);
-    }
-
-
-    // Remove script item tags like +33Book+ (format: +number+text+)
-    // These are item references added by the game script
-    while ((tag_pos = trimmed.find('+')) != std::string::npos)
-    {
-        // Check if it starts with a number (like +33Book+)
-        if (tag_pos + 1 < trimmed.length() && trimmed[tag_pos + 1] >= '0' && trimmed[tag_pos + 1] <= '9')
-        {
-            // Find the number part
-            size_t num_end = tag_pos + 1;
-            while (num_end < trimmed.length() && trimmed[num_end] >= '0' && trimmed[num_end] <= '9')
-                num_end++;
-            // Find the text part and closing +
-            size_t close_pos = trimmed.find('+', num_end);
-            if (close_pos != std::string::npos)
-            {
-                trimmed.erase(tag_pos, close_pos - tag_pos + 1);
-                continue;
-            }
-        }
-        break; // Not a valid tag pattern, stop
-    }
-
-    DEBUG(0, LEVEL_DEBUGGING, "KoreanTranslation::lookupSingleDialogue NPC %d after tag removal: [%s]\n", npc_num, trimmed.c_str());
+    std::string result;
+    uint32 hash;
 
-    // Trim whitespace, { and trailing * (FM Towns inserts {\n before narrative text)
-    while (!trimmed.empty() && (trimmed[0] == ' ' || trimmed[0] == '\n' || trimmed[0] == '\r' || trimmed[0] == '{'))
-        trimmed.erase(0, 1);
-    while (!trimmed.empty() && (trimmed.back() == ' ' || trimmed.back() == '\n' || trimmed.back() == '\r' || trimmed.back() == '*' || trimmed.back() == '{'))
-        trimmed.pop_back();
-    // Note: Don't strip leading single quote - it may be part of the text (e.g., 'Abyss')
+    if (!catalog.has_group(KT_DIALOGUE, npc_num))
+        return "";
 
-    if (trimmed.empty())
+    hash = normalizeDialogue(text, scratch_key, false);
+    if (scratch_key.empty())
         return "";
+    if (findText(KT_DIALOGUE, npc_num, scratch_key, hash, result))
+        return result;
 
-    // Remove outer double quotes
-    std::string no_quotes = trimmed;
-    if (!no_quotes.empty() && no_quotes[0] == '"')
-        no_quotes.erase(0, 1);
-    if (!no_quotes.empty() && no_quotes.back() == '"')
-        no_quotes.pop_back();
+    // Fuzzy match, ignoring quotes, spaces, @keyword markers and separators
+    hash = normalizeDialogue(text, scratch_key, true);
+    if (!scratch_key.empty() && findText(KT_DIALOGUE_CANONICAL, npc_num, scratch_key, hash, result))
+        return result;
 
-    // Create version with ALL quotes removed (for fuzzy matching)
-    std::string no_all_quotes;
-    for (size_t i = 0; i < trimmed.size(); i++)
-    {
-        if (trimmed[i] != '"' && trimmed[i] != '\'')
-            no_all_quotes += trimmed[i];
-    }
+    return "";
+}
 
-    // Create version with @ symbols removed (FM Towns uses @keyword markers)
-    std::string no_at_signs = trimmed;
-    size_t at_pos;
-    while ((at_pos = no_at_signs.find('@')) != std::string::npos)
-        no_at_signs.erase(at_pos, 1);
+std::string KoreanTranslation::getDialogueTranslation(uint16 npc_num, const std::string &english_text)
+{
+    if (!enabled)
+        return "";
 
-    // Also create no_quotes version without @ signs
-    std::string no_quotes_no_at = no_quotes;
-    while ((at_pos = no_quotes_no_at.find('@')) != std::string::npos)
-        no_quotes_no_at.erase(at_pos, 1);
+    // NPCs repeat the same lines, so results (and misses) are remembered
+    memo_key.assign((const char *)&npc_num, sizeof(npc_num));
+    memo_key.append(english_text);
 
-    std::map<uint16, std::map<std::string, std::string> >::iterator npc_it = dialogue_translations.find(npc_num);
-    if (npc_it != dialogue_translations.end())
-    {
-        // Convert to lowercase for case-insensitive matching
-        std::string lower_trimmed = toLowercase(trimmed);
-        std::string lower_no_quotes = toLowercase(no_quotes);
-        std::string lower_no_all_quotes = toLowercase(no_all_quotes);
-
-        std::map<std::string, std::string>::iterator it = npc_it->second.find(lower_trimmed);
-        if (it != npc_it->second.end())
-            return it->second;
-
-        it = npc_it->second.find(lower_no_quotes);
-        if (it != npc_it->second.end())
-            return it->second;
-
-        std::string with_quotes = "\"" + lower_trimmed + "\"";
-        it = npc_it->second.find(with_quotes);
-        if (it != npc_it->second.end())
-            return it->second;
-
-        with_quotes = "\"" + lower_no_quotes + "\"";
-        it = npc_it->second.find(with_quotes);
-        if (it != npc_it->second.end())
-            return it->second;
-
-        // Try with trailing quote removed (for cases like text ending with "")
-        if (!lower_trimmed.empty() && lower_trimmed.back() == '"')
-        {
-            std::string without_trailing_quote = lower_trimmed.substr(0, lower_trimmed.length() - 1);
-            it = npc_it->second.find(without_trailing_quote);
-            if (it != npc_it->second.end())
-                return it->second;
-        }
+    std::map<std::string, std::string>::iterator it = dialogue_memo.find(memo_key);
+    if (it != dialogue_memo.end())
+        return it->second;
 
-        // Try with ALL quotes removed (fuzzy match for 'Path' vs Path etc)
-        it = npc_it->second.find(lower_no_all_quotes);
-        if (it != npc_it->second.end())
-            return it->second;
-
-        // Try with @ symbols removed (FM Towns uses @keyword markers that DOS doesn't have)
-        std::string lower_no_at = toLowercase(no_at_signs);
-        it = npc_it->second.find(lower_no_at);
-        if (it != npc_it->second.end())
-            return it->second;
-
-        std::string lower_no_quotes_no_at = toLowercase(no_quotes_no_at);
-        it = npc_it->second.find(lower_no_quotes_no_at);
-        if (it != npc_it->second.end())
-            return it->second;
-
-        // Try with quotes around the @ removed version
-        with_quotes = "\"" + lower_no_quotes_no_at + "\"";
-        it = npc_it->second.find(with_quotes);
-        if (it != npc_it->second.end())
-            return it->second;
-
-        // Try with all spaces removed (handles DOS vs FM Towns spacing differences)
-        std::string no_spaces;
-        for (size_t i = 0; i < lower_no_quotes_no_at.size(); i++)
-        {
-            if (lower_no_quotes_no_at[i] != ' ')
-                no_spaces += lower_no_quotes_no_at[i];
-        }
-        if (!no_spaces.empty())
-        {
-            it = npc_it->second.find(no_spaces);
-            if (it != npc_it->second.end())
-                return it->second;
-        }
+    std::string result = translateDialogue(npc_num, english_text);
 
-        // Try normalized version for multiline texts
-        std::string normalized = toLowercase(normalizeDialogueText(trimmed));
-        it = npc_it->second.find(normalized);
-        if (it != npc_it->second.end())
-            return it->second;
-    }
+    if (dialogue_memo.size() >= KOREAN_DIALOGUE_MEMO_SIZE)
+        dialogue_memo.clear();
+    dialogue_memo[memo_key] = result;
 
-    return "";
+    return result;
 }
 
-std::string KoreanTranslation::getDialogueTranslation(uint16 npc_num, const std::string &english_text)
+std::string KoreanTranslation::translateDialogue(uint16 npc_num, const std::string &english_text)
 {
-    if (!enabled)
-        return "";
-
     // Check if this contains multiple dialogues separated by * or newlines
     // Pattern: "text1" * "text2" or "text1"\n"text2"
-    std::string trimmed = english_text;
+    const char *src = english_text.c_str();
+    size_t start = 0, end = english_text.length();
     // Remove leading whitespace, newlines, and * (but NOT single quotes - they may be part of text like 'Path')
-    while (!trimmed.empty() && (trimmed[0] == ' ' || trimmed[0] == '\n' || trimmed[0] == '\r' || trimmed[0] == '*'))
-        trimmed.erase(0, 1);
+    while (start < end && (src[start] == ' ' || src[start] == '\n' || src[start] == '\r' || src[start] == '*'))
+        start++;
     // Special case: if text starts with '' (double single-quote), remove one (orphan from previous line)
-    if (trimmed.length() >= 2 && trimmed[0] == '\'' && trimmed[1] == '\'')
-        trimmed.erase(0, 1);
+    if (end - start >= 2 && src[start] == '\'' && src[start + 1] == '\'')
+        start++;
     // Remove trailing whitespace, newlines, *, and stray quotes (orphan quotes from dialogue)
-    while (!trimmed.empty() && (trimmed.back() == ' ' || trimmed.back() == '\n' || trimmed.back() == '\r' || trimmed.back() == '*' || trimmed.back() == '\'' || trimmed.back() == '"'))
-        trimmed.pop_back();
+    while (end > start && (src[end - 1] == ' ' || src[end - 1] == '\n' || src[end - 1] == '\r' || src[end - 1] == '*' || src[end - 1] == '\'' || src[end - 1] == '"'))
+        end--;
 
     // FM Towns page break: remove all '{' characters before lookup
     // In FM Towns, '{' acts as a page break marker within dialogue text.
     // These are embedded in the text stream and must be stripped for translation matching.
+    std::string trimmed;
+    trimmed.reserve(end - start);
+    for (size_t i = start; i < end; i++)
     {
-        size_t brace_pos;
-        while ((brace_pos = trimmed.find('{')) != std::string::npos)
-            trimmed.erase(brace_pos, 1);
-        // Re-trim after brace removal (may leave trailing whitespace/newlines)
-        while (!trimmed.empty() && (trimmed.back() == ' ' || trimmed.back() == '\n' || trimmed.back() == '\r' || trimmed.back() == '*'))
-            trimmed.pop_back();
-        while (!trimmed.empty() && (trimmed[0] == ' ' || trimmed[0] == '\n' || trimmed[0] == '\r'))
-            trimmed.erase(0, 1);
+        if (src[i] != '{')
+            trimmed += src[i];
     }
+    // Re-trim after brace removal (may leave trailing whitespace/newlines)
+    end = trimmed.length();
+    while (end > 0 && (trimmed[end - 1] == ' ' || trimmed[end - 1] == '\n' || trimmed[end - 1] == '\r' || trimmed[end - 1] == '*'))
+        end--;
+    trimmed.resize(end);
+    for (start = 0; start < end && (trimmed[start] == ' ' || trimmed[start] == '\n' || trimmed[start] == '\r'); start++)
+        ;
+    trimmed.erase(0, start);
 
     // Try direct lookup first (for complete text)
     std::string result = lookupSingleDialogue(npc_num, trimmed);
@@ -1272,26 +1272,51 @@ std::string KoreanTranslation::getDialogueTranslation(uint16 npc_num, const std:
     }
 
     // Log untranslated text
-    static std::set<std::string> logged_texts;
-    std::string log_key = std::to_string(npc_num) + "|" + trimmed;
-    if (logged_texts.find(log_key) == logged_texts.end() && !trimmed.empty() && trimmed.length() > 3)
+    if (trimmed.length() > 3)
+        logUntranslated(npc_num, trimmed);
+
+    return "";
+}
+
+// Queue a line for untranslated_log.txt, once per npc and text.
+void KoreanTranslation::logUntranslated(uint16 npc_num, const std::string &text)
+{
+    char num[8];
+    snprintf(num, sizeof(num), "%d|", npc_num);
+
+    std::string line = num;
+    for (size_t i = 0; i < text.length(); i++)
     {
-        logged_texts.insert(log_key);
-        std::string log_path;
-        build_path(data_path, "untranslated_log.txt", log_path);
-        std::ofstream log(log_path.c_str(), std::ios::app);
-        if (log.is_open())
-        {
-            std::string escaped = trimmed;
-            size_t pos;
-            while ((pos = escaped.find('\n')) != std::string::npos)
-                escaped.replace(pos, 1, "\\n");
-            log << npc_num << "|" << escaped << "|<need translation>\n";
-            log.close();
-        }
+        if (text[i] == '\n')
+            line += "\\n";
+        else
+            line += text[i];
     }
 
-    return "";
+    if (!logged_texts.insert(line).second)
+        return;
+
+    untranslated_log += line;
+    untranslated_log += "|<need translation>\n";
+
+    if (untranslated_log.length() >= KOREAN_LOG_FLUSH_SIZE)
+        flushUntranslatedLog();
+}
+
+void KoreanTranslation::flushUntranslatedLog()
+{
+    if (untranslated_log.empty())
+        return;
+
+    std::string log_path;
+    build_path(data_path, "untranslated_log.txt", log_path);
+    std::ofstream log(log_path.c_str(), std::ios::app);
+    if (log.is_open())
+    {
+        log << untranslated_log;
+        log.close();
+    }
+    untranslated_log.clear();
 }
 
 bool KoreanTranslation::loadBookTranslations(const std::string &filename)
@@ -1339,9 +1364,9 @@ std::string KoreanTranslation::getBookText(uint16 book_num)
     if (!enabled)
         return "";
 
-    std::map<uint16, std::string>::iterator it = book_translations.find(book_num);
-    if (it != book_translations.end())
-        return it->second;
+    std::string text;
+    if (findText(KT_BOOK, book_num, "", text))
+        return text;
     return "";
 }
 
@@ -1391,9 +1416,9 @@ std::string KoreanTranslation::getSpellName(uint16 spell_num)
     if (!enabled)
         return "";
 
-    std::map<uint16, std::string>::iterator it = spell_translations.find(spell_num);
-    if (it != spell_translations.end())
-        return it->second;
+    std::string text;
+    if (findText(KT_SPELL, spell_num, "", text))
+        return text;
     return "";
 }
 
@@ -1446,22 +1471,20 @@ std::string KoreanTranslation::getEnglishKeyword(const std::string &korean_keywo
         return "";
 
     // First try exact match
-    std::map<std::string, std::string>::iterator it = keywords.find(korean_keyword);
-    if (it != keywords.end())
-        return it->second;
+    std::string text;
+    if (findText(KT_KEYWORD, 0, korean_keyword, text))
+        return text;
 
     // Prefix match only for 4+ Korean characters (12+ bytes)
     // Like English 4-char matching: "brit" matches "british"
     // Korean: "브리티시" (4 chars) can match, but "브리" (2 chars) requires exact match
     if (korean_keyword.length() >= 12) {
-        for (it = keywords.begin(); it != keywords.end(); ++it) {
-            // Check if registered keyword starts with input (input is prefix of keyword)
-            // e.g., input "괴물사냥" matches keyword "괴물사냥꾼"
-            if (it->first.length() > korean_keyword.length() &&
-                it->first.compare(0, korean_keyword.length(), korean_keyword) == 0) {
-                return it->second;
-            }
-        }
+        // Check if registered keyword starts with input (input is prefix of keyword)
+        // e.g., input "괴물사냥" matches keyword "괴물사냥꾼"
+        uint32 length;
+        const char *english = catalog.find_longer(KT_KEYWORD, 0, korean_keyword, &length);
+        if (english)
+            return std::string(english, length);
     }
 
     return "";
@@ -16,6 +16,14 @@
 
 #include <string>
 #include <map>
+#include <set>
+
+#include "TranslationCatalog.h"
+
+#define KOREAN_CATALOG_FILENAME "catalog_ko.dat"
+#define KOREAN_DIALOGUE_MEMO_SIZE 2048 // dialogue lookups remembered before starting over
+#define KOREAN_LOG_FLUSH_SIZE 0x1000 // untranslated lines are written out past this many bytes
+#define KOREAN_CATALOG_VERSION 2 // bump when the way entries are built from the text files changes
 
 class Configuration;
 
@@ -25,7 +33,29 @@ private:
     Configuration *config;
     bool enabled;
 
-    // Translation maps for different text types
+    // Tables in the compiled catalog. Text looked up by number uses the
+    // number as the group and an empty key.
+    enum {
+        KT_LOOK,
+        KT_ITEM_NAME,
+        KT_ITEM_NAME_LOWER,     // lowercase item names, first in order wins
+        KT_NPC_NAME,
+        KT_KEYWORD,
+        KT_NPC_DIALOGUE,        // group is the npc number
+        KT_UI,
+        KT_BOOK,
+        KT_SPELL,
+        KT_DIALOGUE,            // group is the npc number
+        KT_DIALOGUE_CANONICAL,  // canonical keys, see normalizeDialogue()
+        KT_DIALOGUE_ANY_NPC     // dialogue keys of every npc, lowest npc wins
+    };
+
+    // All lookups go through the catalog. It is loaded from KOREAN_CATALOG_FILENAME,
+    // or built from the text files when they are newer.
+    TranslationCatalog catalog;
+
+    // Translation maps for different text types. The load*Translations()
+    // parsers fill these and buildCatalog() moves them into the catalog.
     std::map<uint16, std::string> look_translations;    // Item descriptions by index
     std::map<std::string, std::string> item_names;      // Item names (English -> Korean)
     std::map<std::string, std::string> npc_names;       // NPC names
@@ -45,11 +75,28 @@ private:
 
     // Dialogue translations: npc_num -> (english_text -> korean_text)
     std::map<uint16, std::map<std::string, std::string>> dialogue_translations;
+    std::map<uint16, std::map<std::string, std::string>> dialogue_canonical;
+
+    std::string scratch_key; // reused by normalizeDialogue() callers
+    std::string memo_key;
+    std::map<std::string, std::string> dialogue_memo; // npc number + raw text -> result
+
+    std::string untranslated_log; // lines not yet written to untranslated_log.txt
+    std::set<std::string> logged_texts;
 
     std::string data_path;  // Path to translation data files
 
     // Helper for looking up single dialogue line
     std::string lookupSingleDialogue(uint16 npc_num, const std::string &text);
+    std::string translateDialogue(uint16 npc_num, const std::string &english_text);
+    static uint32 normalizeDialogue(const std::string &text, std::string &key, bool canonical);
+    void logUntranslated(uint16 npc_num, const std::string &text);
+
+    bool isCatalogCurrent(const std::string &catalog_path);
+    bool loadTextFiles();
+    void buildCatalog();
+    bool findText(uint16 table, uint16 group, const std::string &key, std::string &text);
+    bool findText(uint16 table, uint16 group, const std::string &key, uint32 key_hash, std::string &text);
 
 public:
     KoreanTranslation(Configuration *cfg);
@@ -80,6 +127,9 @@ public:
     std::string getDialogueTranslation(uint16 npc_num, const std::string &english_text);
     std::string getSpellName(uint16 spell_num);
 
+    // Write out untranslated lines collected by getDialogueTranslation()
+    void flushUntranslatedLog();
+
     // Translate a string if translation exists, otherwise return original
     std::string translate(const std::string &english_text);
 
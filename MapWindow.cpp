@@ -184,7 +184,24 @@ MapWindow::MapWindow(Configuration *cfg, Map *m): GUI_Widget(NULL, 0, 0, 0, 0)
  window_updated = true;
  roof_display = ROOF_DISPLAY_NORMAL;
 
+ draw_list_dirty = true;
+ draw_list_map_changes = 0;
+ draw_list_x = draw_list_y = 0;
+ draw_list_level = 0;
+ draw_list_width = draw_list_height = 0;
+
  lighting_update_required = true;
+ light_sources_map_changes = 0;
+ light_sources_x = light_sources_y = 0;
+ light_sources_level = 0;
+ light_map_valid = false;
+ light_map_x = light_map_y = 0;
+ light_map_level = 0;
+ light_map_ambient = 0;
+ light_map_party_light = false;
+ light_map_style = LIGHTING_STYLE_NONE;
+ light_map_scale = 1;
+ light_map_width = light_map_height = 0;
 
  paper_clip_active = false;
  paper_clip_rect.x = 0;
@@ -1097,6 +1114,23 @@ void MapWindow::createLightOverlay()
      }
      else
          party_light_source = false;
+
+     // The shading map is only rebuilt when the view or the ambient light
+     // changed, otherwise just the globes that changed are redrawn.
+     if(light_map_valid && light_map_x == cur_x && light_map_y == cur_y && light_map_level == cur_level
+        && light_map_ambient == a && light_map_party_light == party_light_source
+        && light_map_style == screen->get_lighting_style() && light_map_scale == map_tile_scale
+        && light_map_width == win_width && light_map_height == win_height)
+     {
+         std::vector<MapWindowLight> globes;
+         getLightGlobes(globes);
+         if(updateLightingPartial(globes))
+         {
+             lighting_update_required = false;
+             return;
+         }
+     }
+
 	 screen->set_ambient( a );
 
      //Clear the opacity map
@@ -1104,12 +1138,83 @@ void MapWindow::createLightOverlay()
 
      updateLighting();
 
+     light_map_valid = true;
+     light_map_x = cur_x;
+     light_map_y = cur_y;
+     light_map_level = cur_level;
+     light_map_ambient = a;
+     light_map_party_light = party_light_source;
+     light_map_style = screen->get_lighting_style();
+     light_map_scale = map_tile_scale;
+     light_map_width = win_width;
+     light_map_height = win_height;
+
      lighting_update_required = false;
 }
 
-void MapWindow::updateLighting()
+static bool light_before(const MapWindowLight &l1, const MapWindowLight &l2)
+{
+  if(l1.y != l2.y)
+    return l1.y < l2.y;
+  if(l1.x != l2.x)
+    return l1.x < l2.x;
+  return l1.light < l2.light;
+}
+
+/* Rebuild the list of objs on visible tiles that may give off light. It is
+ * kept while the view, the blacking and the objs on the map stay the same.
+ * Whether an obj is lit is checked from its current frame each update.
+ */
+void MapWindow::updateLightSources()
+{
+  uint32 tmp_map_size = tmp_map_width * tmp_map_height;
+
+  if(tmp_map_size > 0 && light_sources_tmp_map.size() == tmp_map_size
+     && light_sources_map_changes == obj_manager->get_map_change_count()
+     && light_sources_x == cur_x && light_sources_y == cur_y && light_sources_level == cur_level
+     && memcmp(&light_sources_tmp_map[0], tmp_map_buf, tmp_map_size * sizeof(uint16)) == 0)
+    return;
+
+  light_sources.clear();
+  light_sources_tmp_map.assign(tmp_map_buf, tmp_map_buf + tmp_map_size);
+  light_sources_map_changes = obj_manager->get_map_change_count();
+  light_sources_x = cur_x;
+  light_sources_y = cur_y;
+  light_sources_level = cur_level;
+
+  uint16 *ptr = tmp_map_buf;
+  for(uint16 y=0;y<tmp_map_height;y++)
+  {
+    for(uint16 x=0;x<tmp_map_width;x++)
+    {
+      if(*ptr != 0)
+      {
+        U6LList *obj_list =obj_manager->get_obj_list(cur_x-TMP_MAP_BORDER + x,cur_y - TMP_MAP_BORDER + y,cur_level); //FIXME wrapped coords.
+        if(obj_list)
+        {
+          for(U6Link *link=obj_list->start();link != NULL;link=link->next)
+          {
+            MapWindowLightSource source;
+            source.obj = (Obj *)link->data;
+            source.x = x;
+            source.y = y;
+            light_sources.push_back(source);
+          }
+        }
+      }
+      ptr++;
+    }
+  }
+}
+
+// Get every light globe in view, sorted with light_before().
+void MapWindow::getLightGlobes(std::vector<MapWindowLight> &globes)
 {
+  MapWindowLight globe;
   uint16 x, y;
+
+  globes.clear();
+
   if(using_map_tile_lighting)
   {
     uint16 *ptr = tmp_map_buf;
@@ -1117,65 +1222,132 @@ void MapWindow::updateLighting()
     {
       for(x=0;x<tmp_map_width;x++)
       {
-        if(tmp_map_buf[x+y*tmp_map_width] != 0)
+        if(*ptr != 0)
         {
           Tile *tile = tile_manager->get_tile(*ptr);
           if(GET_TILE_LIGHT_LEVEL(tile) > 0)
-            screen->drawalphamap8globe(x-TMP_MAP_BORDER, y-TMP_MAP_BORDER, GET_TILE_LIGHT_LEVEL(tile));
-
-          U6LList *obj_list =obj_manager->get_obj_list(cur_x-TMP_MAP_BORDER + x,cur_y - TMP_MAP_BORDER + y,cur_level); //FIXME wrapped coords.
-          if(obj_list)
           {
-            for(U6Link *link=obj_list->start();link != NULL;link=link->next)
-            {
-              Obj *obj = (Obj *)link->data;
-              tile = tile_manager->get_tile(obj_manager->get_obj_tile_num(obj)+obj->frame_n); //FIXME do we need to check the light for each tile in a multi-tile object.
-              if(GET_TILE_LIGHT_LEVEL(tile) > 0 && can_display_obj(x, y, obj))
-                screen->drawalphamap8globe( x-TMP_MAP_BORDER, y-TMP_MAP_BORDER, GET_TILE_LIGHT_LEVEL(tile) );
-            }
+            globe.x = x-TMP_MAP_BORDER;
+            globe.y = y-TMP_MAP_BORDER;
+            globe.light = GET_TILE_LIGHT_LEVEL(tile);
+            globes.push_back(globe);
           }
         }
         ptr++;
       }
     }
 
+    updateLightSources();
+    for(std::vector<MapWindowLightSource>::iterator s = light_sources.begin(); s != light_sources.end(); s++)
+    {
+      Obj *obj = (*s).obj;
+      Tile *tile = tile_manager->get_tile(obj_manager->get_obj_tile_num(obj)+obj->frame_n); //FIXME do we need to check the light for each tile in a multi-tile object.
+      if(GET_TILE_LIGHT_LEVEL(tile) > 0 && can_display_obj((*s).x, (*s).y, obj))
+      {
+        globe.x = (*s).x-TMP_MAP_BORDER;
+        globe.y = (*s).y-TMP_MAP_BORDER;
+        globe.light = GET_TILE_LIGHT_LEVEL(tile);
+        globes.push_back(globe);
+      }
+    }
+
     for (std::vector<TileInfo>::iterator ti = m_ViewableMapTiles.begin();
          ti != m_ViewableMapTiles.end(); ti++) {
       if (GET_TILE_LIGHT_LEVEL((*ti).t) > 0)
-        screen->drawalphamap8globe((*ti).x, (*ti).y, GET_TILE_LIGHT_LEVEL((*ti).t));
+      {
+        globe.x = (*ti).x;
+        globe.y = (*ti).y;
+        globe.light = GET_TILE_LIGHT_LEVEL((*ti).t);
+        globes.push_back(globe);
+      }
     }
   }
 
-  /* draw light coming from the actor
+  /* light coming from the actors
      Wisps can change the light level depending on their current tile so we can't use actor->light for an actor's innate lighting.
   */
-  Actor *actor;
-
-  for(uint16 i=0;i < 256;i++)
+  // the area wraps around the map edge like tmp_map_buf does, so offsets
+  // from its corner are wrapped too
+  ActorList *actors = actor_manager->get_actors_in_area(WRAPPED_COORD(cur_x - TMP_MAP_BORDER, cur_level),
+                                                        WRAPPED_COORD(cur_y - TMP_MAP_BORDER, cur_level),
+                                                        tmp_map_width, tmp_map_height, cur_level);
+  for(ActorIterator a = actors->begin(); a != actors->end(); a++)
     {
-     actor = actor_manager->get_actor(i);
-
-     if(actor->z == cur_level)
+     Actor *actor = *a;
+     sint32 buf_x = WRAPPED_COORD(actor->x - cur_x + TMP_MAP_BORDER, cur_level);
+     sint32 buf_y = WRAPPED_COORD(actor->y - cur_y + TMP_MAP_BORDER, cur_level);
+     sint32 rel_x = buf_x - TMP_MAP_BORDER;
+     sint32 rel_y = buf_y - TMP_MAP_BORDER;
+     if(buf_x < tmp_map_width && buf_y < tmp_map_height && tmp_map_buf[buf_y * tmp_map_width + buf_x] != 0)
        {
-        sint32 rel_x = (sint32)actor->x - (sint32)cur_x;
-        sint32 rel_y = (sint32)actor->y - (sint32)cur_y;
-        if(rel_x >= -TMP_MAP_BORDER && rel_x < (sint32)win_width + TMP_MAP_BORDER)
+        uint8 light = actor->get_light_level();
+        if(light > 0)
           {
-           if(rel_y >= -TMP_MAP_BORDER && rel_y < (sint32)win_height + TMP_MAP_BORDER)
-             {
-              uint32 buf_idx = (rel_y + TMP_MAP_BORDER) * tmp_map_width + (rel_x + TMP_MAP_BORDER);
-              if(buf_idx < tmp_map_width * tmp_map_height && tmp_map_buf[buf_idx] != 0)
-                {
-                 uint8 light = actor->get_light_level();
-                 if(light > 0)
-                 {
-                   screen->drawalphamap8globe(rel_x, rel_y, light);
-                 }
-                }
-             }
+           globe.x = rel_x;
+           globe.y = rel_y;
+           globe.light = light;
+           globes.push_back(globe);
           }
        }
     }
+  delete actors;
+
+  std::sort(globes.begin(), globes.end(), light_before);
+}
+
+/* Bring the shading map from light_globes to globes by clearing and redrawing
+ * only the areas of globes that went away or appeared. Globes add up with
+ * saturation, so an area can be redrawn in any order. Returns false if a full
+ * rebuild would be cheaper.
+ */
+bool MapWindow::updateLightingPartial(std::vector<MapWindowLight> &globes)
+{
+  std::vector<SDL_Rect> dirty;
+  std::vector<MapWindowLight>::iterator o = light_globes.begin();
+  std::vector<MapWindowLight>::iterator n = globes.begin();
+  SDL_Rect rect;
+
+  while(o != light_globes.end() || n != globes.end())
+  {
+    if(n == globes.end() || (o != light_globes.end() && light_before(*o, *n)))
+    {
+      if(screen->get_alphamap8globe_rect((*o).x, (*o).y, (*o).light, &rect))
+        dirty.push_back(rect); // went away
+      o++;
+    }
+    else if(o == light_globes.end() || light_before(*n, *o))
+    {
+      if(screen->get_alphamap8globe_rect((*n).x, (*n).y, (*n).light, &rect))
+        dirty.push_back(rect); // appeared
+      n++;
+    }
+    else
+    {
+      o++;
+      n++;
+    }
+
+    if(dirty.size() > MAPWINDOW_LIGHT_MAX_DIRTY)
+      return false;
+  }
+
+  for(std::vector<SDL_Rect>::iterator d = dirty.begin(); d != dirty.end(); d++)
+  {
+    screen->resetalphamap8(&(*d));
+    for(std::vector<MapWindowLight>::iterator g = globes.begin(); g != globes.end(); g++)
+      screen->drawalphamap8globe((*g).x, (*g).y, (*g).light, &(*d));
+  }
+
+  light_globes.swap(globes);
+  return true;
+}
+
+void MapWindow::updateLighting()
+{
+  getLightGlobes(light_globes);
+
+  for(std::vector<MapWindowLight>::iterator g = light_globes.begin(); g != light_globes.end(); g++)
+    screen->drawalphamap8globe((*g).x, (*g).y, (*g).light);
 }
 
 void MapWindow::updateBlacking()
@@ -1184,11 +1356,9 @@ void MapWindow::updateBlacking()
 
  updateAmbience();
 
- m_ViewableObjects.clear();
 /// m_ViewableObjTiles.clear();
 
- draw_brit_lens_anim = false;
- draw_garg_lens_anim = false;
+ buildDrawList(); // also refills m_ViewableObjects
 
  window_updated = true;
 }
@@ -1248,25 +1418,11 @@ void MapWindow::Display(bool full_redraw)
          if(tile_val >= 16 && tile_val < 48) //lay down the base tile for shoreline tiles
            {
             tile = tile_manager->get_anim_base_tile(tile_val);
-            if(map_tile_scale == 4)
-              screen->blit4x(draw_x,draw_y,(unsigned char *)tile->data,8,16,16,16,tile->transparent,&clip_rect);
-            else if(map_tile_scale == 3)
-              screen->blit3x(draw_x,draw_y,(unsigned char *)tile->data,8,16,16,16,tile->transparent,&clip_rect);
-            else if(map_tile_scale == 2)
-              screen->blit2x(draw_x,draw_y,(unsigned char *)tile->data,8,16,16,16,tile->transparent,&clip_rect);
-            else
-              screen->blit(draw_x,draw_y,(unsigned char *)tile->data,8,16,16,16,tile->transparent,&clip_rect);
+            blitTileAtScreen(tile, draw_x, draw_y);
            }
 
          tile = tile_manager->get_tile(tile_val);
-         if(map_tile_scale == 4)
-           screen->blit4x(draw_x,draw_y,(unsigned char *)tile->data,8,16,16,16,tile->transparent,&clip_rect);
-         else if(map_tile_scale == 3)
-           screen->blit3x(draw_x,draw_y,(unsigned char *)tile->data,8,16,16,16,tile->transparent,&clip_rect);
-         else if(map_tile_scale == 2)
-           screen->blit2x(draw_x,draw_y,(unsigned char *)tile->data,8,16,16,16,tile->transparent,&clip_rect);
-         else
-           screen->blit(draw_x,draw_y,(unsigned char *)tile->data,8,16,16,16,tile->transparent,&clip_rect);
+         blitTileAtScreen(tile, draw_x, draw_y);
 
         }
 
@@ -1502,16 +1658,17 @@ inline void MapWindow::drawActor(Actor *actor)
 
 void MapWindow::drawObjs()
 {
- //FIX we need to make this more efficent.
+ if(!drawListIsValid())
+   buildDrawList();
 
- drawObjSuperBlock(true,false); //draw force lower objects
- drawObjSuperBlock(false,false); //draw lower objects
+ drawObjList(draw_list_force_lower, false); //draw force lower objects
+ drawObjList(draw_list_lower, false); //draw lower objects
 
  drawActors();
 
  drawAnims(false);
 
- drawObjSuperBlock(false,true); //draw top objects
+ drawObjList(draw_list_top, true); //draw top objects
 
  drawLensAnim();
  return;
@@ -1536,7 +1693,12 @@ inline void MapWindow::drawLensAnim()
 	}
 }
 
-void MapWindow::drawObjSuperBlock(bool draw_lowertiles, bool toptile)
+/* Sort every obj in view into the force lower, lower and top passes. Objs are
+ * visited from the bottom right of the window to the top left so they overlap
+ * correctly. The list is rebuilt when the blacking is updated and whenever
+ * drawListIsValid() notices a change, and replayed by drawObjs() otherwise.
+ */
+void MapWindow::buildDrawList()
 {
  U6Link *link;
  U6LList *obj_list;
@@ -1544,6 +1706,26 @@ void MapWindow::drawObjSuperBlock(bool draw_lowertiles, bool toptile)
  sint16 x,y;
  uint16 stop_x, stop_y;
 
+ draw_list.clear();
+ draw_list_force_lower.clear();
+ draw_list_lower.clear();
+ draw_list_top.clear();
+ m_ViewableObjects.clear();
+
+ draw_brit_lens_anim = false;
+ draw_garg_lens_anim = false;
+
+ draw_list_dirty = false;
+ draw_list_map_changes = obj_manager->get_map_change_count();
+ draw_list_x = cur_x;
+ draw_list_y = cur_y;
+ draw_list_level = cur_level;
+ draw_list_width = win_width;
+ draw_list_height = win_height;
+
+ if(tmp_map_buf == NULL)
+   return;
+
  if(cur_x < 0)
    stop_x = 0;
  else
@@ -1559,70 +1741,109 @@ void MapWindow::drawObjSuperBlock(bool draw_lowertiles, bool toptile)
        for(x=cur_x+win_width;x >= stop_x; x--)
          {
           obj_list =obj_manager->get_obj_list(x,y,cur_level);
-          if(obj_list)
-           {
-            for(link=obj_list->start();link != NULL;link=link->next)
-              {
-               obj = (Obj *)link->data;
-               drawObj(obj, draw_lowertiles, toptile);
-              }
-           }
-         }
-      }
+          if(obj_list == NULL)
+            continue;
 
-}
+          for(link=obj_list->start();link != NULL;link=link->next)
+            {
+             obj = (Obj *)link->data;
 
-inline void MapWindow::drawObj(Obj *obj, bool draw_lowertiles, bool toptile)
-{
- sint16 x,y;
- Tile *tile;
+             sint16 view_x = WRAP_VIEWP(cur_x, obj->x, map_width);
+             sint16 view_y = obj->y - cur_y;
+             if(view_x < 0 || view_y < 0)
+               continue;
 
- y = obj->y - cur_y;
- x = WRAP_VIEWP(cur_x, obj->x, map_width);
+             m_ViewableObjects.push_back(obj);
 
- if(x < 0 || y < 0)
-   return;
+             uint16 tmp_map_pos = (view_y+TMP_MAP_BORDER)*tmp_map_width+(view_x+TMP_MAP_BORDER);
 
- if(window_updated)
- {
-   m_ViewableObjects.push_back(obj);
+             if(game_type == NUVIE_GAME_U6 && cur_level == 0 && obj->y == 0x353 && tmp_map_buf[tmp_map_pos] != 0)
+               {
+                if(obj->obj_n == 394 && obj->x == 0x399)
+                  draw_brit_lens_anim = true;
+                else if(obj->obj_n == 396 && obj->x == 0x39d)
+                  draw_garg_lens_anim = true;
+               }
 
-   if(game_type == NUVIE_GAME_U6 && cur_level == 0 && obj->y == 0x353 && tmp_map_buf[(y+TMP_MAP_BORDER)*tmp_map_width+(x+TMP_MAP_BORDER)] != 0)
-   {
-	   if(obj->obj_n == 394 && obj->x == 0x399)
-	   {
-		   draw_brit_lens_anim = true;
-	   }
-	   else if(obj->obj_n == 396 && obj->x == 0x39d)
-	   {
-		   draw_garg_lens_anim = true;
-	   }
-   }
- }
+             MapWindowDrawObj draw_obj;
+             draw_obj.obj = obj;
+             draw_obj.tile = tile_manager->get_original_tile(obj_manager->get_obj_tile_num(obj)+obj->frame_n);
+             draw_obj.obj_n = obj->obj_n;
+             draw_obj.obj_x = obj->x;
+             draw_obj.obj_y = obj->y;
+             draw_obj.frame_n = obj->frame_n;
+             draw_obj.status = obj->status;
+             draw_obj.x = view_x;
+             draw_obj.y = view_y;
+             draw_obj.multitile_corpse = false;
+             draw_list.push_back(draw_obj); // kept even if hidden, so changes to it are noticed
+
+             //don't show invisible objects.
+             if(obj->status & OBJ_STATUS_INVISIBLE)
+               continue;
+
+             Tile *tile = draw_obj.tile;
+
+             if(tmp_map_buf[tmp_map_pos] == 0) //don't draw object if area is in darkness.
+               continue;
+
+             // We don't show objects on walls if the area to the right or bottom of the wall is in darkness
+             if(tmp_map_buf[tmp_map_pos+1] == 0 || tmp_map_buf[tmp_map_pos+tmp_map_width] == 0)
+               {
+                if((!(tile->flags1 & TILEFLAG_WALL) || (game_type == NUVIE_GAME_U6 && obj->obj_n == OBJ_U6_BARS)))
+                  continue;
+               }
 
- //don't show invisible objects.
- if(obj->status & OBJ_STATUS_INVISIBLE)
-    return;
+             uint32 i = draw_list.size() - 1;
 
- tile = tile_manager->get_original_tile(obj_manager->get_obj_tile_num(obj)+obj->frame_n);
+             // Check if this is a multi-tile corpse
+             draw_list[i].multitile_corpse = (tile->dbl_width || tile->dbl_height) && obj_manager->is_corpse(obj);
 
- if(draw_lowertiles == false && (tile->flags3 & 0x4) && toptile == false) //don't display force lower tiles.
-   return;
+             if(tile->flags3 & 0x4)
+               draw_list_force_lower.push_back(i);
+             else
+               draw_list_lower.push_back(i);
 
- if(draw_lowertiles == true && !(tile->flags3 & 0x4))
-   return;
+             // Multi-tile corpses are only drawn in the background passes
+             if(!draw_list[i].multitile_corpse)
+               draw_list_top.push_back(i);
+            }
+         }
+      }
 
- if(tmp_map_buf[(y+TMP_MAP_BORDER)*tmp_map_width+(x+TMP_MAP_BORDER)] == 0) //don't draw object if area is in darkness.
-    return;
- else
-    {
-     // We don't show objects on walls if the area to the right or bottom of the wall is in darkness
-     if(tmp_map_buf[(y+TMP_MAP_BORDER)*tmp_map_width+(x+TMP_MAP_BORDER+1)] == 0 || tmp_map_buf[(y+TMP_MAP_BORDER+1)*tmp_map_width+(x+TMP_MAP_BORDER)] == 0)
-     {
-      if((!(tile->flags1 & TILEFLAG_WALL) || (game_type == NUVIE_GAME_U6 && obj->obj_n == OBJ_U6_BARS)))
-        return;
-     }
-    }
+}
+
+/* Returns false if the view moved or an obj in it was added, removed or
+ * changed since buildDrawList().
+ */
+bool MapWindow::drawListIsValid()
+{
+ if(draw_list_dirty || draw_list_map_changes != obj_manager->get_map_change_count()
+    || draw_list_x != cur_x || draw_list_y != cur_y || draw_list_level != cur_level
+    || draw_list_width != win_width || draw_list_height != win_height)
+   return false;
+
+ for(std::vector<MapWindowDrawObj>::iterator i = draw_list.begin(); i != draw_list.end(); i++)
+  {
+   Obj *obj = (*i).obj;
+   if(obj->obj_n != (*i).obj_n || obj->frame_n != (*i).frame_n || obj->status != (*i).status
+      || obj->x != (*i).obj_x || obj->y != (*i).obj_y)
+     return false;
+  }
+
+ return true;
+}
+
+void MapWindow::drawObjList(std::vector<uint32> &list, bool toptile)
+{
+ for(std::vector<uint32>::iterator i = list.begin(); i != list.end(); i++)
+   drawObj(&draw_list[*i], toptile);
+}
+
+inline void MapWindow::drawObj(MapWindowDrawObj *draw_obj, bool toptile)
+{
+ Obj *obj = draw_obj->obj;
+ Tile *tile = draw_obj->tile;
 
   // Check if this is a surrounding object of a multi-tile actor in smooth movement
   if(obj->is_actor_obj() && smooth_movement)
@@ -1646,19 +1867,9 @@ inline void MapWindow::drawObj(Obj *obj, bool draw_lowertiles, bool toptile)
       }
   }
 
-  // Check if this is a multi-tile corpse
-  bool is_multitile_corpse = (tile->dbl_width || tile->dbl_height) && obj_manager->is_corpse(obj);
-
-  // For multi-tile corpses in toptile pass, skip entirely (don't draw base or extensions)
-  // They should only be drawn in non-toptile (background) pass
-  if(toptile && is_multitile_corpse)
-  {
-      return;
-  }
-
   // For multi-tile corpses, force draw all tiles regardless of toptile flag
   // This ensures the corpse is fully visible even if some tiles have toptile=true
-  drawTile(tile, x, obj->y - cur_y, toptile, false, false, is_multitile_corpse, is_multitile_corpse);
+  drawTile(tile, draw_obj->x, draw_obj->y, toptile, false, false, draw_obj->multitile_corpse, draw_obj->multitile_corpse);
 
 }
 
@@ -1797,36 +2008,28 @@ inline void MapWindow::drawTopTile(Tile *tile, uint16 x, uint16 y, bool toptile)
  if(toptile)
     {
      if(tile->toptile)
-       {
-        if(map_tile_scale == 4)
-          screen->blit4x(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
-        else if(map_tile_scale == 3)
-          screen->blit3x(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
-        else if(map_tile_scale == 2)
-          screen->blit2x(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
-        else
-          screen->blit(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
-       }
+        blitTileAtScreen(tile, draw_x, draw_y);
     }
  else
     {
      if(!tile->toptile)
-       {
-        if(map_tile_scale == 4)
-          screen->blit4x(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
-        else if(map_tile_scale == 3)
-          screen->blit3x(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
-        else if(map_tile_scale == 2)
-          screen->blit2x(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
-        else
-          screen->blit(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
-       }
+        blitTileAtScreen(tile, draw_x, draw_y);
     }
 }
 
 // Helper to blit a single tile at screen coordinates
 inline void MapWindow::blitTileAtScreen(Tile *tile, sint16 draw_x, sint16 draw_y)
 {
+    if(map_tile_scale > 1)
+    {
+        const ScaledTile *scaled = tile_manager->get_scaled_tile(tile, map_tile_scale);
+        if(scaled)
+        {
+            screen->blit_scaled_tile(draw_x, draw_y, scaled->pixels, scaled->scale, scaled->spans, scaled->num_spans, &clip_rect);
+            return;
+        }
+    }
+
     if(map_tile_scale == 4)
         screen->blit4x(draw_x,draw_y,tile->data,8,16,16,16,tile->transparent,&clip_rect);
     else if(map_tile_scale == 3)
@@ -3686,7 +3889,32 @@ static uint32 get_tile_region_color(Tile *tile, unsigned char *palette, int star
     return 0xFF000000 | (r << 16) | (g << 8) | b;
 }
 
-SDL_Surface *MapWindow::generate_world_map(uint8 scale)
+#define WORLD_MAP_BAND_ROWS 16 // tile rows per unit of work
+#define WORLD_MAP_MAX_THREADS 8
+#define WORLD_MAP_HASH_VERSION 1 // bump when the look of the world map changes
+
+// Average colour of one region of a tile, see get_tile_region_color()
+typedef struct
+{
+    uint32 color;
+    uint16 valid_pixels;
+} WorldMapRegionColor;
+
+typedef struct
+{
+    Map *map;
+    ObjManager *obj_manager;
+    unsigned char *palette;
+    const WorldMapRegionColor *region_colors; // scale * scale regions per original tile
+    uint8 scale;
+    uint32 *pixels;
+    int pitch;
+    std::vector<uint16> bands; // superchunk * bands per superchunk + band
+    uint16 num_workers;
+    uint16 worker;
+} WorldMapJob;
+
+static uint8 get_world_map_scale(uint8 scale)
 {
     // Supported scales: 1, 2, 4, 8
     if(scale < 1) scale = 1;
@@ -3696,79 +3924,273 @@ SDL_Surface *MapWindow::generate_world_map(uint8 scale)
     if(scale >= 5 && scale <= 6) scale = 4;
     if(scale == 7) scale = 8;
 
-    uint16 map_size = 1024; // Britannia surface map is 1024x1024 tiles
-    uint32 img_size = map_size * scale;
+    return scale;
+}
 
-    // Load palette
-    unsigned char palette[256 * 4];
-    Game::get_game()->get_palette()->loadPaletteIntoBuffer(palette);
+// Averages of every region of every original tile, so the map walk doesn't
+// go over the same tile pixels again for each of the million map tiles.
+static void build_tile_region_colors(WorldMapRegionColor *region_colors, TileManager *tile_manager, unsigned char *palette, uint8 scale)
+{
+    int region_size = 16 / scale;
 
-    // Create 32-bit ARGB surface
-    SDL_Surface *world_map = SDL_CreateRGBSurface(0, img_size, img_size, 32,
-        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    for(uint16 i = 0; i < NUM_ORIGINAL_TILES; i++)
+    {
+        Tile *tile = tile_manager->get_original_tile(i);
 
-    if(!world_map)
+        for(int ry = 0; ry < scale; ry++)
+        {
+            for(int rx = 0; rx < scale; rx++)
+            {
+                WorldMapRegionColor *region_color = &region_colors[(i * scale + ry) * scale + rx];
+                uint32 r_sum = 0, g_sum = 0, b_sum = 0;
+                uint16 valid_pixels = 0;
+
+                for(int py = ry * region_size; py < (ry + 1) * region_size; py++)
+                {
+                    for(int px = rx * region_size; px < (rx + 1) * region_size; px++)
+                    {
+                        uint8 idx = tile->data[py * 16 + px];
+                        if(idx == 255 || idx == 0)
+                            continue;
+
+                        r_sum += palette[idx * 4];
+                        g_sum += palette[idx * 4 + 1];
+                        b_sum += palette[idx * 4 + 2];
+                        valid_pixels++;
+                    }
+                }
+
+                region_color->valid_pixels = valid_pixels;
+                region_color->color = 0xFF000000;
+                if(valid_pixels)
+                    region_color->color |= ((r_sum / valid_pixels) << 16) | ((g_sum / valid_pixels) << 8) | (b_sum / valid_pixels);
+            }
+        }
+    }
+}
+
+// Same result as get_tile_region_color() but from the precomputed averages.
+static inline uint32 get_world_map_region_color(const WorldMapJob *job, Tile *tile, int region, unsigned char *palette, uint32 fallback_color = 0xFF000000)
+{
+    if(!tile)
+        return fallback_color;
+
+    if(tile->tile_num >= NUM_ORIGINAL_TILES)
     {
-        DEBUG(0, LEVEL_ERROR, "Failed to create world map surface\n");
-        return NULL;
+        int region_size = 16 / job->scale;
+        return get_tile_region_color(tile, palette, (region % job->scale) * region_size, (region / job->scale) * region_size, region_size, fallback_color);
     }
 
-    SDL_LockSurface(world_map);
-    uint32 *pixels = (uint32 *)world_map->pixels;
-    int pitch = world_map->pitch / 4; // pitch in uint32 units
-
-    // Calculate region size based on scale
-    // scale 1: 16x16 (whole tile) -> 1 pixel
-    // scale 2: 8x8 regions -> 4 pixels
-    // scale 4: 4x4 regions -> 16 pixels
-    // scale 8: 2x2 regions -> 64 pixels
-    int region_size = 16 / scale;
+    if(tile->water)
+        return 0xFF0040A0; // deep blue water color
+
+    const WorldMapRegionColor *region_color = &job->region_colors[tile->tile_num * job->scale * job->scale + region];
+    if(region_color->valid_pixels == 0)
+        return fallback_color;
+
+    int total_pixels = (16 / job->scale) * (16 / job->scale);
+    if(region_color->valid_pixels < total_pixels / 4 && fallback_color != 0xFF000000)
+    {
+        // 50% blend with the base tile colour
+        uint8 r = (((region_color->color >> 16) & 0xFF) + ((fallback_color >> 16) & 0xFF)) / 2;
+        uint8 g = (((region_color->color >> 8) & 0xFF) + ((fallback_color >> 8) & 0xFF)) / 2;
+        uint8 b = ((region_color->color & 0xFF) + (fallback_color & 0xFF)) / 2;
 
-    // Generate map for surface level (z=0)
-    for(uint16 y = 0; y < map_size; y++)
+        return 0xFF000000 | (r << 16) | (g << 8) | b;
+    }
+
+    return region_color->color;
+}
+
+static void render_world_map_band(WorldMapJob *job, uint16 band)
+{
+    uint16 bands_per_superchunk = WORLD_MAP_SUPERCHUNK_SIDE / WORLD_MAP_BAND_ROWS;
+    uint16 superchunk = band / bands_per_superchunk;
+    uint16 x0 = (superchunk % 8) * WORLD_MAP_SUPERCHUNK_SIDE;
+    uint16 y0 = (superchunk / 8) * WORLD_MAP_SUPERCHUNK_SIDE + (band % bands_per_superchunk) * WORLD_MAP_BAND_ROWS;
+    uint8 scale = job->scale;
+
+    for(uint16 y = y0; y < y0 + WORLD_MAP_BAND_ROWS; y++)
     {
-        for(uint16 x = 0; x < map_size; x++)
+        for(uint16 x = x0; x < x0 + WORLD_MAP_SUPERCHUNK_SIDE; x++)
         {
             // Get base map tile
-            Tile *base_tile = map->get_tile(x, y, 0, true);
+            Tile *base_tile = job->map->get_tile(x, y, 0, true);
             // Get object tile at this location (bridges, etc.)
-            Tile *obj_tile = obj_manager->get_obj_tile(x, y, 0, true);
+            Tile *obj_tile = job->obj_manager->get_obj_tile(x, y, 0, true);
+            uint32 *row = &job->pixels[y * scale * job->pitch + x * scale];
 
-            // Fill pixels based on scale
             for(int sy = 0; sy < scale; sy++)
             {
                 for(int sx = 0; sx < scale; sx++)
                 {
-                    // First get base tile color
-                    uint32 base_color = get_tile_region_color(base_tile, palette,
-                        sx * region_size, sy * region_size, region_size);
-
-                    uint32 color;
+                    uint32 color = get_world_map_region_color(job, base_tile, sy * scale + sx, job->palette);
+                    // If there's an object, use its color with base as fallback
                     if(obj_tile != NULL)
-                    {
-                        // If there's an object, use its color with base as fallback
-                        color = get_tile_region_color(obj_tile, palette,
-                            sx * region_size, sy * region_size, region_size, base_color);
-                    }
-                    else
-                    {
-                        color = base_color;
-                    }
+                        color = get_world_map_region_color(job, obj_tile, sy * scale + sx, job->palette, color);
 
-                    uint32 px = x * scale + sx;
-                    uint32 py = y * scale + sy;
-                    pixels[py * pitch + px] = color;
+                    row[sy * job->pitch + sx] = color;
                 }
             }
         }
     }
+}
 
-    SDL_UnlockSurface(world_map);
+static int world_map_worker(void *data)
+{
+    WorldMapJob *job = (WorldMapJob *)data;
+
+    // Bands are dealt out round robin, neighbouring bands cost about the same
+    for(uint32 i = job->worker; i < job->bands.size(); i += job->num_workers)
+        render_world_map_band(job, job->bands[i]);
+
+    return 0;
+}
+
+SDL_Surface *MapWindow::generate_world_map(uint8 scale)
+{
+    scale = get_world_map_scale(scale);
+
+    uint16 map_size = 1024; // Britannia surface map is 1024x1024 tiles
+    uint32 img_size = map_size * scale;
+
+    // Create 32-bit ARGB surface
+    SDL_Surface *world_map = SDL_CreateRGBSurface(0, img_size, img_size, 32,
+        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+
+    if(!world_map)
+    {
+        DEBUG(0, LEVEL_ERROR, "Failed to create world map surface\n");
+        return NULL;
+    }
+
+    if(!update_world_map(world_map, scale))
+    {
+        SDL_FreeSurface(world_map);
+        return NULL;
+    }
 
     DEBUG(0, LEVEL_INFORMATIONAL, "Generated world map: %dx%d (scale=%d)\n", img_size, img_size, scale);
     return world_map;
 }
 
+bool MapWindow::update_world_map(SDL_Surface *world_map, uint8 scale, const bool *dirty)
+{
+    if(world_map == NULL || get_world_map_scale(scale) != scale || world_map->w != 1024 * scale || world_map->h != 1024 * scale
+        || world_map->format->BytesPerPixel != 4 || world_map->format->Rmask != 0x00FF0000)
+    {
+        DEBUG(0, LEVEL_ERROR, "update_world_map: surface doesn't match scale %d\n", scale);
+        return false;
+    }
+
+    uint32 start_time = SDL_GetTicks();
+
+    // Load palette
+    unsigned char palette[256 * 4];
+    Game::get_game()->get_palette()->loadPaletteIntoBuffer(palette);
+
+    std::vector<WorldMapRegionColor> region_colors(NUM_ORIGINAL_TILES * scale * scale);
+    build_tile_region_colors(&region_colors[0], tile_manager, palette, scale);
+
+    WorldMapJob job;
+    job.map = map;
+    job.obj_manager = obj_manager;
+    job.palette = palette;
+    job.region_colors = &region_colors[0];
+    job.scale = scale;
+    job.num_workers = 1;
+    job.worker = 0;
+
+    uint16 bands_per_superchunk = WORLD_MAP_SUPERCHUNK_SIDE / WORLD_MAP_BAND_ROWS;
+    for(uint16 i = 0; i < WORLD_MAP_NUM_SUPERCHUNKS; i++)
+    {
+        if(dirty == NULL || dirty[i])
+        {
+            for(uint16 j = 0; j < bands_per_superchunk; j++)
+                job.bands.push_back(i * bands_per_superchunk + j);
+        }
+    }
+    if(job.bands.empty())
+        return true;
+
+    SDL_LockSurface(world_map);
+    job.pixels = (uint32 *)world_map->pixels;
+    job.pitch = world_map->pitch / 4; // pitch in uint32 units
+
+    // The map and objects are only read while the workers run and this
+    // thread waits for them, so they need no locking.
+    uint16 num_workers = (uint16)clamp(SDL_GetCPUCount(), 1, WORLD_MAP_MAX_THREADS);
+    std::vector<WorldMapJob> jobs(num_workers, job);
+    std::vector<SDL_Thread *> threads;
+
+    for(uint16 i = 0; i < num_workers; i++)
+    {
+        jobs[i].num_workers = num_workers;
+        jobs[i].worker = i;
+    }
+    for(uint16 i = 1; i < num_workers; i++)
+    {
+        SDL_Thread *thread = SDL_CreateThread(world_map_worker, "World Map", &jobs[i]);
+        if(thread == NULL)
+            world_map_worker(&jobs[i]);
+        else
+            threads.push_back(thread);
+    }
+    world_map_worker(&jobs[0]);
+    for(uint16 i = 0; i < threads.size(); i++)
+        SDL_WaitThread(threads[i], NULL);
+
+    SDL_UnlockSurface(world_map);
+
+    DEBUG(0, LEVEL_INFORMATIONAL, "Drew %d world map superchunks with %d threads in %d ms\n",
+        (int)(job.bands.size() / bands_per_superchunk), num_workers, SDL_GetTicks() - start_time);
+    return true;
+}
+
+void MapWindow::get_world_map_hashes(uint32 hashes[WORLD_MAP_NUM_SUPERCHUNKS])
+{
+    unsigned char palette[256 * 4];
+    unsigned char *map_data = map->get_map_data(0);
+    uint32 palette_hash = 2166136261U ^ WORLD_MAP_HASH_VERSION;
+
+    Game::get_game()->get_palette()->loadPaletteIntoBuffer(palette);
+    for(int i = 0; i < 256 * 4; i++)
+        palette_hash = (palette_hash ^ palette[i]) * 16777619U;
+
+    for(uint16 i = 0; i < WORLD_MAP_NUM_SUPERCHUNKS; i++)
+    {
+        uint16 x0 = (i % 8) * WORLD_MAP_SUPERCHUNK_SIDE;
+        uint16 y0 = (i / 8) * WORLD_MAP_SUPERCHUNK_SIDE;
+        uint32 hash = palette_hash;
+
+        // FNV-1a over the map tiles and the objects on them. Objects one tile
+        // past the edge are included, as double width or height ones reach back.
+        for(uint16 y = y0; y <= y0 + WORLD_MAP_SUPERCHUNK_SIDE; y++)
+        {
+            for(uint16 x = x0; x <= x0 + WORLD_MAP_SUPERCHUNK_SIDE; x++)
+            {
+                if(x < x0 + WORLD_MAP_SUPERCHUNK_SIDE && y < y0 + WORLD_MAP_SUPERCHUNK_SIDE)
+                    hash = (hash ^ map_data[y * 1024 + x]) * 16777619U;
+
+                U6LList *obj_list = obj_manager->get_obj_list(x, y, 0);
+                if(obj_list == NULL)
+                    continue;
+
+                for(U6Link *link = obj_list->start(); link != NULL; link = link->next)
+                {
+                    Obj *obj = (Obj *)link->data;
+                    hash = (hash ^ (obj->obj_n & 0xff)) * 16777619U;
+                    hash = (hash ^ (obj->obj_n >> 8)) * 16777619U;
+                    hash = (hash ^ obj->frame_n) * 16777619U;
+                }
+                hash = (hash ^ 0xff) * 16777619U; // end of tile
+            }
+        }
+
+        hashes[i] = hash;
+    }
+}
+
 bool MapWindow::save_world_map_bmp(const char *filename, uint8 scale)
 {
     SDL_Surface *world_map = generate_world_map(scale);
@@ -52,11 +52,38 @@ class Game;
 #define MAPWINDOW_ROOFTILES_IMG_W 5
 #define MAPWINDOW_ROOFTILES_IMG_H 204
 
+#define MAPWINDOW_LIGHT_MAX_DIRTY 16 // changed light globes redrawn before a full rebuild is cheaper
+
 typedef struct {
 	Tile *t;
 	uint16 x,y;
 } TileInfo;
 
+// An obj in view as sorted by MapWindow::buildDrawList(). obj_n, frame_n,
+// status and the obj location are kept to notice changes made to the obj.
+typedef struct {
+	Obj *obj;
+	Tile *tile; // original tile of obj_n + frame_n
+	uint16 obj_n;
+	uint16 obj_x, obj_y;
+	uint8 frame_n;
+	uint8 status;
+	uint16 x,y; // location in the window
+	bool multitile_corpse;
+} MapWindowDrawObj;
+
+// A light globe in Screen's shading map, in window tile coords.
+typedef struct {
+	sint16 x,y;
+	uint8 light;
+} MapWindowLight;
+
+// An obj on a visible tile that might give off light.
+typedef struct {
+	Obj *obj;
+	uint16 x,y; // location in the tmp map
+} MapWindowLightSource;
+
 typedef struct {
 	Tile *eye_tile;
 	uint16 prev_x, prev_y;
@@ -69,6 +96,9 @@ enum InterfaceType { INTERFACE_NORMAL, INTERFACE_FULLSCREEN, INTERFACE_IGNORE_BL
 enum X_RayType { X_RAY_CHEAT_OFF = -1,  X_RAY_OFF = 0, X_RAY_ON = 1, X_RAY_CHEAT_ON = 2};
 enum CanDropOrMoveMsg { MSG_NOT_POSSIBLE, MSG_SUCCESS, MSG_BLOCKED, MSG_OUT_OF_RANGE, MSG_NO_TILE};
 
+#define WORLD_MAP_SUPERCHUNK_SIDE 128 // in tiles
+#define WORLD_MAP_NUM_SUPERCHUNKS 64  // the 1024x1024 surface is 8x8 superchunks
+
 class MapWindow: public GUI_Widget
 {
  friend class AnimManager;
@@ -143,11 +173,34 @@ SDL_Rect paper_clip_rect;
 
  bool draw_brit_lens_anim;
  bool draw_garg_lens_anim;
+
+ std::vector<MapWindowDrawObj> draw_list; // every obj in view, in drawing order
+ std::vector<uint32> draw_list_force_lower, draw_list_lower, draw_list_top; // draw_list indices for each pass
+ bool draw_list_dirty;
+ uint32 draw_list_map_changes;
+ sint16 draw_list_x, draw_list_y;
+ uint8 draw_list_level;
+ uint16 draw_list_width, draw_list_height;
 // std::vector<TileInfo> m_ViewableObjTiles; // shouldn't need this for in_town checks
  std::vector<TileInfo> m_ViewableMapTiles;
 
  bool lighting_update_required;
 
+ std::vector<MapWindowLightSource> light_sources; // rescanned when the view, the tmp map or the map objs change
+ std::vector<uint16> light_sources_tmp_map; // tmp_map_buf when light_sources was built
+ uint32 light_sources_map_changes;
+ sint16 light_sources_x, light_sources_y;
+ uint8 light_sources_level;
+ std::vector<MapWindowLight> light_globes; // globes in the shading map, sorted
+ bool light_map_valid; // the shading map was built for light_globes and the values below
+ sint16 light_map_x, light_map_y;
+ uint8 light_map_level;
+ uint8 light_map_ambient;
+ bool light_map_party_light;
+ int light_map_style;
+ uint8 light_map_scale;
+ uint16 light_map_width, light_map_height;
+
  uint8 map_tile_scale; // 1, 2, or 4 for map tile rendering scale
 
  // Smooth movement settings
@@ -297,6 +350,10 @@ SDL_Rect paper_clip_rect;
  // World map generation
  SDL_Surface *generate_world_map(uint8 scale = 1); // scale: 1 = 1024x1024, 2 = 2048x2048
  bool save_world_map_bmp(const char *filename, uint8 scale = 1);
+ // Redraw the superchunks of a generate_world_map() surface flagged in dirty, all of them when dirty is NULL
+ bool update_world_map(SDL_Surface *world_map, uint8 scale, const bool *dirty = NULL);
+ // A hash per surface superchunk of everything the world map shows there
+ void get_world_map_hashes(uint32 hashes[WORLD_MAP_NUM_SUPERCHUNKS]);
 
  std::vector<Obj *> m_ViewableObjects; //^^ dodgy public buffer
 
@@ -310,8 +367,10 @@ protected:
  void drawActors();
  void drawAnims(bool top_anims);
  void drawObjs();
- void drawObjSuperBlock(bool draw_lowertiles, bool toptile);
- inline void drawObj(Obj *obj, bool draw_lowertiles, bool toptile);
+ void buildDrawList();
+ bool drawListIsValid();
+ void drawObjList(std::vector<uint32> &list, bool toptile);
+ inline void drawObj(MapWindowDrawObj *draw_obj, bool toptile);
  inline void drawTile(Tile *tile, uint16 x, uint16 y, bool toptile, bool use_tile_data=false, bool skip_extension=false, bool force_draw_extensions=false, bool force_draw_base=false);
  inline void drawNewTile(Tile *tile, uint16 x, uint16 y, bool toptile);
  void drawBorder();
@@ -325,6 +384,9 @@ protected:
  inline void drawLensAnim();
 
  void updateLighting();
+ void updateLightSources();
+ void getLightGlobes(std::vector<MapWindowLight> &globes);
+ bool updateLightingPartial(std::vector<MapWindowLight> &globes);
  void generateTmpMap();
  void boundaryFill(unsigned char *map_ptr, uint16 pitch, uint16 x, uint16 y);
  bool floorTilesVisible();
@@ -93,6 +93,18 @@ MsgLine::~MsgLine()
   {
    delete *iter;
   }
+
+ clear_raster();
+}
+
+void MsgLine::clear_raster()
+{
+ if(raster)
+   {
+    free(raster);
+    raster = NULL;
+   }
+ raster_generation = 0;
 }
 
 void MsgLine::append(MsgText *new_text)
@@ -112,6 +124,7 @@ void MsgLine::append(MsgText *new_text)
   }
 
  total_length += new_text->s.length();
+ clear_raster();
 
  return;
 }
@@ -124,6 +137,7 @@ void MsgLine::remove_char()
  if(total_length == 0)
    return;
 
+ clear_raster();
  msg_text = text.back();
 
  // Remove last UTF-8 character (handles multi-byte chars like Korean)
@@ -241,6 +255,16 @@ void MsgScroll::init(Configuration *cfg, Font *f)
 	callback_target = NULL;
 	callback_user_data = NULL;
 
+	raster_generation = 1;
+	raster_font = NULL;
+	raster_bg_color = 0;
+	raster_highlight_color = 0;
+	raster_left_margin = 0;
+	raster_w = 0;
+	raster_h = 0;
+	raster_compact_ui = false;
+	raster_palette_version = 0;
+
 	scrollback_height = MSGSCROLL_SCROLLBACK_HEIGHT;
   capitalise_next_letter = false;
 
@@ -1498,17 +1522,23 @@ void MsgScroll::Display(bool full_redraw)
   {
    screen->fill(bg_color,area.x, area.y, area.w, area.h); //clear whole scroll
 
+   check_raster_settings(use_korean ? (Font *)korean_font : font, font_height, compact_ui);
+
+   // only lines in view keep a cached raster
    iter=msg_buf.begin();
-   for(i=0;i < display_pos; i++)
-	  iter++;
+   for(i=0;i < display_pos && iter != msg_buf.end(); i++,iter++)
+	  (*iter)->clear_raster();
 
    for(i=0;i< visible_lines && iter != msg_buf.end();i++,iter++)
      {
 	  msg_line = *iter;
-	  drawLine(screen, msg_line, i);
+	  drawLineCached(msg_line, i, font_height);
      }
    scroll_updated = false;
 
+   for(std::list<MsgLine *>::iterator it = iter; it != msg_buf.end(); it++)
+	  (*it)->clear_raster();
+
    screen->update(area.x,area.y, area.w, area.h);
 
    cursor_y = i-1;
@@ -1660,6 +1690,56 @@ inline void MsgScroll::drawLine(Screen *screen, MsgLine *msg_line, uint16 line_y
    }
 }
 
+// Draw a line from its cached raster, rendering and caching it first if the
+// text or the render settings changed since it was last drawn.
+void MsgScroll::drawLineCached(MsgLine *msg_line, uint16 line_y, uint16 line_h)
+{
+ SDL_Rect strip;
+ strip.x = area.x;
+ strip.y = area.y + line_y * line_h;
+ strip.w = area.w;
+ strip.h = line_h;
+
+ if(msg_line->raster && msg_line->raster_generation == raster_generation)
+   {
+    screen->restore_area(msg_line->raster, &strip, NULL, NULL, false);
+    return;
+   }
+
+ msg_line->clear_raster(); // strip size may have changed
+
+ // the strip has already been cleared to bg_color by Display()
+ drawLine(screen, msg_line, line_y);
+
+ if(strip.x + strip.w > screen->get_width() || strip.y + strip.h > screen->get_height())
+   return; // don't cache partially visible lines
+
+ msg_line->raster = screen->copy_area(&strip, (unsigned char *)NULL);
+ msg_line->raster_generation = raster_generation;
+}
+
+void MsgScroll::check_raster_settings(Font *line_font, uint16 line_h, bool compact_ui)
+{
+ if(line_font == raster_font && bg_color == raster_bg_color
+    && font_highlight_color == raster_highlight_color && left_margin == raster_left_margin
+    && area.w == raster_w && line_h == raster_h && compact_ui == raster_compact_ui
+    && screen->get_palette_version() == raster_palette_version)
+   return;
+
+ raster_font = line_font;
+ raster_bg_color = bg_color;
+ raster_highlight_color = font_highlight_color;
+ raster_left_margin = left_margin;
+ raster_w = area.w;
+ raster_h = line_h;
+ raster_compact_ui = compact_ui;
+ raster_palette_version = screen->get_palette_version();
+
+ raster_generation++;
+ if(raster_generation == 0) // 0 marks a line that has never been cached
+   raster_generation = 1;
+}
+
 void MsgScroll::clearCursor(uint16 x, uint16 y)
 {
  // Use appropriate size based on cursor scale
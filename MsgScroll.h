@@ -78,11 +78,16 @@ class MsgLine
  std::list<MsgText *> text;
  uint32 total_length;
 
- MsgLine() { total_length = 0; };
+ // cached rendering of this line in screen pixel format, see MsgScroll::drawLine()
+ unsigned char *raster;
+ uint32 raster_generation;
+
+ MsgLine() { total_length = 0; raster = NULL; raster_generation = 0; };
  ~MsgLine();
 
  void append(MsgText *new_text);
  void remove_char();
+ void clear_raster();
  uint32 length();
  MsgText *get_text_at_pos(uint16 pos);
  uint16 get_display_width();
@@ -164,6 +169,18 @@ private:
 
  bool capitalise_next_letter;
 
+ // settings the cached MsgLine rasters were drawn with. raster_generation is
+ // bumped whenever one of them changes, which invalidates every cached line.
+ uint32 raster_generation;
+ Font *raster_font;
+ uint8 raster_bg_color;
+ uint8 raster_highlight_color;
+ uint8 raster_left_margin;
+ uint16 raster_w;
+ uint16 raster_h;
+ bool raster_compact_ui;
+ uint32 raster_palette_version;
+
 
 
 
@@ -181,6 +198,9 @@ private:
   cursor_y = 0; line_count = 0; display_pos = 0; capitalise_next_letter = false;
   just_displayed_prompt = false; scrollback_height = MSGSCROLL_SCROLLBACK_HEIGHT;
   discard_whitespace = false; left_margin = 0;
+  raster_generation = 1; raster_font = NULL; raster_bg_color = 0;
+  raster_highlight_color = 0; raster_left_margin = 0; raster_w = 0;
+  raster_h = 0; raster_compact_ui = false; raster_palette_version = 0;
  }
  ~MsgScroll();
 
@@ -268,6 +288,8 @@ private:
  void delete_front_line();
  virtual MsgLine *add_new_line();
  void drawLine(Screen *screen, MsgLine *msg_line, uint16 line_y);
+ void drawLineCached(MsgLine *msg_line, uint16 line_y, uint16 line_h);
+ void check_raster_settings(Font *line_font, uint16 line_h, bool compact_ui);
  inline void clear_page_break();
 
  virtual void set_permitted_input(const char *allowed);
@@ -62,11 +62,13 @@ ObjManager::ObjManager(Configuration *cfg, TileManager *tm, EggManager *em)
  egg_manager = em;
  usecode = NULL;
  obj_save_count = 0;
+ map_change_count = 0;
 
  load_basetile();
  load_weight_table();
 
  memset(actor_inventories,0,sizeof(actor_inventories));
+ memset(obj_grid,0,sizeof(obj_grid));
 
  for(i=0;i<64;i++)
   {
@@ -120,6 +122,8 @@ ObjManager::~ObjManager()
  for(i=0;i<5;i++)
   iAVLFreeTree(dungeon[i], clean_obj_tree_node);
 
+ clean_obj_grid();
+
  for(uint16 i=0; i < 256; i++)
   {
    if(actor_inventories[i])
@@ -430,6 +434,8 @@ void ObjManager::clean()
  for(i=0;i<5;i++)
   iAVLCleanTree(dungeon[i], clean_obj_tree_node);
 
+ clean_obj_grid(); // the obj lists were deleted with the tree nodes
+
  clean_actor_inventories();
 
  // remove the temporary object list. The objects were deleted from the surface and dungeon trees.
@@ -1101,19 +1107,17 @@ bool ObjManager::has_toptile(Obj *obj)
 
 U6LList *ObjManager::get_obj_list(uint16 x, uint16 y, uint8 level)
 {
- iAVLTree *obj_tree;
- iAVLKey key;
- ObjTreeNode *item;
+ U6LList **page;
+
+ if(level > 5)
+   return NULL;
 
  WRAP_COORD(x,level); // wrap on map edge
  WRAP_COORD(y,level);
- 
- obj_tree = get_obj_tree(x,y,level);
- key = get_obj_tree_key(x,y,level);
 
- item = (ObjTreeNode *)iAVLSearch(obj_tree,key);
- if(item)
-  return item->obj_list;
+ page = obj_grid[get_obj_grid_page(x,y,level)];
+ if(page)
+  return page[(y & (OBJ_GRID_PAGE_SIDE - 1)) * OBJ_GRID_PAGE_SIDE + (x & (OBJ_GRID_PAGE_SIDE - 1))];
 
  return NULL;
 }
@@ -1400,7 +1404,8 @@ void ObjManager::remove_obj(Obj *obj)
   }
 
   obj->set_noloc();
-  
+  map_change_count++;
+
   return;
 }
 
@@ -1744,6 +1749,7 @@ bool ObjManager::add_obj(Obj *obj, bool addOnTop)
     node->obj_list = obj_list;
 
     iAVLInsert(obj_tree, node);
+    set_obj_grid_list(obj->x, obj->y, obj->z, obj_list);
    }
  else
    {
@@ -1759,6 +1765,7 @@ bool ObjManager::add_obj(Obj *obj, bool addOnTop)
    temp_obj_list_add(obj);
 
  obj->set_on_map(obj_list); //mark object as on map.
+ map_change_count++;
  
  return true;
 }
@@ -1864,6 +1871,48 @@ iAVLKey ObjManager::get_obj_tree_key(uint16 x, uint16 y, uint8 level)
    return y * 256 + x;
 }
 
+// x,y must already be wrapped and level must be <= 5.
+inline uint16 ObjManager::get_obj_grid_page(uint16 x, uint16 y, uint8 level)
+{
+ x >>= OBJ_GRID_PAGE_SHIFT;
+ y >>= OBJ_GRID_PAGE_SHIFT;
+
+ if(level == 0)
+   return y * (1024 >> OBJ_GRID_PAGE_SHIFT) + x;
+
+ return OBJ_GRID_SURFACE_PAGES + (level - 1) * OBJ_GRID_DUNGEON_PAGES + y * (256 >> OBJ_GRID_PAGE_SHIFT) + x;
+}
+
+void ObjManager::set_obj_grid_list(uint16 x, uint16 y, uint8 level, U6LList *obj_list)
+{
+ if(level > 5)
+   return;
+
+ WRAP_COORD(x,level);
+ WRAP_COORD(y,level);
+
+ U6LList **&page = obj_grid[get_obj_grid_page(x,y,level)];
+ if(page == NULL)
+  {
+   page = new U6LList *[OBJ_GRID_PAGE_SIDE * OBJ_GRID_PAGE_SIDE];
+   memset(page, 0, OBJ_GRID_PAGE_SIDE * OBJ_GRID_PAGE_SIDE * sizeof(U6LList *));
+  }
+
+ page[(y & (OBJ_GRID_PAGE_SIDE - 1)) * OBJ_GRID_PAGE_SIDE + (x & (OBJ_GRID_PAGE_SIDE - 1))] = obj_list;
+}
+
+void ObjManager::clean_obj_grid()
+{
+ for(uint16 i = 0; i < OBJ_GRID_PAGES; i++)
+  {
+   if(obj_grid[i])
+     {
+      delete[] obj_grid[i];
+      obj_grid[i] = NULL;
+     }
+  }
+}
+
 void ObjManager::update(uint16 x, uint16 y, uint8 z, bool teleport)
 {
  uint16 cur_blk_x, cur_blk_y;
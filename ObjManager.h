@@ -63,6 +63,15 @@ class Actor;
 
 #include "Obj.h"
 
+// Direct lookup of the tile obj lists held in the trees. Each level is split
+// into pages of OBJ_GRID_PAGE_SIDE x OBJ_GRID_PAGE_SIDE tiles which are only
+// allocated once an obj list exists on them.
+#define OBJ_GRID_PAGE_SHIFT 4
+#define OBJ_GRID_PAGE_SIDE (1 << OBJ_GRID_PAGE_SHIFT)
+#define OBJ_GRID_SURFACE_PAGES ((1024 >> OBJ_GRID_PAGE_SHIFT) * (1024 >> OBJ_GRID_PAGE_SHIFT))
+#define OBJ_GRID_DUNGEON_PAGES ((256 >> OBJ_GRID_PAGE_SHIFT) * (256 >> OBJ_GRID_PAGE_SHIFT))
+#define OBJ_GRID_PAGES (OBJ_GRID_SURFACE_PAGES + 5 * OBJ_GRID_DUNGEON_PAGES)
+
 struct ObjTreeNode
 {
  iAVLKey key;
@@ -83,6 +92,7 @@ class ObjManager
  //chunk object trees.
  iAVLTree *surface[64];
  iAVLTree *dungeon[5];
+ U6LList **obj_grid[OBJ_GRID_PAGES]; // tile -> obj list, see get_obj_grid_page()
 
  uint16 obj_to_tile[1024]; //maps object number (index) to tile number.
  uint8 obj_weight[1024];
@@ -100,6 +110,7 @@ class ObjManager
  uint8 last_obj_blk_z;
 
  uint16 obj_save_count;
+ uint32 map_change_count; // bumped whenever an obj is added to or removed from the map
 
  bool custom_actor_tiles;
 
@@ -144,6 +155,7 @@ class ObjManager
  bool is_door(uint16 x, uint16 y, uint8 level);
 
  U6LList *get_obj_list(uint16 x, uint16 y, uint8 level);
+ uint32 get_map_change_count() { return map_change_count; }
 
  Tile *get_obj_tile(uint16 obj_n, uint8 frame_n);
  Tile *get_obj_tile(uint16 x, uint16 y, uint8 level, bool top_obj = true);
@@ -213,6 +225,10 @@ class ObjManager
 
  iAVLKey get_obj_tree_key(Obj *obj);
  iAVLKey get_obj_tree_key(uint16 x, uint16 y, uint8 level);
+
+ inline uint16 get_obj_grid_page(uint16 x, uint16 y, uint8 level);
+ void set_obj_grid_list(uint16 x, uint16 y, uint8 level, U6LList *obj_list);
+ void clean_obj_grid();
  //inline U6LList *ObjManager::get_schunk_list(uint16 x, uint16 y, uint8 level);
 
  bool temp_obj_list_add(Obj *obj);
@@ -43,8 +43,6 @@
 #include "FontManager.h"
 #include "KoreanTranslation.h"
 
-#define NUM_ORIGINAL_TILES 2048
-
 static char article_tbl[][5] = {"", "a ", "an ", "the "};
 
 static const uint16 U6_ANIM_SRC_TILE[32] = {0x16,0x16,0x1a,0x1a,0x1e,0x1e,0x12,0x12,
@@ -105,7 +103,11 @@ TileManager::TileManager(Configuration *cfg)
  extendedTiles = NULL;
  numTiles = NUM_ORIGINAL_TILES;
 
+ scaled_tile_hits = scaled_tile_misses = 0;
+ scaled_tile_memory = 0;
+
  config->value("config/GameType",game_type);
+ config->value("config/video/scaled_tile_cache", scaled_tile_cache, true);
 }
 
 TileManager::~TileManager()
@@ -117,6 +119,10 @@ TileManager::~TileManager()
  {
    free(extendedTiles);
  }
+
+ if(scaled_tile_hits + scaled_tile_misses > 0)
+   DEBUG(0,LEVEL_INFORMATIONAL,"Scaled tile cache: %u hits, %u misses, %u bytes\n", scaled_tile_hits, scaled_tile_misses, scaled_tile_memory);
+ clear_scaled_tiles();
 }
 
 bool TileManager::loadTiles()
@@ -834,6 +840,144 @@ Tile *TileManager::get_rotated_tile(Tile *tile, float rotate)
 }
 #endif
 
+/* Returns tile `t' scaled by `scale' (2-4) in the screen's pixel format, for
+ * straight copies with Screen::blit_scaled_tile(). Entries are keyed by the
+ * real tile so animating through set_tile_index() needs no invalidation. They
+ * are rebuilt after a palette change, and tiles using rotating colours after
+ * every palette rotation. An 8 bit screen holds palette indices, so those
+ * tiles never go stale. Returns NULL if the cache is off or `t' isn't one of
+ * our tiles.
+ */
+const ScaledTile *TileManager::get_scaled_tile(Tile *t, uint8 scale)
+{
+ uint32 slot;
+
+ if(!scaled_tile_cache || scale < 2 || scale > 4)
+   return NULL;
+
+ if(t >= &tile[0] && t < &tile[NUM_ORIGINAL_TILES])
+   slot = t - &tile[0];
+ else if(extendedTiles && t >= extendedTiles && t < &extendedTiles[numTiles - NUM_ORIGINAL_TILES])
+   slot = NUM_ORIGINAL_TILES + (t - extendedTiles);
+ else
+   return NULL;
+
+ Screen *screen = Game::get_game()->get_screen();
+
+ if(slot >= scaled_tiles.size())
+   scaled_tiles.resize(slot + 1, NULL);
+
+ ScaledTile *st = scaled_tiles[slot];
+ if(st && st->scale == scale && st->bpp == screen->get_bpp() && st->transparent == t->transparent
+    && (st->bpp == 8 || st->palette_version == screen->get_palette_version())
+    && (!st->rotating || st->rotation_count == screen->get_palette_rotation_count()))
+  {
+   scaled_tile_hits++;
+   return st;
+  }
+
+ scaled_tile_misses++;
+
+ if(st == NULL)
+  {
+   st = new ScaledTile;
+   st->pixels = NULL;
+   st->scale = 0;
+   st->bpp = 0;
+   scaled_tiles[slot] = st;
+  }
+
+ build_scaled_tile(st, t, scale);
+
+ return st;
+}
+
+void TileManager::build_scaled_tile(ScaledTile *st, Tile *t, uint8 scale)
+{
+ Screen *screen = Game::get_game()->get_screen();
+ uint8 bpp = screen->get_bpp();
+ uint8 bytes_per_pixel = bpp / 8;
+ uint16 size = 16 * scale;
+
+ if(st->pixels == NULL || st->scale != scale || st->bpp != bpp)
+  {
+   if(st->pixels)
+     scaled_tile_memory -= st->scale * 16 * st->scale * 16 * (st->bpp / 8);
+   free(st->pixels);
+   st->pixels = (unsigned char *)malloc(size * size * bytes_per_pixel);
+   scaled_tile_memory += size * size * bytes_per_pixel;
+  }
+
+ st->scale = scale;
+ st->bpp = bpp;
+ st->transparent = t->transparent;
+ st->rotating = false;
+ st->num_spans = 0;
+ st->palette_version = screen->get_palette_version();
+ st->rotation_count = screen->get_palette_rotation_count();
+
+ for(uint16 y = 0; y < 16; y++)
+  {
+   const unsigned char *src = &t->data[y * 16];
+
+   for(uint16 x = 0; x < 16; x++)
+    {
+     uint32 colour = bpp == 8 ? src[x] : screen->get_colour32(src[x]);
+
+     if(bpp != 8 && screen->is_rotating_colour(src[x]))
+       st->rotating = true;
+
+     for(uint16 i = 0; i < scale; i++)
+      {
+       unsigned char *dest = st->pixels + ((y * scale + i) * size + x * scale) * bytes_per_pixel;
+       for(uint16 j = 0; j < scale; j++)
+        {
+         if(bytes_per_pixel == 1)
+           dest[j] = (unsigned char)colour;
+         else if(bytes_per_pixel == 2)
+           ((uint16 *)dest)[j] = (uint16)colour;
+         else
+           ((uint32 *)dest)[j] = colour;
+        }
+      }
+    }
+
+   // record the runs that aren't transparent
+   for(uint16 x = 0; x < 16; )
+    {
+     if(t->transparent && src[x] == 0xff)
+      {
+       x++;
+       continue;
+      }
+
+     uint16 start = x;
+     while(x < 16 && !(t->transparent && src[x] == 0xff))
+       x++;
+
+     st->spans[st->num_spans * 3] = y;
+     st->spans[st->num_spans * 3 + 1] = start;
+     st->spans[st->num_spans * 3 + 2] = x - start;
+     st->num_spans++;
+    }
+  }
+}
+
+void TileManager::clear_scaled_tiles()
+{
+ for(uint32 i = 0; i < scaled_tiles.size(); i++)
+  {
+   if(scaled_tiles[i])
+    {
+     free(scaled_tiles[i]->pixels);
+     delete scaled_tiles[i];
+    }
+  }
+
+ scaled_tiles.clear();
+ scaled_tile_memory = 0;
+}
+
 Tile *TileManager::get_cursor_tile()
 {
 	Tile *cursor_tile = NULL;
@@ -941,6 +1085,8 @@ Tile *TileManager::loadCustomTiles(const std::string filename, bool overwrite_ti
     }
   }
 
+  clear_scaled_tiles(); // overwritten tiles must be scaled again
+
   return newTilePtr;
 }
 
@@ -963,6 +1109,8 @@ void TileManager::copyTileMetaData(Tile *dest, Tile *src)
 
 Tile *TileManager::addNewTiles(uint16 num_tiles)
 {
+  clear_scaled_tiles(); // extendedTiles may move
+
   Tile *tileDataPtr = (Tile *)realloc(extendedTiles, sizeof(Tile) * (numTiles-NUM_ORIGINAL_TILES+num_tiles));
   if(tileDataPtr != NULL)
   {
@@ -989,6 +1137,7 @@ void TileManager::freeCustomTiles()
     free(extendedTiles);
     extendedTiles = NULL;
     numTiles = NUM_ORIGINAL_TILES;
+    clear_scaled_tiles();
   }
 }
 
@@ -26,6 +26,7 @@
 
 #include "nuvieDefs.h"
 #include <string>
+#include <vector>
 
 class Configuration;
 class Look;
@@ -36,6 +37,8 @@ class Look;
 #define U6TILE_TRANS 0x5
 #define U6TILE_PBLCK 0xA
 
+#define NUM_ORIGINAL_TILES 2048
+
 #define TILEFLAG_WALL_MASK  0xf0 // 11110000
 //flags1
 #define TILEFLAG_WALL_NORTH 0x80
@@ -141,6 +144,20 @@ sint8 loop_count[0x20]; // times to animate (-1 = infinite)
 uint8 loop[0x20]; // 0 = loop forwards, 1 = backwards
 } Animdata;
 
+// A tile scaled up for the map window and converted to the screen's pixel
+// format, see TileManager::get_scaled_tile().
+typedef struct {
+unsigned char *pixels; // 16*scale pixels square
+uint8 spans[TILE_DATA_SIZE * 3]; // opaque runs as (row, x, length) in unscaled pixels
+uint16 num_spans;
+uint8 scale;
+uint8 bpp;
+bool transparent;
+bool rotating; // uses colours cycled by Screen::rotate_palette()
+uint32 palette_version;
+uint32 rotation_count;
+} ScaledTile;
+
 class TileManager
 {
  Tile tile[2048];
@@ -157,6 +174,11 @@ class TileManager
  Tile *extendedTiles;
  uint16 numTiles;
 
+ bool scaled_tile_cache; // config/video/scaled_tile_cache
+ std::vector<ScaledTile *> scaled_tiles; // indexed like tile[] then extendedTiles
+ uint32 scaled_tile_hits, scaled_tile_misses;
+ uint32 scaled_tile_memory;
+
  public:
 
    TileManager(Configuration *cfg);
@@ -186,6 +208,12 @@ class TileManager
    Tile *get_rotated_tile(Tile *tile, float rotate, uint8 src_y_offset=0);
    void get_rotated_tile(Tile *tile, Tile *dest_tile, float rotate, uint8 src_y_offset=0);
 
+   const ScaledTile *get_scaled_tile(Tile *t, uint8 scale);
+   void clear_scaled_tiles();
+   uint32 get_scaled_tile_hits() { return scaled_tile_hits; }
+   uint32 get_scaled_tile_misses() { return scaled_tile_misses; }
+   uint32 get_scaled_tile_memory() { return scaled_tile_memory; }
+
    Tile *get_cursor_tile();
    Tile *get_use_tile();
    const Tile *get_gump_cursor_tile();
@@ -208,6 +236,7 @@ class TileManager
    Tile *addNewTiles(uint16 num_tiles);
 
    void writeBmpTileData(unsigned char *data, Tile *t, bool transparent);
+   void build_scaled_tile(ScaledTile *st, Tile *t, uint8 scale);
 };
 
 #endif /* __TileManager_h__ */
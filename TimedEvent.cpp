@@ -1,4 +1,5 @@
 #include <cassert>
+#include <algorithm>
 #include "nuvieDefs.h"
 
 #include "Game.h"
@@ -26,15 +27,29 @@
 
 #define MESG_TIMED CB_TIMED
 
+/* Heap order, the top of the heap is the earliest time and then the
+ * earliest added.
+ */
+static bool time_queue_later(const TimeQueueEntry &a, const TimeQueueEntry &b)
+{
+    if(a.time != b.time)
+        return(a.time > b.time);
+    return(a.seq > b.seq);
+}
+
+
 /* Activate all events for the current time, deleting those that have fired
  * and are of no more use. Repeated timers are requeued.
  */
 void TimeQueue::call_timers(uint32 now)
 {
+    fired = 0;
     while(!empty() && call_timer(now))
     {
-
+        fired++;
     }
+    if(fired > max_fired)
+        max_fired = fired;
 }
 
 
@@ -43,18 +58,18 @@ void TimeQueue::call_timers(uint32 now)
  */
 void TimeQueue::add_timer(TimedEvent *tevent)
 {
-    std::list<TimedEvent *>::iterator t;
-    if(tq.empty())
-    {
-        tq.push_front(tevent);
-        return;
-    }
-    // in case it's already queued, remove the earlier instance(s)
-    remove_timer(tevent);
-    // add after events with earlier/equal time
-    t = tq.begin();
-    while(t != tq.end() && (*t)->time <= tevent->time) t++;
-    tq.insert(t, tevent);
+    TimeQueueEntry entry;
+    entry.time = tevent->time;
+    entry.seq = next_seq++;
+    entry.tevent = tevent;
+
+    // in case it's already queued, the earlier entry is left to be skipped
+    queued[tevent] = entry.seq;
+    tq.push_back(entry);
+    std::push_heap(tq.begin(), tq.end(), time_queue_later);
+
+    if(queued.size() > max_size)
+        max_size = queued.size();
 }
 
 
@@ -62,16 +77,9 @@ void TimeQueue::add_timer(TimedEvent *tevent)
  */
 void TimeQueue::remove_timer(TimedEvent *tevent)
 {
-    std::list<TimedEvent *>::iterator t;
-    t = tq.begin();
-    while(t != tq.end())
-      {
-        if(*t == tevent)
-        {
-            t = tq.erase(t);
-        }
-        else ++t; // this deletes all duplicates
-      }
+    queued.erase(tevent);
+    if(tq.size() > queued.size() * 2 + 64) // mostly removed entries
+        compact();
 }
 
 
@@ -79,24 +87,63 @@ void TimeQueue::remove_timer(TimedEvent *tevent)
  */
 TimedEvent *TimeQueue::pop_timer()
 {
-    TimedEvent *first = NULL;
-    if(!empty())
+    TimedEvent *first = front();
+    if(first != NULL)
     {
-        first = tq.front();
-        tq.pop_front(); // remove it
+        queued.erase(first);
+        std::pop_heap(tq.begin(), tq.end(), time_queue_later);
+        tq.pop_back(); // remove it
     }
     return(first);
 }
 
 
+/* Return timed event at front of queue, or NULL if empty. Removed entries
+ * on top of the heap are dropped.
+ */
+TimedEvent *TimeQueue::front()
+{
+    while(!tq.empty() && !is_queued(tq.front()))
+    {
+        std::pop_heap(tq.begin(), tq.end(), time_queue_later);
+        tq.pop_back();
+    }
+    return(tq.empty() ? NULL : tq.front().tevent);
+}
+
+
+/* Is this the current entry of a timer in the queue? (not removed or re-added)
+ */
+bool TimeQueue::is_queued(const TimeQueueEntry &entry)
+{
+    std::map<TimedEvent *, uint32>::iterator q = queued.find(entry.tevent);
+    return(q != queued.end() && q->second == entry.seq);
+}
+
+
+/* Drop all removed entries and rebuild the heap.
+ */
+void TimeQueue::compact()
+{
+    std::vector<TimeQueueEntry>::iterator t = tq.begin();
+    for(std::vector<TimeQueueEntry>::iterator e = tq.begin(); e != tq.end(); e++)
+    {
+        if(is_queued(*e))
+            *t++ = *e;
+    }
+    tq.erase(t, tq.end());
+    std::make_heap(tq.begin(), tq.end(), time_queue_later);
+}
+
+
 /* Call timed event at front of queue, whose time is <= `now'.
  * Returns true if an event handler was called. (false if time isn't up yet)
  */
 bool TimeQueue::call_timer(uint32 now)
 {
-    if(empty())
+    TimedEvent *tevent = front();
+    if(tevent == NULL)
         return(false);
-    TimedEvent *tevent = tq.front();
     if(tevent->defunct)
     {
         bool can_delete = tevent->tq_can_delete;
@@ -2,6 +2,8 @@
 #define __TimedEvent_h__
 
 #include <list>
+#include <map>
+#include <vector>
 #include <string>
 #include <cstdio>
 #include "CallBack.h"
@@ -18,17 +20,38 @@ class Party;
 class TimedCallbackTarget;
 class TimedEvent;
 
-/* A queue for our events.
+typedef struct
+{
+    uint32 time;
+    uint32 seq; // order of adding, so equal times activate first in first out
+    TimedEvent *tevent;
+} TimeQueueEntry;
+
+/* A queue for our events. It is a binary heap ordered by time. Removed timers
+ * are only dropped from `queued', their heap entries are skipped when they
+ * come to the top. (the TimedEvent may be gone by then, so isn't looked at)
  */
 class TimeQueue
 {
-    std::list<TimedEvent *> tq;
+    std::vector<TimeQueueEntry> tq;
+    std::map<TimedEvent *, uint32> queued; // timers in the queue, and seq of their entry
+    uint32 next_seq;
+
+    uint32 max_size; // most timers queued at once
+    uint32 fired, max_fired; // timers activated by the last call_timers(), and the most by one
+
 public:
-    TimeQueue() : tq() { }
+    TimeQueue() : tq(), queued(), next_seq(0), max_size(0), fired(0), max_fired(0) { }
     ~TimeQueue() { clear(); }
 
-    bool empty() { return(tq.empty()); }
-    void clear() { while(!empty()) pop_timer(); }
+    bool empty() { return(queued.empty()); }
+    void clear() { queued.clear(); tq.clear(); }
+
+    uint32 get_size() { return queued.size(); }
+    uint32 get_max_size() { return max_size; }
+    uint32 get_fired() { return fired; }
+    uint32 get_max_fired() { return max_fired; }
+    void reset_stats() { max_size = queued.size(); max_fired = 0; }
 
     void add_timer(TimedEvent *tevent);
     void remove_timer(TimedEvent *tevent);
@@ -37,6 +60,11 @@ public:
 
     bool call_timer(uint32 now); // activate
     void call_timers(uint32 now); // activate all
+
+protected:
+    TimedEvent *front();
+    bool is_queued(const TimeQueueEntry &entry);
+    void compact();
 };
 
 
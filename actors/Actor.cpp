@@ -140,11 +140,20 @@ bool Actor::init(uint8 obj_status)
  return true;
 }
 
+// Keep ActorManager's location index in sync after x,y,z change.
+static inline void actor_location_changed(Actor *actor)
+{
+ ActorManager *actor_manager = Game::get_game()->get_actor_manager();
+ if(actor_manager)
+   actor_manager->update_actor_location(actor);
+}
+
 void Actor::init_from_obj(Obj *obj, bool change_base_obj)
 {
  x = obj->x;
  y = obj->y;
  z = obj->z;
+ actor_location_changed(this);
 
  if(change_base_obj)
  {
@@ -607,6 +616,7 @@ bool Actor::move(uint16 new_x, uint16 new_y, uint8 new_z, ActorMoveFlags flags)
  x = WRAPPED_COORD(new_x,new_z); // FIXME: this is probably needed because PathFinder is not wrapping coords
  y = WRAPPED_COORD(new_y,new_z);
  z = new_z;
+ actor_location_changed(this);
 
  can_move = true;
  //FIXME move this into Player::moveRelative()
@@ -1713,6 +1723,7 @@ void Actor::clear()
  x = 0;
  y = 0;
  z = 0;
+ actor_location_changed(this);
  hide();
  Actor::set_worktype(0);
  light = 0;
@@ -1876,6 +1887,7 @@ void Actor::resurrect(MapCoord new_position, Obj *body_obj)
 	x = new_position.x;
 	y = new_position.y;
 	z = new_position.z;
+	actor_location_changed(this);
 	obj_n = base_obj_n;
 	init((Game::get_game()->get_game_type() == NUVIE_GAME_U6 && id_n == 130)
 	      ? OBJ_STATUS_MUTANT : NO_OBJ_STATUS);
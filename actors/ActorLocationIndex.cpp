@@ -0,0 +1,151 @@
+/*
+ *  ActorLocationIndex.cpp
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+#include <cstring>
+#include "nuvieDefs.h"
+#include "ActorLocationIndex.h"
+
+ActorLocationIndex::ActorLocationIndex()
+{
+ clear();
+}
+
+// x and y are wrapped first, so 1024 doesn't spill into the y bits
+inline uint32 ActorLocationIndex::get_key(uint16 x, uint16 y, uint8 z)
+{
+ return (uint32)WRAPPED_COORD(x, z) | ((uint32)WRAPPED_COORD(y, z) << 10) | ((uint32)z << 20);
+}
+
+inline uint16 ActorLocationIndex::get_bucket(uint32 key)
+{
+ // nearby tiles land in different buckets
+ return (uint16)(((key & 0x1f) | ((key >> 5) & 0x3e0)) ^ ((key >> 20) * 0x95)) & (ACTOR_LOCATION_HASH_SIZE - 1);
+}
+
+void ActorLocationIndex::clear()
+{
+ uint16 i;
+
+ for(i = 0; i < ACTOR_LOCATION_HASH_SIZE; i++)
+   loc_hash[i] = ACTOR_LOCATION_NONE;
+
+ for(i = 0; i < ACTOR_LOCATION_MAX_ACTORS; i++)
+  {
+   loc_next[i] = ACTOR_LOCATION_NONE;
+   loc_key[i] = 0;
+   loc_indexed[i] = false;
+  }
+}
+
+// Called whenever an actor's x,y,z changes so the index stays in sync.
+void ActorLocationIndex::update(uint8 id_n, uint16 x, uint16 y, uint8 z)
+{
+ uint32 key = get_key(x, y, z);
+
+ if(loc_indexed[id_n])
+  {
+   if(loc_key[id_n] == key)
+     return;
+   remove(id_n);
+  }
+
+ // keep the chain sorted by id
+ uint16 *link = &loc_hash[get_bucket(key)];
+ while(*link != ACTOR_LOCATION_NONE && *link < id_n)
+   link = &loc_next[*link];
+
+ loc_next[id_n] = *link;
+ *link = id_n;
+ loc_key[id_n] = key;
+ loc_indexed[id_n] = true;
+}
+
+void ActorLocationIndex::remove(uint8 id_n)
+{
+ if(!loc_indexed[id_n])
+   return;
+
+ uint16 *link = &loc_hash[get_bucket(loc_key[id_n])];
+
+ for(; *link != ACTOR_LOCATION_NONE; link = &loc_next[*link])
+  {
+   if(*link == id_n)
+    {
+     *link = loc_next[id_n];
+     break;
+    }
+  }
+
+ loc_next[id_n] = ACTOR_LOCATION_NONE;
+ loc_indexed[id_n] = false;
+}
+
+// Return the lowest actor id standing on x,y,z, or ACTOR_LOCATION_NONE.
+uint16 ActorLocationIndex::find(uint16 x, uint16 y, uint8 z, uint16 excluded_id_n)
+{
+ uint32 key = get_key(x, y, z);
+ uint16 i;
+
+ for(i = loc_hash[get_bucket(key)]; i != ACTOR_LOCATION_NONE; i = loc_next[i])
+  {
+   if(loc_key[i] == key && i != excluded_id_n)
+     return i;
+  }
+
+ return ACTOR_LOCATION_NONE;
+}
+
+// Set found[id] for every actor inside the w x h area at x,y,z, clear the
+// rest. The area wraps around the edge of the map like single tiles do and
+// is cut to the map size, so no tile is visited twice. Small areas are
+// probed through the hash, anything larger than ACTOR_LOCATION_PROBE_LIMIT
+// tiles checks every indexed actor instead.
+void ActorLocationIndex::find_in_area(uint16 x, uint16 y, uint16 w, uint16 h, uint8 z, bool found[ACTOR_LOCATION_MAX_ACTORS])
+{
+ uint16 map_side = WRAPPED_COORD(0xffff, z) + 1;
+ uint16 i;
+
+ memset(found, 0, ACTOR_LOCATION_MAX_ACTORS * sizeof(bool));
+ w = MIN(w, map_side);
+ h = MIN(h, map_side);
+
+ if((uint32)w * h <= ACTOR_LOCATION_PROBE_LIMIT)
+  {
+   for(uint16 dy = 0; dy < h; dy++)
+     for(uint16 dx = 0; dx < w; dx++)
+      {
+       uint32 key = get_key(x + dx, y + dy, z);
+       for(i = loc_hash[get_bucket(key)]; i != ACTOR_LOCATION_NONE; i = loc_next[i])
+         if(loc_key[i] == key)
+           found[i] = true;
+      }
+  }
+ else
+  {
+   for(i = 0; i < ACTOR_LOCATION_MAX_ACTORS; i++)
+    {
+     uint32 key = loc_key[i];
+     if(!loc_indexed[i] || (key >> 20) != z)
+       continue;
+     // distance from the corner going right/down, across the seam if need be
+     if(WRAPPED_COORD((key & 0x3ff) - x, z) < w && WRAPPED_COORD(((key >> 10) & 0x3ff) - y, z) < h)
+       found[i] = true;
+    }
+  }
+}
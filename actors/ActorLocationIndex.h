@@ -0,0 +1,57 @@
+#ifndef __ActorLocationIndex_h__
+#define __ActorLocationIndex_h__
+/*
+ *  ActorLocationIndex.h
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#define ACTOR_LOCATION_MAX_ACTORS 256
+#define ACTOR_LOCATION_HASH_SIZE 1024 // buckets in the index
+#define ACTOR_LOCATION_NONE 0xffff // end of a chain, or nobody found
+#define ACTOR_LOCATION_PROBE_LIMIT 256 // largest area find_in_area() probes tile by tile
+
+/* Maps x,y,z to the actor ids standing there. Actors are chained per hash
+ * bucket in ascending id order, so find() returns the same actor a linear
+ * scan of the actor list would. Coordinates are wrapped to the map size of
+ * their level, as with WRAPPED_COORD(), so areas may cross the map seam.
+ */
+class ActorLocationIndex
+{
+ uint16 loc_hash[ACTOR_LOCATION_HASH_SIZE];
+ uint16 loc_next[ACTOR_LOCATION_MAX_ACTORS];
+ uint32 loc_key[ACTOR_LOCATION_MAX_ACTORS];
+ bool loc_indexed[ACTOR_LOCATION_MAX_ACTORS];
+
+ public:
+
+ ActorLocationIndex();
+
+ void clear();
+ void update(uint8 id_n, uint16 x, uint16 y, uint8 z);
+ void remove(uint8 id_n);
+
+ uint16 find(uint16 x, uint16 y, uint8 z, uint16 excluded_id_n = ACTOR_LOCATION_NONE);
+ void find_in_area(uint16 x, uint16 y, uint16 w, uint16 h, uint8 z, bool found[ACTOR_LOCATION_MAX_ACTORS]);
+
+ protected:
+
+ inline uint32 get_key(uint16 x, uint16 y, uint8 z);
+ inline uint16 get_bucket(uint32 key);
+};
+
+#endif /* __ActorLocationIndex_h__ */
@@ -23,6 +23,7 @@
 #include <cassert>
 #include <sstream>
 #include <cstdlib>
+#include <cstring>
 #include "nuvieDefs.h"
 #include "U6misc.h"
 #include "Configuration.h"
@@ -66,6 +67,7 @@ ActorManager::ActorManager(Configuration *cfg, Map *m, TileManager *tm, ObjManag
  for(i = 0; i < ACTORMANAGER_MAX_ACTORS; i++)
    actors[i] = NULL;
  temp_actor_offset = 224;
+ location_index.clear();
  init();
 }
 
@@ -105,6 +107,7 @@ void ActorManager::clean()
      }
   }
 
+ location_index.clear();
  init();
 
  return;
@@ -170,6 +173,8 @@ bool ActorManager::load(NuvieIO *objlist)
     }
    }
 
+ rebuild_location_index();
+
  // Object flags.
 
  objlist->seek(0x000);
@@ -357,6 +362,7 @@ bool ActorManager::load(NuvieIO *objlist)
 	 a->x=0;
 	 a->y=0;
 	 a->z=0;
+	 update_actor_location(a);
 	 //a->status_flags = ACTOR_STATUS_DEAD;
 	 //a->hide();
  }
@@ -575,13 +581,9 @@ Actor *ActorManager::get_actor(uint8 actor_num)
 
 Actor *ActorManager::get_actor(uint16 x, uint16 y, uint8 z, bool inc_surrounding_objs, Actor *excluded_actor)
 {
- uint16 i;
-
- for(i=0;i<ACTORMANAGER_MAX_ACTORS;i++)
-  {
-   if(actors[i]->x == x && actors[i]->y == y && actors[i]->z == z && actors[i] != excluded_actor)
-     return actors[i];
-  }
+ Actor *actor = get_indexed_actor(x, y, z, excluded_actor);
+ if(actor)
+   return actor;
 
  if(inc_surrounding_objs)
  {
@@ -602,7 +604,7 @@ Actor *ActorManager::get_actor(uint16 x, uint16 y, uint8 z, bool inc_surrounding
 
 Actor *ActorManager::get_multi_tile_actor(uint16 x, uint16 y, uint8 z)
 {
-	Actor *actor = get_actor(x+1,y+1,z,false); //search for 2x2 tile actor.
+	Actor *actor = get_indexed_actor(x+1,y+1,z); //search for 2x2 tile actor.
 	if(actor)
 	{
 		Tile *tile = actor->get_tile();
@@ -610,7 +612,7 @@ Actor *ActorManager::get_multi_tile_actor(uint16 x, uint16 y, uint8 z)
 			return actor;
 	}
 
-	actor = get_actor(x,y+1,z,false); //search for 1x2 tile actor.
+	actor = get_indexed_actor(x,y+1,z); //search for 1x2 tile actor.
 	if(actor)
 	{
 		Tile *tile = actor->get_tile();
@@ -618,7 +620,7 @@ Actor *ActorManager::get_multi_tile_actor(uint16 x, uint16 y, uint8 z)
 			return actor;
 	}
 
-	actor = get_actor(x+1,y,z,false); //search for 1x2 tile actor.
+	actor = get_indexed_actor(x+1,y,z); //search for 1x2 tile actor.
 	if(actor)
 	{
 		Tile *tile = actor->get_tile();
@@ -630,6 +632,103 @@ Actor *ActorManager::get_multi_tile_actor(uint16 x, uint16 y, uint8 z)
 	return NULL;
 }
 
+// Return the lowest numbered actor standing on x,y,z.
+Actor *ActorManager::get_indexed_actor(uint16 x, uint16 y, uint8 z, Actor *excluded_actor)
+{
+ uint16 i = location_index.find(x, y, z, excluded_actor ? excluded_actor->id_n : ACTOR_LOCATION_NONE);
+
+ if(i == ACTOR_LOCATION_NONE)
+   return NULL;
+
+ return actors[i];
+}
+
+// Return all actors whose location is inside the w x h area at x,y,z in
+// ascending id order. The area wraps around the edge of the map.
+ActorList *ActorManager::get_actors_in_area(uint16 x, uint16 y, uint16 w, uint16 h, uint8 z)
+{
+ ActorList *list = new ActorList;
+ bool found[ACTORMANAGER_MAX_ACTORS];
+
+ location_index.find_in_area(x, y, w, h, z, found);
+
+ for(uint16 i = 0; i < ACTORMANAGER_MAX_ACTORS; i++)
+   if(found[i])
+     list->push_back(actors[i]);
+
+ return list;
+}
+
+/* Pick the next actor to act this turn, with the rule actor_update_all() in
+ * the U6 scripts uses: the first actor on level z that can move and has at
+ * least its dexterity in movement points, else the one with the most
+ * movement points for its dexterity. Actors further than 0x27 tiles from
+ * origin aren't picked, scheduled ones among them are added to
+ * offscreen_scheduled for the script to send to their schedule location.
+ * Returns NULL (and moves 0) if nobody can move.
+ */
+Actor *ActorManager::get_next_actor_to_move(sint32 origin_x, sint32 origin_y, uint8 z, sint8 *moves, ActorList *offscreen_scheduled)
+{
+ Actor *selected_actor = NULL;
+ sint32 di = 0;
+ sint32 dex_6 = 1;
+
+ for(uint16 i = 0; i < ACTORMANAGER_MAX_ACTORS; i++)
+   {
+    Actor *actor = actors[i];
+    if(actor == NULL || actor->get_obj_n() == 0 || actor->get_z() != z || actor->get_moves_left() <= 0 || actor->is_paralyzed()
+       || actor->is_sleeping() || actor->get_worktype() == WORKTYPE_U6_MOTIONLESS || !actor->is_alive())
+      continue;
+
+    if(abs((sint32)actor->get_x() - origin_x) > 0x27 || abs((sint32)actor->get_y() - origin_y) > 0x27)
+      {
+       if(actor->get_worktype() >= 0x83 && actor->get_worktype() <= WORKTYPE_U6_WALK_TO_LOCATION)
+         offscreen_scheduled->push_back(actor);
+       continue;
+      }
+
+    if(actor->get_worktype() == WORKTYPE_U6_IN_PARTY)
+      continue;
+
+    if(actor->get_worktype() == 0x80)
+      actor->set_worktype(actor->get_sched_worktype());
+
+    sint32 mpts = actor->get_moves_left();
+    sint32 dex = actor->get_dexterity();
+    sint32 dx = mpts * dex_6 - dex * di;
+    if(mpts >= dex || dx > 0 || (dx == 0 && dex > dex_6))
+      {
+       selected_actor = actor;
+       di = mpts;
+       dex_6 = dex;
+      }
+
+    if(mpts >= dex)
+      break;
+   }
+
+ *moves = (sint8)di;
+ return selected_actor;
+}
+
+void ActorManager::rebuild_location_index()
+{
+ location_index.clear();
+
+ for(uint16 i = 0; i < ACTORMANAGER_MAX_ACTORS; i++)
+   if(actors[i])
+     update_actor_location(actors[i]);
+}
+
+// Called whenever an actor's x,y,z changes so the location index stays in sync.
+void ActorManager::update_actor_location(Actor *actor)
+{
+ if(actors[actor->id_n] != actor)
+   return;
+
+ location_index.update(actor->id_n, actor->x, actor->y, actor->z);
+}
+
 Actor *ActorManager::get_avatar()
 {
 	return get_actor(ACTOR_AVATAR_ID_N);
@@ -864,7 +963,8 @@ bool ActorManager::create_temp_actor(uint16 obj_n, uint8 obj_status, uint16 x, u
    actor->x = x;
    actor->y = y;
    actor->z = z;
-   
+   update_actor_location(actor);
+
    actor->temp_actor = true;
 
    actor->obj_flags = 0;
@@ -28,6 +28,7 @@
 #include <set>
 #include "ObjManager.h"
 #include "ActorList.h"
+#include "ActorLocationIndex.h"
 
 class Configuration;
 class Actor;
@@ -63,6 +64,8 @@ class ActorManager
  uint8 cur_z;
  MapCoord *cmp_actor_loc; // data for sort_distance() & cmp_distance_to_loc()
 
+ ActorLocationIndex location_index; // so get_actor(x,y,z) needn't scan every actor
+
  public:
 
  ActorManager(Configuration *cfg, Map *m, TileManager *tm, ObjManager *om, GameClock *c);
@@ -83,6 +86,10 @@ class ActorManager
  Actor *get_actor(uint8 actor_num);
  Actor *get_actor(uint16 x, uint16 y, uint8 z,  bool inc_surrounding_objs=true, Actor *excluded_actor = NULL);
  Actor *get_actor_holding_obj(Obj *obj);
+ ActorList *get_actors_in_area(uint16 x, uint16 y, uint16 w, uint16 h, uint8 z); // *returns a NEW list*
+ Actor *get_next_actor_to_move(sint32 origin_x, sint32 origin_y, uint8 z, sint8 *moves, ActorList *offscreen_scheduled);
+
+ void update_actor_location(Actor *actor);
 
  Actor *get_avatar();
 
@@ -117,6 +124,9 @@ class ActorManager
  protected:
 
  Actor *get_multi_tile_actor(uint16 x, uint16 y, uint8 z);
+ Actor *get_indexed_actor(uint16 x, uint16 y, uint8 z, Actor *excluded_actor = NULL);
+
+ void rebuild_location_index();
 
  bool loadActorSchedules();
  inline Actor *find_free_temp_actor();
@@ -1909,7 +1909,6 @@ function actor_update_all()
    repeat
       selected_actor = nil
       local di = 0
-      local dex_6 = 1
       repeat
          local player_loc = player_get_location()
          local var_C = (player_loc.x - 16) - (player_loc.x - 16) % 8
@@ -1922,39 +1921,18 @@ function actor_update_all()
          end
          
          local player_z = player_loc.z
-         for i=0,0xff do
-            local actor = Actor.get(i)
-            if actor.obj_n ~= 0 and actor.z == player_z and actor.mpts > 0 and actor.paralyzed == false and actor.asleep == false and actor.wt ~= WT_NOTHING and actor.alive == true then
-                  if abs(actor.x - var_C) > 0x27 or abs(actor.y - var_A) > 0x27 then
-                     if actor.wt >= 0x83 and actor.wt <= 0x86 then
-                        --move actor to schedule location if it isn't on screen
-                        local sched_loc = actor.sched_loc
-                        if map_is_on_screen(sched_loc.x, sched_loc.y, sched_loc.z) == false then
-                        	Actor.move(actor, sched_loc.x, sched_loc.y, sched_loc.z)
-                        	actor_wt_walk_to_location(actor) --this will cancel the pathfinder and set the new worktype
-                        	subtract_movement_pts(actor, 10)
-                        	----dgb("\nActor SCHEDULE TELEPORT "..actor.actor_num.." to ("..sched_loc.x..","..sched_loc.y..","..sched_loc.z..")\n")
-                        end
-                     end
-                  else
-                     if actor.wt ~= WT_FOLLOW then
-                        if actor.wt == 0x80 then
-                           -- actor_set_worktype_from_schedule(actor)
-                           actor.wt = actor.sched_wt
-                        end
-                        
-                        local dx = (actor.mpts * dex_6) - actor.dex * di
-                        if actor.mpts >= actor.dex or dx > 0 or dx == 0 and actor.dex > dex_6 then
-                           selected_actor = actor
-                           di = actor.mpts
-                           dex_6 = actor.dex
-                        end
-                        
-                        if actor.mpts >= actor.dex then
-                           break
-                        end
-                     end
-                  end
+         local offscreen_actors
+         selected_actor, di, offscreen_actors = actor_next_to_move(var_C, var_A, player_z)
+         if offscreen_actors ~= nil then
+            for _,actor in ipairs(offscreen_actors) do
+               --move actor to schedule location if it isn't on screen
+               local sched_loc = actor.sched_loc
+               if map_is_on_screen(sched_loc.x, sched_loc.y, sched_loc.z) == false then
+               	Actor.move(actor, sched_loc.x, sched_loc.y, sched_loc.z)
+               	actor_wt_walk_to_location(actor) --this will cancel the pathfinder and set the new worktype
+               	subtract_movement_pts(actor, 10)
+               	----dgb("\nActor SCHEDULE TELEPORT "..actor.actor_num.." to ("..sched_loc.x..","..sched_loc.y..","..sched_loc.z..")\n")
+               end
             end
          end
          
@@ -2576,7 +2554,7 @@ function actor_wt_front(actor)
 			if actor_find_max_xy_distance(actor, party_avg_x, party_avg_y) >= 8 then
 				subtract_movement_pts(actor, 5)
 			else
-				if actor ~= wt_front_target_actor then
+				if wt_front_target_actor == nil or actor.actor_num ~= wt_front_target_actor.actor_num then
 					actor_wt_attack(actor)
 				else
 					if math.random(0, 7) ~= 0 then
@@ -230,3 +230,100 @@ void NuvieIOBuffer::seek(uint32 new_pos)
     if(data && new_pos < size)
         pos = new_pos;
 }
+
+// NuvieIOBufferWrite
+
+NuvieIOBufferWrite::NuvieIOBufferWrite() : NuvieIOBuffer()
+{
+ capacity = 0;
+}
+
+bool NuvieIOBufferWrite::open(uint32 initial_size)
+{
+ if(data != NULL)
+   return false;
+
+ data = (unsigned char *)malloc(initial_size > 0 ? initial_size : 1);
+ if(data == NULL)
+   {
+    DEBUG(0,LEVEL_ERROR,"NuvieIOBufferWrite::open() allocating %d bytes.\n",initial_size);
+    return false;
+   }
+
+ copied_data = true;
+ capacity = initial_size;
+ size = 0;
+ pos = 0;
+
+ return true;
+}
+
+void NuvieIOBufferWrite::close()
+{
+ NuvieIOBuffer::close();
+ capacity = 0;
+}
+
+// Make room for writing up to end, growing the size to match.
+bool NuvieIOBufferWrite::grow(uint32 end)
+{
+ if(data == NULL)
+   return false;
+
+ if(end > capacity)
+   {
+    uint32 new_capacity = MAX(capacity * 2, end);
+    unsigned char *new_data = (unsigned char *)realloc(data, new_capacity);
+    if(new_data == NULL)
+      {
+       DEBUG(0,LEVEL_ERROR,"NuvieIOBufferWrite::grow() allocating %d bytes.\n",new_capacity);
+       return false;
+      }
+    data = new_data;
+    capacity = new_capacity;
+   }
+
+ if(end > size)
+   size = end;
+
+ return true;
+}
+
+bool NuvieIOBufferWrite::write1(uint8 src)
+{
+ if(!grow(pos + 1))
+   return false;
+
+ return NuvieIOBuffer::write1(src);
+}
+
+bool NuvieIOBufferWrite::write2(uint16 src)
+{
+ if(!grow(pos + 2))
+   return false;
+
+ return NuvieIOBuffer::write2(src);
+}
+
+bool NuvieIOBufferWrite::write4(uint32 src)
+{
+ if(!grow(pos + 4))
+   return false;
+
+ return NuvieIOBuffer::write4(src);
+}
+
+uint32 NuvieIOBufferWrite::writeBuf(const unsigned char *src, uint32 src_size)
+{
+ if(src == NULL || !grow(pos + src_size))
+   return 0;
+
+ return NuvieIOBuffer::writeBuf(src, src_size);
+}
+
+// Unlike NuvieIOBuffer, seeking to the end is allowed so writing can go on.
+void NuvieIOBufferWrite::seek(uint32 new_pos)
+{
+ if(data && new_pos <= size)
+   pos = new_pos;
+}
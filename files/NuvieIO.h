@@ -99,4 +99,30 @@ class NuvieIOBuffer: public NuvieIO
 
    void seek(uint32 new_pos);
 };
+
+// A NuvieIOBuffer that grows when written past its end, so a file can be
+// built in memory and written out in one go.
+class NuvieIOBufferWrite: public NuvieIOBuffer
+{
+ protected:
+
+ uint32 capacity;
+
+ public:
+   NuvieIOBufferWrite();
+
+   bool open(uint32 initial_size);
+
+   void close();
+
+   bool write1(uint8 src);
+   bool write2(uint16 src);
+   bool write4(uint32 src);
+   uint32 writeBuf(const unsigned char *src, uint32 src_size);
+
+   void seek(uint32 new_pos);
+
+ protected:
+   bool grow(uint32 end);
+};
 #endif /* __NuvieIO_h__ */
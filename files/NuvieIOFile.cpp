@@ -21,6 +21,9 @@
  *
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "nuvieDefs.h"
 
 #include "NuvieIOFile.h"
@@ -89,51 +92,93 @@ void NuvieIOFile::seek(uint32 new_pos)
 //NuvieIOFileRead methods
 //
 
+NuvieIOFileRead::NuvieIOFileRead() : NuvieIOFile()
+{
+ read_buf = NULL;
+ read_buf_start = 0;
+ read_buf_len = 0;
+}
+
+NuvieIOFileRead::~NuvieIOFileRead()
+{
+ close();
+}
+
 bool NuvieIOFileRead::open(const char *filename)
 {
  return openWithMode(filename,"rb");
 }
 
+void NuvieIOFileRead::close()
+{
+ if(read_buf)
+   free(read_buf);
+
+ read_buf = NULL;
+ read_buf_start = 0;
+ read_buf_len = 0;
+
+ NuvieIOFile::close();
+}
+
+/* Make sure bytes pos to pos + needed - 1 are in read_buf, reading the block
+ * at pos if they aren't. needed must not be more than the block size.
+ */
+bool NuvieIOFileRead::fill_read_buf(uint32 needed)
+{
+ if(pos >= read_buf_start && pos + needed <= read_buf_start + read_buf_len)
+   return true;
+
+ if(fp == NULL)
+   return false;
+
+ uint32 block_size = MIN(size, (uint32)NUVIE_IO_FILE_BLOCK_SIZE);
+ if(read_buf == NULL)
+   {
+    read_buf = (unsigned char *)malloc(block_size > 0 ? block_size : 1);
+    if(read_buf == NULL)
+      return false;
+   }
+
+ fseek(fp, pos, SEEK_SET);
+ read_buf_start = pos;
+ read_buf_len = (uint32)fread(read_buf, 1, MIN(block_size, size - pos), fp);
+
+ return (needed <= read_buf_len);
+}
 
 uint8 NuvieIOFileRead::read1()
 {
- if(pos >= size)
+ if(pos >= size || !fill_read_buf(1))
   return 0;
 
- pos++;
-
- return(fgetc(fp));
+ return read_buf[pos++ - read_buf_start];
 }
 
 uint16 NuvieIOFileRead::read2()
 {
- unsigned char b0, b1;
+ unsigned char *b;
 
- if(pos > size-2)
+ if(pos > size-2 || !fill_read_buf(2))
    return 0;
 
+ b = &read_buf[pos - read_buf_start];
  pos += 2;
 
- b0 = fgetc(fp);
- b1 = fgetc(fp);
-
- return (b0 + (b1<<8));
+ return (b[0] + (b[1]<<8));
 }
 
 uint32 NuvieIOFileRead::read4()
 {
- unsigned char b0, b1, b2, b3;
- if(pos > size-4)
+ unsigned char *b;
+
+ if(pos > size-4 || !fill_read_buf(4))
   return 0;
 
+ b = &read_buf[pos - read_buf_start];
  pos += 4;
 
- b0 = fgetc(fp);
- b1 = fgetc(fp);
- b2 = fgetc(fp);
- b3 = fgetc(fp);
-
- return (b0 + (b1<<8) + (b2<<16) + (b3<<24));
+ return (b[0] + (b[1]<<8) + (b[2]<<16) + (b[3]<<24));
 }
 
 bool NuvieIOFileRead::readToBuf(unsigned char *buf, uint32 buf_size)
@@ -141,68 +186,135 @@ bool NuvieIOFileRead::readToBuf(unsigned char *buf, uint32 buf_size)
  if(pos + buf_size > size)
    return false;
 
- fread(buf,1,buf_size,fp); // FIX for partial read.
+ if(buf_size > NUVIE_IO_FILE_BLOCK_SIZE) // big reads skip the block
+   {
+    fseek(fp, pos, SEEK_SET);
+    fread(buf,1,buf_size,fp); // FIX for partial read.
+   }
+ else
+   {
+    if(!fill_read_buf(buf_size))
+      return false;
+    memcpy(buf, &read_buf[pos - read_buf_start], buf_size);
+   }
 
  pos += buf_size;
 
  return true;
 }
 
+// Reads seek the file themselves, so only pos needs to move.
+void NuvieIOFileRead::seek(uint32 new_pos)
+{
+ if(fp && new_pos <= size)
+   pos = new_pos;
+}
 
 
 // NuvieIOFileWrite
 //
 
+NuvieIOFileWrite::NuvieIOFileWrite() : NuvieIOFileRead()
+{
+ write_buf = NULL;
+ write_buf_len = 0;
+}
+
+// NuvieIOFile's destructor can't reach our close(), so flush here.
+NuvieIOFileWrite::~NuvieIOFileWrite()
+{
+ close();
+}
+
 bool NuvieIOFileWrite::open(const char *filename)
 {
  return openWithMode(filename,"wb");
 }
 
-bool NuvieIOFileWrite::write1(uint8 src)
+void NuvieIOFileWrite::close()
 {
- if(fp==NULL) // || pos >= size-1)
-   return false;
+ flush();
 
- fputc(src,fp);
+ if(write_buf)
+   free(write_buf);
 
- pos++;
+ write_buf = NULL;
 
- if(pos > size)
-   size = pos;
+ NuvieIOFileRead::close();
+}
 
- return true;
+// Write out the collected bytes at the file position.
+bool NuvieIOFileWrite::flush()
+{
+ if(write_buf_len == 0 || fp == NULL)
+   return true;
+
+ uint32 len = write_buf_len;
+ write_buf_len = 0;
+
+ return (fwrite(write_buf, 1, len, fp) == len);
 }
 
-bool NuvieIOFileWrite::write2(uint16 src)
+// Get room for len bytes at the end of write_buf, flushing it if it's full.
+inline unsigned char *NuvieIOFileWrite::get_write_ptr(uint32 len)
 {
- if(fp==NULL) // || pos >= size-2)
-   return false;
+ if(fp == NULL)
+   return NULL;
 
- fputc((uint8)(src & 0xff), fp);
- fputc((uint8)((src >> 8) & 0xff), fp);
+ if(write_buf == NULL)
+   {
+    write_buf = (unsigned char *)malloc(NUVIE_IO_FILE_BLOCK_SIZE);
+    if(write_buf == NULL)
+      return NULL;
+   }
 
- pos += 2;
+ if(write_buf_len + len > NUVIE_IO_FILE_BLOCK_SIZE)
+   flush();
+
+ unsigned char *ptr = &write_buf[write_buf_len];
+ write_buf_len += len;
+
+ pos += len;
 
  if(pos > size)
    size = pos;
 
+ return ptr;
+}
+
+bool NuvieIOFileWrite::write1(uint8 src)
+{
+ unsigned char *ptr = get_write_ptr(1);
+ if(ptr == NULL)
+   return false;
+
+ ptr[0] = src;
+
  return true;
 }
 
-bool NuvieIOFileWrite::write4(uint32 src)
+bool NuvieIOFileWrite::write2(uint16 src)
 {
- if(fp==NULL) // || pos >= size-4)
+ unsigned char *ptr = get_write_ptr(2);
+ if(ptr == NULL)
    return false;
 
- fputc((uint8)(src & 0xff), fp);
- fputc((uint8)((src >> 8) & 0xff), fp);
- fputc((uint8)((src >> 16) & 0xff), fp);
- fputc((uint8)((src >> 24) & 0xff), fp);
+ ptr[0] = (uint8)(src & 0xff);
+ ptr[1] = (uint8)((src >> 8) & 0xff);
 
- pos += 4;
+ return true;
+}
 
- if(pos > size)
-   size = pos;
+bool NuvieIOFileWrite::write4(uint32 src)
+{
+ unsigned char *ptr = get_write_ptr(4);
+ if(ptr == NULL)
+   return false;
+
+ ptr[0] = (uint8)(src & 0xff);
+ ptr[1] = (uint8)((src >> 8) & 0xff);
+ ptr[2] = (uint8)((src >> 16) & 0xff);
+ ptr[3] = (uint8)((src >> 24) & 0xff);
 
  return true;
 }
@@ -212,12 +324,32 @@ uint32 NuvieIOFileWrite::writeBuf(const unsigned char *src, uint32 src_size)
  if(fp == NULL)// || pos + src_size > size)
    return(0);
 
- pos += src_size;
+ if(src_size > NUVIE_IO_FILE_BLOCK_SIZE / 2) // big writes skip the block
+   {
+    flush();
 
- if(pos > size)
-   size = pos;
+    pos += src_size;
+
+    if(pos > size)
+      size = pos;
+
+    return(fwrite(src, sizeof(unsigned char), src_size, fp));
+   }
+
+ unsigned char *ptr = get_write_ptr(src_size);
+ if(ptr == NULL)
+   return(0);
+
+ memcpy(ptr, src, src_size);
+
+ return(src_size);
+}
+
+void NuvieIOFileWrite::seek(uint32 new_pos)
+{
+ flush();
 
- return(fwrite(src, sizeof(unsigned char), src_size, fp));
+ NuvieIOFile::seek(new_pos);
 }
 
 uint32 NuvieIOFileWrite::write(NuvieIO *src)
@@ -27,6 +27,8 @@
 
 #include "NuvieIO.h"
 
+#define NUVIE_IO_FILE_BLOCK_SIZE 0x10000 // bytes read or written at once, smaller files are read whole
+
 
 class NuvieIOFile : public NuvieIO
 {
@@ -50,41 +52,66 @@ class NuvieIOFile : public NuvieIO
     uint32 get_filesize();
 };
 
+// Reads are served from a block of the file held in memory.
 class NuvieIOFileRead : public NuvieIOFile
 {
  protected:
 
+ unsigned char *read_buf;
+ uint32 read_buf_start; // file offset of read_buf[0]
+ uint32 read_buf_len;
+
  public:
 
-  // NuvieIOFileRead();
-  // virtual ~NuvieIOFileRead();
+   NuvieIOFileRead();
+   virtual ~NuvieIOFileRead();
 
    bool open(const char *filename);
    bool open(std::string filename) { return open(filename.c_str()); };
 
+   void close();
+
    uint8 read1();
    uint16 read2();
    uint32 read4();
 
    bool readToBuf(unsigned char *buf, uint32 buf_size);
+
+   void seek(uint32 new_pos);
+
+ protected:
+   bool fill_read_buf(uint32 needed);
 };
 
+// Small writes are collected in a block and written out when it fills up,
+// on seek() and on close().
 class NuvieIOFileWrite : public NuvieIOFileRead
 {
+ protected:
+
+ unsigned char *write_buf;
+ uint32 write_buf_len;
 
  public:
 
-  // NuvieIOFileRead();
-  // virtual ~NuvieIOFileRead();
+   NuvieIOFileWrite();
+   virtual ~NuvieIOFileWrite();
 
    bool open(const char *filename);
    bool open(std::string filename) { return open(filename.c_str()); };
 
+   void close();
+
    bool write1(uint8 src);
    bool write2(uint16 src);
    bool write4(uint32 src);
    virtual uint32 writeBuf(const unsigned char *src, uint32 src_size);
    uint32 write(NuvieIO *src);
 
+   void seek(uint32 new_pos);
+
+ protected:
+   inline unsigned char *get_write_ptr(uint32 len);
+   bool flush();
 };
 #endif /* __NuvieIOFile_h__ */
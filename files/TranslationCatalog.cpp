@@ -0,0 +1,377 @@
+/*
+ *  TranslationCatalog.cpp
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+
+#include "nuvieDefs.h"
+#include "NuvieIOFile.h"
+#include "TranslationCatalog.h"
+
+#define TRANSLATION_CATALOG_MAGIC "NUVIECAT"
+#define TRANSLATION_CATALOG_BYTE_ORDER 0x01020304
+
+// Entry hash: the key hash mixed with table and group.
+static inline uint32 catalog_hash(uint16 table, uint16 group, uint32 key_hash)
+{
+ return key_hash ^ ((((uint32)table << 16) | group) * 0x9e3779b1U);
+}
+
+// FNV-1a
+uint32 TranslationCatalog::hash_key(const char *key, uint32 key_length)
+{
+ uint32 hash = 2166136261U;
+
+ for(uint32 i = 0; i < key_length; i++)
+   hash = (hash ^ (unsigned char)key[i]) * 16777619U;
+
+ return hash;
+}
+
+static bool catalog_text_before(const TranslationCatalogText &t1, const TranslationCatalogText &t2)
+{
+ if(t1.table != t2.table)
+   return t1.table < t2.table;
+ if(t1.group != t2.group)
+   return t1.group < t2.group;
+ return t1.key < t2.key;
+}
+
+TranslationCatalog::TranslationCatalog()
+{
+ data = NULL;
+ data_size = 0;
+ header = NULL;
+ entries = NULL;
+ buckets = NULL;
+ pool = NULL;
+}
+
+TranslationCatalog::~TranslationCatalog()
+{
+ clear();
+}
+
+void TranslationCatalog::clear()
+{
+ if(data)
+   free(data);
+
+ data = NULL;
+ data_size = 0;
+ header = NULL;
+ entries = NULL;
+ buckets = NULL;
+ pool = NULL;
+
+ texts.clear();
+}
+
+void TranslationCatalog::add(uint16 table, uint16 group, const std::string &key, const std::string &value)
+{
+ TranslationCatalogText text;
+
+ text.table = table;
+ text.group = group;
+ text.key = key;
+ text.value = value;
+
+ texts.push_back(text);
+}
+
+/* Lay out everything added so far as a catalog, replacing the current one.
+ * Identical strings are stored once.
+ */
+void TranslationCatalog::build(uint32 content_version)
+{
+ std::vector<TranslationCatalogText> new_texts;
+ std::map<std::string, uint32> pool_offsets;
+ std::string new_pool;
+
+ new_texts.swap(texts);
+ std::stable_sort(new_texts.begin(), new_texts.end(), catalog_text_before);
+
+ // drop all but the last of each key
+ uint32 n = 0;
+ for(uint32 i = 0; i < new_texts.size(); i++)
+   {
+    if(n > 0 && !catalog_text_before(new_texts[n - 1], new_texts[i]))
+      std::swap(new_texts[n - 1], new_texts[i]);
+    else
+      std::swap(new_texts[n++], new_texts[i]);
+   }
+ new_texts.resize(n);
+
+ uint32 num_entries = (uint32)new_texts.size();
+ uint32 num_buckets = 16;
+ while(num_buckets < num_entries * 2)
+   num_buckets *= 2;
+
+ std::vector<TranslationCatalogEntry> new_entries(num_entries);
+ std::vector<uint32> new_buckets(num_buckets, 0);
+
+ for(uint32 i = 0; i < num_entries; i++)
+   {
+    TranslationCatalogText &text = new_texts[i];
+    TranslationCatalogEntry &entry = new_entries[i];
+    const std::string *strings[2] = { &text.key, &text.value };
+    uint32 *offsets[2] = { &entry.key_offset, &entry.value_offset };
+
+    for(uint32 s = 0; s < 2; s++)
+      {
+       std::map<std::string, uint32>::iterator p = pool_offsets.find(*strings[s]);
+       if(p == pool_offsets.end())
+         {
+          p = pool_offsets.insert(std::make_pair(*strings[s], (uint32)new_pool.length())).first;
+          new_pool.append(*strings[s]);
+          new_pool.push_back('\0');
+         }
+       *offsets[s] = p->second;
+      }
+
+    entry.table = text.table;
+    entry.group = text.group;
+    entry.key_length = (uint32)text.key.length();
+    entry.value_length = (uint32)text.value.length();
+    entry.hash = catalog_hash(text.table, text.group, hash_key(text.key.c_str(), entry.key_length));
+
+    uint32 slot = entry.hash & (num_buckets - 1);
+    while(new_buckets[slot])
+      slot = (slot + 1) & (num_buckets - 1);
+    new_buckets[slot] = i + 1;
+   }
+
+ TranslationCatalogHeader new_header;
+ memset(&new_header, 0, sizeof(new_header));
+ memcpy(new_header.magic, TRANSLATION_CATALOG_MAGIC, 8);
+ new_header.byte_order = TRANSLATION_CATALOG_BYTE_ORDER;
+ new_header.format_version = TRANSLATION_CATALOG_VERSION;
+ new_header.content_version = content_version;
+ new_header.num_entries = num_entries;
+ new_header.num_buckets = num_buckets;
+ new_header.entries_offset = sizeof(TranslationCatalogHeader);
+ new_header.buckets_offset = new_header.entries_offset + num_entries * sizeof(TranslationCatalogEntry);
+ new_header.pool_offset = new_header.buckets_offset + num_buckets * sizeof(uint32);
+ new_header.pool_size = (uint32)new_pool.length();
+
+ uint32 new_size = new_header.pool_offset + new_header.pool_size;
+ unsigned char *new_data = (unsigned char *)malloc(new_size);
+
+ memcpy(new_data, &new_header, sizeof(new_header));
+ if(num_entries)
+   memcpy(new_data + new_header.entries_offset, &new_entries[0], num_entries * sizeof(TranslationCatalogEntry));
+ memcpy(new_data + new_header.buckets_offset, &new_buckets[0], num_buckets * sizeof(uint32));
+ if(new_header.pool_size)
+   memcpy(new_data + new_header.pool_offset, new_pool.data(), new_header.pool_size);
+
+ clear();
+ set_data(new_data, new_size, content_version);
+}
+
+/* Use a catalog image, checking that every offset in it stays inside it.
+ * Takes ownership of new_data.
+ */
+bool TranslationCatalog::set_data(unsigned char *new_data, uint32 new_size, uint32 content_version)
+{
+ const TranslationCatalogHeader *h = (const TranslationCatalogHeader *)new_data;
+
+ if(new_data == NULL || new_size < sizeof(TranslationCatalogHeader)
+    || memcmp(h->magic, TRANSLATION_CATALOG_MAGIC, 8) != 0
+    || h->byte_order != TRANSLATION_CATALOG_BYTE_ORDER
+    || h->format_version != TRANSLATION_CATALOG_VERSION
+    || h->content_version != content_version
+    || h->num_entries > new_size / sizeof(TranslationCatalogEntry)
+    || h->num_buckets > new_size / sizeof(uint32)
+    || h->num_buckets == 0 || (h->num_buckets & (h->num_buckets - 1)) != 0
+    || h->num_buckets <= h->num_entries
+    || h->entries_offset != sizeof(TranslationCatalogHeader)
+    || h->buckets_offset != h->entries_offset + h->num_entries * sizeof(TranslationCatalogEntry)
+    || h->pool_offset != h->buckets_offset + h->num_buckets * sizeof(uint32)
+    || h->pool_offset + h->pool_size != new_size
+    || (h->pool_size > 0 && new_data[new_size - 1] != '\0'))
+   {
+    free(new_data);
+    return false;
+   }
+
+ const TranslationCatalogEntry *e = (const TranslationCatalogEntry *)(new_data + h->entries_offset);
+ const uint32 *b = (const uint32 *)(new_data + h->buckets_offset);
+
+ for(uint32 i = 0; i < h->num_entries; i++)
+   {
+    if(e[i].key_offset + e[i].key_length >= h->pool_size || e[i].key_offset + e[i].key_length < e[i].key_offset
+       || e[i].value_offset + e[i].value_length >= h->pool_size || e[i].value_offset + e[i].value_length < e[i].value_offset)
+      {
+       free(new_data);
+       return false;
+      }
+   }
+ for(uint32 i = 0; i < h->num_buckets; i++)
+   {
+    if(b[i] > h->num_entries)
+      {
+       free(new_data);
+       return false;
+      }
+   }
+
+ data = new_data;
+ data_size = new_size;
+ header = h;
+ entries = e;
+ buckets = b;
+ pool = (const char *)(new_data + h->pool_offset);
+
+ return true;
+}
+
+bool TranslationCatalog::load(const std::string &filename, uint32 content_version)
+{
+ NuvieIOFileRead file;
+ unsigned char *new_data;
+ uint32 new_size;
+
+ clear();
+
+ if(file.open(filename) == false)
+   return false;
+
+ new_size = file.get_size();
+ new_data = file.readAll();
+ file.close();
+
+ if(set_data(new_data, new_size, content_version) == false)
+   {
+    DEBUG(0,LEVEL_WARNING,"TranslationCatalog: %s is out of date or damaged\n", filename.c_str());
+    return false;
+   }
+
+ return true;
+}
+
+bool TranslationCatalog::save(const std::string &filename)
+{
+ NuvieIOFileWrite file;
+
+ if(data == NULL || file.open(filename) == false)
+   return false;
+
+ bool ret = (file.writeBuf(data, data_size) == data_size);
+ file.close();
+
+ if(!ret)
+   {
+    DEBUG(0,LEVEL_ERROR,"TranslationCatalog: failed writing %s\n", filename.c_str());
+    remove(filename.c_str());
+   }
+
+ return ret;
+}
+
+const char *TranslationCatalog::find_hashed(uint16 table, uint16 group, const char *key, uint32 key_length, uint32 key_hash, uint32 *value_length)
+{
+ if(header == NULL || header->num_entries == 0)
+   return NULL;
+
+ uint32 hash = catalog_hash(table, group, key_hash);
+ uint32 mask = header->num_buckets - 1;
+
+ for(uint32 slot = hash & mask; buckets[slot]; slot = (slot + 1) & mask)
+   {
+    const TranslationCatalogEntry *entry = &entries[buckets[slot] - 1];
+    if(entry->hash == hash && entry->table == table && entry->group == group
+       && entry->key_length == key_length && memcmp(&pool[entry->key_offset], key, key_length) == 0)
+      {
+       if(value_length)
+         *value_length = entry->value_length;
+       return &pool[entry->value_offset];
+      }
+   }
+
+ return NULL;
+}
+
+// Position of the first entry that isn't before table, group and key.
+uint32 TranslationCatalog::lower_bound(uint16 table, uint16 group, const char *key, uint32 key_length)
+{
+ uint32 first = 0, count = header ? header->num_entries : 0;
+
+ while(count > 0)
+   {
+    uint32 step = count / 2;
+    const TranslationCatalogEntry *entry = &entries[first + step];
+    bool before;
+
+    if(entry->table != table)
+      before = entry->table < table;
+    else if(entry->group != group)
+      before = entry->group < group;
+    else
+      {
+       int cmp = memcmp(&pool[entry->key_offset], key, MIN(entry->key_length, key_length));
+       before = (cmp < 0 || (cmp == 0 && entry->key_length < key_length));
+      }
+
+    if(before)
+      {
+       first += step + 1;
+       count -= step + 1;
+      }
+    else
+      count = step;
+   }
+
+ return first;
+}
+
+const char *TranslationCatalog::find_longer(uint16 table, uint16 group, const std::string &prefix, uint32 *value_length)
+{
+ uint32 prefix_length = (uint32)prefix.length();
+
+ for(uint32 i = lower_bound(table, group, prefix.c_str(), prefix_length); i < get_num_entries(); i++)
+   {
+    const TranslationCatalogEntry *entry = &entries[i];
+    if(entry->table != table || entry->group != group || entry->key_length < prefix_length
+       || memcmp(&pool[entry->key_offset], prefix.c_str(), prefix_length) != 0)
+      break;
+    if(entry->key_length > prefix_length)
+      {
+       if(value_length)
+         *value_length = entry->value_length;
+       return &pool[entry->value_offset];
+      }
+   }
+
+ return NULL;
+}
+
+bool TranslationCatalog::has_group(uint16 table, uint16 group)
+{
+ uint32 i = lower_bound(table, group, "", 0);
+
+ return (i < get_num_entries() && entries[i].table == table && entries[i].group == group);
+}
+
+uint32 TranslationCatalog::get_num_entries(uint16 table)
+{
+ return lower_bound(table + 1, 0, "", 0) - lower_bound(table, 0, "", 0);
+}
@@ -0,0 +1,114 @@
+#ifndef __TranslationCatalog_h__
+#define __TranslationCatalog_h__
+/*
+ *  TranslationCatalog.h
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#define TRANSLATION_CATALOG_VERSION 2 // bump when the file layout changes
+
+typedef struct
+{
+ char magic[8];
+ uint32 byte_order; // written as 0x01020304, the file is rebuilt on other machines
+ uint32 format_version;
+ uint32 content_version; // chosen by the owner, a mismatch means rebuild
+ uint32 num_entries;
+ uint32 num_buckets;
+ uint32 entries_offset;
+ uint32 buckets_offset;
+ uint32 pool_offset;
+ uint32 pool_size;
+} TranslationCatalogHeader;
+
+typedef struct
+{
+ uint32 hash;
+ uint16 table;
+ uint16 group;
+ uint32 key_offset; // into the string pool, strings are NUL terminated
+ uint32 key_length;
+ uint32 value_offset;
+ uint32 value_length;
+} TranslationCatalogEntry;
+
+typedef struct
+{
+ uint16 table;
+ uint16 group;
+ std::string key;
+ std::string value;
+} TranslationCatalogText;
+
+/* A string to string lookup held in one block of memory, which is also the
+ * file format, so a saved catalog is loaded with a single read. Entries belong
+ * to a table and a group inside it (an NPC number, say) and are kept sorted by
+ * table, group and key. A hash index finds exact keys.
+ */
+class TranslationCatalog
+{
+ unsigned char *data;
+ uint32 data_size;
+
+ const TranslationCatalogHeader *header;
+ const TranslationCatalogEntry *entries;
+ const uint32 *buckets; // entry number + 1, 0 when empty
+ const char *pool;
+
+ std::vector<TranslationCatalogText> texts; // added since the last build()
+
+ public:
+
+ TranslationCatalog();
+ ~TranslationCatalog();
+
+ void clear();
+
+ // Collect an entry for build(). If a key is added twice the last value wins.
+ void add(uint16 table, uint16 group, const std::string &key, const std::string &value);
+ void build(uint32 content_version);
+
+ bool load(const std::string &filename, uint32 content_version);
+ bool save(const std::string &filename);
+
+ static uint32 hash_key(const char *key, uint32 key_length);
+
+ const char *find(uint16 table, uint16 group, const char *key, uint32 key_length, uint32 *value_length = NULL)
+   { return find_hashed(table, group, key, key_length, hash_key(key, key_length), value_length); }
+ // Find with a key_hash from hash_key(), for callers that already have it.
+ const char *find_hashed(uint16 table, uint16 group, const char *key, uint32 key_length, uint32 key_hash, uint32 *value_length = NULL);
+ const char *find(uint16 table, uint16 group, const std::string &key, uint32 *value_length = NULL)
+   { return find(table, group, key.c_str(), (uint32)key.length(), value_length); }
+ // Value of the first key in order that is longer than prefix and starts with it.
+ const char *find_longer(uint16 table, uint16 group, const std::string &prefix, uint32 *value_length = NULL);
+ bool has_group(uint16 table, uint16 group);
+
+ uint32 get_num_entries() { return header ? header->num_entries : 0; }
+ uint32 get_num_entries(uint16 table);
+ uint32 get_size() { return data_size; }
+
+ protected:
+
+ uint32 lower_bound(uint16 table, uint16 group, const char *key, uint32 key_length);
+ bool set_data(unsigned char *new_data, uint32 new_size, uint32 content_version);
+};
+
+#endif /* __TranslationCatalog_h__ */
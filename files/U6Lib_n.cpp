@@ -25,6 +25,8 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cctype>
+#include <list>
+#include <map>
 
 #include "nuvieDefs.h"
 #include "U6misc.h"
@@ -34,6 +36,20 @@
 
 #include "U6Lib_n.h"
 
+// Decompressed items shared by every library opened from a file, so items
+// that are loaded again and again (portraits, conversations, cutscene images)
+// are only inflated once. The least recently used items are dropped first.
+struct U6LibCacheEntry
+{
+ string key;
+ unsigned char *data;
+ uint32 size;
+};
+
+static std::list<U6LibCacheEntry> item_cache; // most recently used first
+static std::map<string, std::list<U6LibCacheEntry>::iterator> item_cache_index;
+static uint32 item_cache_bytes = 0;
+
 U6Lib_n::U6Lib_n()
 {
  num_offsets = 0;
@@ -62,6 +78,7 @@ bool U6Lib_n::open(std::string &filename, uint8 size, uint8 type)
    }
 
  del_data = true;
+ cache_name = filename;
 
  return open((NuvieIO *)file, size, type);
 }
@@ -97,6 +114,7 @@ void U6Lib_n::close()
 
  data = NULL;
  del_data = false;
+ cache_name.clear();
 
  num_offsets = 0;
 
@@ -164,22 +182,124 @@ unsigned char *U6Lib_n::get_item(uint32 item_number, unsigned char *ret_buf)
  else
    buf = ret_buf;
 
- data->seek(item->offset);
-
  if(is_compressed(item_number))
   {
+   if(get_cached_item(item_number, false, buf, NULL))
+     return buf;
+
    U6Lzw lzw;
    lzw_buf = (unsigned char *)malloc(item->size);
+   data->seek(item->offset);
    data->readToBuf(lzw_buf,item->size);
-   lzw.decompress_buffer(lzw_buf, item->size, buf, item->uncomp_size);
+   if(lzw.decompress_buffer(lzw_buf, item->size, buf, item->uncomp_size))
+     cache_item(item_number, false, buf, item->uncomp_size);
+   free(lzw_buf);
   }
  else
  {
+   data->seek(item->offset);
    data->readToBuf(buf,item->size);
  }
  return buf;
 }
 
+/* Read an item stored in U6Lzw form and return it decompressed, with its
+ * length. Returns NULL if the item is missing or isn't valid LZW data. Items
+ * starting with an uncompressed length of 0 are stored as they are.
+ */
+unsigned char *U6Lib_n::get_item_lzw(uint32 item_number, uint32 &length)
+{
+ unsigned char *lzw_data, *buf;
+ U6Lzw lzw;
+
+ buf = get_cached_item(item_number, true, NULL, &length);
+ if(buf)
+   return buf;
+
+ lzw_data = get_item(item_number);
+ if(lzw_data == NULL)
+   return NULL;
+
+ if(get_item_size(item_number) < 4
+    || (lzw_data[0] == 0 && lzw_data[1] == 0 && lzw_data[2] == 0 && lzw_data[3] == 0))
+  {
+   free(lzw_data);
+   return NULL;
+  }
+
+ buf = lzw.decompress_buffer(lzw_data, get_item_size(item_number), length);
+ free(lzw_data);
+
+ if(buf)
+   cache_item(item_number, true, buf, length);
+
+ return buf;
+}
+
+static string get_item_cache_key(string &name, uint32 item_number, bool lzw)
+{
+ char num[16];
+ sprintf(num, ":%u%s", item_number, lzw ? "z" : "");
+ return name + num;
+}
+
+/* Copy a cached item into ret_buf, or into a new buffer if ret_buf is NULL.
+ * Returns NULL if the item isn't in the cache.
+ */
+unsigned char *U6Lib_n::get_cached_item(uint32 item_number, bool lzw, unsigned char *ret_buf, uint32 *length)
+{
+ if(cache_name.empty())
+   return NULL;
+
+ std::map<string, std::list<U6LibCacheEntry>::iterator>::iterator i;
+ i = item_cache_index.find(get_item_cache_key(cache_name, item_number, lzw));
+ if(i == item_cache_index.end())
+   return NULL;
+
+ item_cache.splice(item_cache.begin(), item_cache, i->second); // now most recent
+
+ U6LibCacheEntry &entry = *i->second;
+ if(ret_buf == NULL)
+   ret_buf = (unsigned char *)malloc(entry.size);
+ memcpy(ret_buf, entry.data, entry.size);
+ if(length)
+   *length = entry.size;
+
+ return ret_buf;
+}
+
+/* Keep a copy of a decompressed item, dropping old items to stay under
+ * U6LIB_CACHE_SIZE. Big items aren't kept.
+ */
+void U6Lib_n::cache_item(uint32 item_number, bool lzw, unsigned char *buf, uint32 length)
+{
+ if(cache_name.empty() || length == 0 || length > U6LIB_CACHE_SIZE / 8)
+   return;
+
+ string key = get_item_cache_key(cache_name, item_number, lzw);
+ if(item_cache_index.find(key) != item_cache_index.end())
+   return;
+
+ while(item_cache_bytes + length > U6LIB_CACHE_SIZE)
+  {
+   U6LibCacheEntry &oldest = item_cache.back();
+   item_cache_bytes -= oldest.size;
+   item_cache_index.erase(oldest.key);
+   free(oldest.data);
+   item_cache.pop_back();
+  }
+
+ U6LibCacheEntry entry;
+ entry.key = key;
+ entry.data = (unsigned char *)malloc(length);
+ entry.size = length;
+ memcpy(entry.data, buf, length);
+
+ item_cache.push_front(entry);
+ item_cache_index[key] = item_cache.begin();
+ item_cache_bytes += length;
+}
+
 bool U6Lib_n::is_compressed(uint32 item_number)
 {
  uint32 i;
@@ -32,6 +32,8 @@ using std::string;
 
 class NuvieIO;
 
+#define U6LIB_CACHE_SIZE 0x200000 // bytes of decompressed items kept for reuse
+
 struct U6LibItem
 {
  uint32 offset;
@@ -51,6 +53,7 @@ class U6Lib_n
  U6LibItem *items;
  NuvieIO *data;
  bool del_data;
+ string cache_name; // file name used in cache keys, empty if not cached
 
 public:
    U6Lib_n();
@@ -63,6 +66,7 @@ public:
    uint8 get_game_type() { return game_type;}
 
    unsigned char *get_item(uint32 item_number, unsigned char *buf=NULL); // read
+   unsigned char *get_item_lzw(uint32 item_number, uint32 &length); // read and U6Lzw decompress
    void set_item_data(uint32 item_number, unsigned char *src, uint32 src_len);
 
    uint32 get_num_items();
@@ -86,6 +90,9 @@ protected:
    void calculate_item_sizes();
    uint32 calculate_item_uncomp_size(U6LibItem *item);
    uint32 calculate_num_offsets(bool skip4);
+
+   unsigned char *get_cached_item(uint32 item_number, bool lzw, unsigned char *ret_buf, uint32 *length);
+   void cache_item(uint32 item_number, bool lzw, unsigned char *buf, uint32 length);
 };
 
 #if 0
@@ -22,14 +22,12 @@
 U6Lzw::U6Lzw()
 {
  dict = new U6LzwDict;
- stack = new U6LzwStack;
  errstr = "unknown error";
 }
 
 U6Lzw::~U6Lzw()
 {
  delete dict;
- delete stack;
 }
 
 
@@ -140,8 +138,7 @@ long U6Lzw::get_uncompressed_buffer_size(unsigned char *buf, uint32 length)
 
  // -----------------------------------------------------------------------------
  // LZW-decompress from buffer to buffer.
- // The parameters "source_length" and "destination_length" are currently unused.
- // They might be used to prevent reading/writing outside the buffers.
+ // Reading stops with an error instead of going past the end of either buffer.
  // -----------------------------------------------------------------------------
 
 unsigned char *U6Lzw::decompress_buffer(unsigned char *source, uint32 source_length, uint32 &destination_length)
@@ -171,21 +168,37 @@ bool U6Lzw::decompress_buffer(unsigned char *source, uint32 source_length, unsig
     const int max_codeword_length = 12;
     bool end_marker_reached = false;
     int codeword_size = 9;
-    long bits_read = 0;
+    uint32 bits_read = 0;
+    uint32 bits_available;
     int next_free_codeword = 0x102;
     int dictionary_size = 0x200;
 
-    long bytes_written = 0;
+    uint32 bytes_written = 0;
+    uint32 pW_position = 0; // where the string for pW was written
+    uint32 cW_position;
 
     int cW;
     int pW = 0;  // get rid of uninitialized warning.
-    unsigned char C;
+
+    if(source_length < 6)
+    {
+       errstr = "decompress_buffer: source too short";
+       return(false);
+    }
 
     source += 4; //skip the filesize dword.
+    bits_available = (source_length - 4) * 8;
 
     while (! end_marker_reached)
     {
+       if(bits_read + codeword_size > bits_available)
+       {
+          errstr = "decompress_buffer: end of source before end marker";
+          DEBUG(0,LEVEL_ERROR,"U6Lzw: %s\n", errstr);
+          return(false);
+       }
        cW = get_next_codeword(&bits_read, source, codeword_size);
+       cW_position = bytes_written;
        switch (cW)
        {
        // re-init the dictionary
@@ -193,9 +206,15 @@ bool U6Lzw::decompress_buffer(unsigned char *source, uint32 source_length, unsig
            codeword_size = 9;
            next_free_codeword = 0x102;
            dictionary_size = 0x200;
-           dict->reset();
-           cW = get_next_codeword(&bits_read, source, codeword_size);
-           output_root((unsigned char)cW, destination, &bytes_written);
+           if(bits_read + codeword_size > bits_available)
+           {
+              errstr = "decompress_buffer: end of source after dictionary reset";
+              return(false);
+           }
+           cW = get_next_codeword(&bits_read, source, codeword_size) & 0xff;
+           cW_position = bytes_written;
+           if(!output_string(cW, destination, destination_length, &bytes_written))
+              return(false);
            break;
        // end of compressed file has been reached
        case 0x101:
@@ -205,63 +224,52 @@ bool U6Lzw::decompress_buffer(unsigned char *source, uint32 source_length, unsig
        default:
            if (cW < next_free_codeword)  // codeword is already in the dictionary
            {
-              // create the string associated with cW (on the stack)
-              get_string(cW);
-              C = stack->gettop();
               // output the string represented by cW
-              while (!stack->is_empty())
-              {
-                 output_root(stack->pop(), destination, &bytes_written);
-              }
-              // add pW+C to the dictionary
-              dict->add(C,pW);
-
-              next_free_codeword++;
-              if (next_free_codeword >= dictionary_size)
-              {
-                 if (codeword_size < max_codeword_length)
-                 {
-                    codeword_size += 1;
-                    dictionary_size *= 2;
-                 }
-              }
+              if(!output_string(cW, destination, destination_length, &bytes_written))
+                 return(false);
            }
            else  // codeword is not yet defined
            {
-              // create the string associated with pW (on the stack)
-              get_string(pW);
-              C = stack->gettop();
-              // output the string represented by pW
-              while (!stack->is_empty())
-              {
-                 output_root(stack->pop(), destination, &bytes_written);
-              }
-              // output the char C
-              output_root(C, destination, &bytes_written);
               // the new dictionary entry must correspond to cW
               // if it doesn't, something is wrong with the lzw-compressed data.
               if (cW != next_free_codeword)
               {
                  DEBUG(0,LEVEL_ERROR,"cW != next_free_codeword!\n");
+                 errstr = "decompress_buffer: bad codeword";
                  return(false);
               }
-              // add pW+C to the dictionary
-              dict->add(C,pW);
+              // output the string represented by pW, then its first char
+              if(!output_string(pW, destination, destination_length, &bytes_written))
+                 return(false);
+              if(bytes_written >= destination_length)
+              {
+                 errstr = "decompress_buffer: destination too small";
+                 return(false);
+              }
+              destination[bytes_written++] = destination[pW_position];
+           }
+           // add pW+C to the dictionary. C starts the output for cW, which
+           // follows the output for pW.
+           if(next_free_codeword < U6LZW_DICT_SIZE)
+           {
+              dict->offset[next_free_codeword] = pW_position;
+              dict->length[next_free_codeword] = (pW > 0xff ? dict->length[pW] : 1) + 1;
+           }
 
-              next_free_codeword++;
-              if (next_free_codeword >= dictionary_size)
+           next_free_codeword++;
+           if (next_free_codeword >= dictionary_size)
+           {
+              if (codeword_size < max_codeword_length)
               {
-                 if (codeword_size < max_codeword_length)
-                 {
-                    codeword_size += 1;
-                    dictionary_size *= 2;
-                 }
+                 codeword_size += 1;
+                 dictionary_size *= 2;
               }
-           };
+           }
            break;
        }
        // shift roles - the current cW becomes the new pW
        pW = cW;
+       pW_position = cW_position;
     }
 
  return true;
@@ -324,161 +332,46 @@ unsigned char *U6Lzw::decompress_file(std::string filename, uint32 &destination_
  // ----------------------------------------------
  // Read the next code word from the source buffer
  // ----------------------------------------------
-int U6Lzw::get_next_codeword (long *bits_read, unsigned char *source, int codeword_size)
+inline int U6Lzw::get_next_codeword(uint32 *bits_read, unsigned char *source, int codeword_size)
 {
-    unsigned char b0,b1,b2;
+    unsigned char *b = &source[*bits_read/8];
     int codeword;
 
-    b0 = source[*bits_read/8];
-    b1 = source[*bits_read/8+1];
+    codeword = (b[0] + (b[1] << 8));
     if (codeword_size + (*bits_read % 8) > 16)
-      b2 = source[*bits_read/8+2]; // only read next byte if necessary
-    else
-      b2 = 0;
+      codeword += (b[2] << 16); // only read next byte if necessary
 
-    codeword = ((b2 << 16) + (b1 << 8) + b0);
-    codeword = codeword >> (*bits_read % 8);
-    switch (codeword_size)
-    {
-     case 0x9:
-         codeword = codeword & 0x1ff;
-         break;
-     case 0xa:
-         codeword = codeword & 0x3ff;
-         break;
-     case 0xb:
-         codeword = codeword & 0x7ff;
-         break;
-     case 0xc:
-         codeword = codeword & 0xfff;
-         break;
-     default:
-         DEBUG(0,LEVEL_ERROR,"U6Lzw Error: weird codeword size!\n");
-         break;
-    }
+    codeword = (codeword >> (*bits_read % 8)) & ((1 << codeword_size) - 1);
     *bits_read += codeword_size;
 
     return (codeword);
 }
 
-void U6Lzw::output_root(unsigned char root, unsigned char *destination, long *position)
-{
-    destination[*position] = root;
-    *position = *position + 1;
-}
-
-void U6Lzw::get_string(int codeword)
+/* Copy the string for `codeword' to the end of the output. Dictionary strings
+ * are copied in one go from where they were first written.
+ */
+inline bool U6Lzw::output_string(int codeword, unsigned char *destination, uint32 destination_length, uint32 *position)
 {
-    unsigned char root;
-    int current_codeword;
-
-    current_codeword = codeword;
-    stack->reset();
-    while (current_codeword > 0xff)
+    if(codeword <= 0xff)
     {
-       root = dict->get_root(current_codeword);
-       current_codeword = dict->get_codeword(current_codeword);
-       stack->push(root);
+       if(*position >= destination_length)
+       {
+          errstr = "decompress_buffer: destination too small";
+          return(false);
+       }
+       destination[(*position)++] = (unsigned char)codeword;
+       return(true);
     }
 
-    // push the root at the leaf
-    stack->push((unsigned char)current_codeword);
-}
-
-
-U6LzwStack::U6LzwStack()
-{
- memset(stack, 0, STACK_SIZE);
- this->reset();
-}
-
-void U6LzwStack::reset(void)
-{
- contains = 0;
-}
-
-bool U6LzwStack::is_empty(void)
-{
- if(contains == 0)
-   return true;
-
- return false;
-}
-
-bool U6LzwStack::is_full(void)
-{
- if(contains==STACK_SIZE)
-    return true;
-
- return false;
-}
-
-void U6LzwStack::push(unsigned char element)
-{
- if(!this->is_full())
-   {
-    stack[contains] = element;
-    contains++;
-   }
-}
-
-unsigned char U6LzwStack::pop(void)
-{
- unsigned char element;
-
- if(!this->is_empty())
- {
-  element = stack[contains-1];
-  contains--;
- }
-  else
- {
-  element = 0;
- }
- return(element);
-}
-
-unsigned char U6LzwStack::gettop(void)
-{
- if(!this->is_empty())
-   {
-    return(stack[contains-1]);
-   }
-
- return '\0'; /* what should we return here!? */
-}
-
-/*
-   --------------------------------------------------
-   a dictionary class
-   --------------------------------------------------
-*/
-
-U6LzwDict::U6LzwDict()
-{
- this->reset();
- memset(&dict, 0, sizeof(dict));
-}
-
-void U6LzwDict::reset(void)
-{
- contains = 0x102;
-}
-
-void U6LzwDict::add(unsigned char root, int codeword)
-{
- dict[contains].root = root;
- dict[contains].codeword = codeword;
- contains++;
-}
-
-unsigned char U6LzwDict::get_root(int codeword)
-{
- return (dict[codeword].root);
-}
+    uint32 length = dict->length[codeword];
+    if(length > destination_length - *position)
+    {
+       errstr = "decompress_buffer: destination too small";
+       return(false);
+    }
+    // the earlier copy always ends before *position
+    memcpy(&destination[*position], &destination[dict->offset[codeword]], length);
+    *position += length;
 
-int U6LzwDict::get_codeword(int codeword)
-{
- return (dict[codeword].codeword);
+    return(true);
 }
-
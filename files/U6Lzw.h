@@ -5,55 +5,19 @@
 
 class NuvieIOFileRead;
 
-// LZW Stack
-
-#define STACK_SIZE 10000
-
-class U6LzwStack
-{
-protected:
-   unsigned char stack[STACK_SIZE];
-   int contains;
-
-public:
-   U6LzwStack();
-
-   void reset(void);
-   bool is_empty(void);
-   bool is_full(void);
-   void push(unsigned char element);
-   unsigned char pop(void);
-   unsigned char gettop(void);
-};
-
 // LZW dictionary
 
-#define DICT_SIZE 10000
+#define U6LZW_DICT_SIZE 4096 // codewords are at most 12 bits long
 
+// Every string in the dictionary has already been written to the output, so
+// an entry is just where it was written and how long it is.
 typedef struct {
-      unsigned char root;
-      int codeword;
-      int contains;
-   } dict_entry;
-
-class U6LzwDict
-{
-   dict_entry dict[DICT_SIZE];
-   int contains;
-
- public:
-
-   U6LzwDict();
-
-   void reset(void);
-   void add(unsigned char root, int codeword);
-   unsigned char get_root(int codeword);
-   int get_codeword(int codeword);
-};
+   uint32 offset[U6LZW_DICT_SIZE];
+   uint16 length[U6LZW_DICT_SIZE];
+} U6LzwDict;
 
 class U6Lzw
 {
- U6LzwStack *stack;
  U6LzwDict *dict;
  const char *errstr; // error string
  public:
@@ -75,11 +39,10 @@ class U6Lzw
   long get_uncompressed_file_size(NuvieIOFileRead *input_file);
   long get_uncompressed_buffer_size(unsigned char *buf, uint32 length);
 
-  int get_next_codeword (long *bits_read, unsigned char *source,
-                         int codeword_size);
-  void output_root(unsigned char root, unsigned char *destination,
-                   long *position);
-  void get_string(int codeword);
+  inline int get_next_codeword(uint32 *bits_read, unsigned char *source,
+                                int codeword_size);
+  inline bool output_string(int codeword, unsigned char *destination,
+                            uint32 destination_length, uint32 *position);
 };
 
 #endif /* __U6Lzw_h__ */
@@ -46,10 +46,17 @@ KoreanFont::KoreanFont()
 
     // Anti-aliasing disabled by default
     enable_antialiasing = false;
+
+    glyph_cache_hits = 0;
+    glyph_cache_misses = 0;
 }
 
 KoreanFont::~KoreanFont()
 {
+    DEBUG(0, LEVEL_INFORMATIONAL, "KoreanFont: glyph cache %d hits, %d misses\n",
+          glyph_cache_hits, glyph_cache_misses);
+    clearGlyphCache();
+
     if (font_surface)
     {
         SDL_FreeSurface(font_surface);
@@ -88,6 +95,9 @@ bool KoreanFont::init(const std::string &bmp_path, const std::string &charmap_pa
     DEBUG(0, LEVEL_INFORMATIONAL, "KoreanFont: Loaded %dx%d sprite sheet, cell %dx%d, %d chars\n",
           font_surface->w, font_surface->h, cell_width, cell_height, total_chars);
 
+    clearGlyphCache();
+    glyph_cache.assign(total_chars, (GlyphCacheEntry *)NULL);
+
     // Load character width data (.dat file)
     std::string dat_path = bmp_path;
     size_t dot_pos = dat_path.rfind('.');
@@ -372,11 +382,6 @@ uint16 KoreanFont::drawCharUnicode(Screen *screen, uint32 codepoint, uint16 x, u
     if (index >= total_chars)
         index = 0; // Fallback to first char (space)
 
-    // Calculate source position in sprite sheet
-    uint16 src_x = (index % chars_per_row) * cell_width;
-    uint16 src_y = (index / chars_per_row) * cell_height;
-
-    // Get character width first (needed for buffer sizing)
     uint16 char_advance;
     if (char_widths && index < total_chars)
     {
@@ -394,28 +399,117 @@ uint16 KoreanFont::drawCharUnicode(Screen *screen, uint32 codepoint, uint16 x, u
         }
     }
 
-    // Blit width: use full cell_width for rendering (character is centered in cell)
-    // but return char_advance for text positioning
-    uint16 blit_width = cell_width;
+    if (scale < 1)
+        scale = 1;
+    else if (scale > KOREANFONT_MAX_SCALE)
+        scale = KOREANFONT_MAX_SCALE;
+
+    // Glyphs are rendered from the full cell (character is centered in cell)
+    // but char_advance is returned for text positioning
+    const uint8 *mask = getGlyphMask(index, scale);
+    if (mask)
+        screen->blitmask(x, y, mask, cell_width * scale, cell_height * scale, color);
+
+    // Add extra letter spacing (2 pixels for ASCII, 4 for Korean)
+    uint16 spacing = (codepoint >= 0xAC00 && codepoint <= 0xD7A3) ? 4 : 2;
+    uint16 final_width = char_advance + spacing;
+
+    return final_width * scale;
+}
+
+KoreanFont::GlyphCacheEntry *KoreanFont::getGlyph(uint16 index)
+{
+    if (index >= glyph_cache.size())
+        return NULL;
+
+    GlyphCacheEntry *glyph = glyph_cache[index];
+    if (glyph)
+        return glyph;
+
+    glyph = new GlyphCacheEntry;
+    memset(glyph->mask, 0, sizeof(glyph->mask));
+
+    uint32 mask_size = cell_width * cell_height;
+    glyph->mask[0] = (uint8 *)malloc(mask_size);
+    decodeGlyph(index, glyph->mask[0]);
+
+    glyph->empty = true;
+    for (uint32 i = 0; i < mask_size; i++)
+    {
+        if (glyph->mask[0][i])
+        {
+            glyph->empty = false;
+            break;
+        }
+    }
+
+    glyph_cache[index] = glyph;
+    return glyph;
+}
+
+// Returns the coverage mask for index at the given scale, building it on first
+// use. Returns NULL if the glyph has nothing to draw.
+const uint8 *KoreanFont::getGlyphMask(uint16 index, uint8 scale)
+{
+    bool miss = (index >= glyph_cache.size() || glyph_cache[index] == NULL);
+
+    GlyphCacheEntry *glyph = getGlyph(index);
+    if (!glyph)
+        return NULL;
+
+    uint8 *mask = glyph->empty ? NULL : glyph->mask[scale - 1];
+    if (!mask && !glyph->empty)
+    {
+        miss = true;
 
-    // Create buffer for the character (0xff = transparent)
-    // Support up to 64x64 cells (for 48x48 font and potential larger fonts)
-    unsigned char buf[64 * 64];
-    memset(buf, 0xff, blit_width * cell_height);
+        // Replicate each source pixel into a scale x scale block
+        uint16 scaled_w = cell_width * scale;
+        mask = (uint8 *)malloc(scaled_w * cell_height * scale);
+
+        const uint8 *src = glyph->mask[0];
+        uint8 *dest = mask;
+        for (uint16 py = 0; py < cell_height; py++)
+        {
+            for (uint16 px = 0; px < cell_width; px++)
+                memset(dest + px * scale, src[px], scale);
+
+            for (uint8 i = 1; i < scale; i++)
+                memcpy(dest + i * scaled_w, dest, scaled_w);
+
+            src += cell_width;
+            dest += scaled_w * scale;
+        }
+
+        glyph->mask[scale - 1] = mask;
+    }
+
+    if (miss)
+        glyph_cache_misses++;
+    else
+        glyph_cache_hits++;
+
+    return mask;
+}
+
+// Read one cell out of the sprite sheet into an 8-bit coverage mask
+void KoreanFont::decodeGlyph(uint16 index, uint8 *mask)
+{
+    uint16 src_x = (index % chars_per_row) * cell_width;
+    uint16 src_y = (index / chars_per_row) * cell_height;
+
+    memset(mask, 0, cell_width * cell_height);
 
-    // Lock font surface to read pixels
     if (SDL_MUSTLOCK(font_surface))
         SDL_LockSurface(font_surface);
 
-    // Read pixels from BMP and convert to game palette
-    // BMP has white text (255,255,255) on magenta background (255,0,255)
+    // BMP has light text on a magenta background
     uint8 *src_pixels = (uint8 *)font_surface->pixels;
     int bpp = font_surface->format->BytesPerPixel;
     int pitch = font_surface->pitch;
 
     for (int py = 0; py < cell_height; py++)
     {
-        for (int px = 0; px < blit_width; px++)
+        for (int px = 0; px < cell_width; px++)
         {
             uint8 *pixel = src_pixels + (src_y + py) * pitch + (src_x + px) * bpp;
 
@@ -423,8 +517,7 @@ uint16 KoreanFont::drawCharUnicode(Screen *screen, uint32 codepoint, uint16 x, u
             if (bpp == 1)
             {
                 // 8-bit indexed
-                SDL_Color *colors = font_surface->format->palette->colors;
-                SDL_Color c = colors[*pixel];
+                SDL_Color c = font_surface->format->palette->colors[*pixel];
                 r = c.r; g = c.g; b = c.b;
             }
             else if (bpp == 3 || bpp == 4)
@@ -442,37 +535,33 @@ uint16 KoreanFont::drawCharUnicode(Screen *screen, uint32 codepoint, uint16 x, u
                 r = g = b = 0;
             }
 
-            // Background is magenta (241, 15, 196) - transparent
-            // Text is brown/tan color
-            // Magenta: high R, low G, high B (around 241, 15, 196)
+            // Background is magenta (around 241, 15, 196) - transparent
             bool is_magenta = (r > 180 && g < 60 && b > 150);
             if (!is_magenta && (r > 50 || g > 50 || b > 50))
-            {
-                buf[py * blit_width + px] = color;
-            }
-            // else: leave as 0xff (transparent)
+                mask[py * cell_width + px] = 0xff;
         }
     }
 
     if (SDL_MUSTLOCK(font_surface))
         SDL_UnlockSurface(font_surface);
+}
 
-    // Blit using appropriate scale function with transparency
-    if (scale >= 4) {
-        screen->blit4x(x, y, buf, 8, blit_width, cell_height, blit_width, true, NULL);
-    } else if (scale == 3) {
-        screen->blit3x(x, y, buf, 8, blit_width, cell_height, blit_width, true, NULL);
-    } else if (scale >= 2) {
-        screen->blit2x(x, y, buf, 8, blit_width, cell_height, blit_width, true);
-    } else {
-        screen->blit(x, y, buf, 8, blit_width, cell_height, blit_width, true);
-    }
-
-    // Add extra letter spacing (2 pixels for ASCII, 4 for Korean)
-    uint16 spacing = (codepoint >= 0xAC00 && codepoint <= 0xD7A3) ? 4 : 2;
-    uint16 final_width = char_advance + spacing;
+void KoreanFont::clearGlyphCache()
+{
+    for (size_t i = 0; i < glyph_cache.size(); i++)
+    {
+        GlyphCacheEntry *glyph = glyph_cache[i];
+        if (!glyph)
+            continue;
 
-    return final_width * scale;
+        for (int s = 0; s < KOREANFONT_MAX_SCALE; s++)
+        {
+            if (glyph->mask[s])
+                free(glyph->mask[s]);
+        }
+        delete glyph;
+    }
+    glyph_cache.clear();
 }
 
 bool KoreanFont::hasChar(uint32 codepoint)
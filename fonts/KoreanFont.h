@@ -23,10 +23,13 @@
 #include "Font.h"
 #include <string>
 #include <map>
+#include <vector>
 
 class Configuration;
 class Screen;
 
+#define KOREANFONT_MAX_SCALE 4
+
 // Korean font class that supports UTF-8 encoded Korean text
 // Uses BMP sprite sheet with character mapping
 
@@ -50,6 +53,23 @@ private:
     // Anti-aliasing option
     bool enable_antialiasing;
 
+    // Glyph cache: coverage masks decoded from font_surface on first use,
+    // indexed by sprite index. mask[s-1] is the glyph pre-scaled by s,
+    // (cell_width*s) x (cell_height*s) bytes, 0 = transparent, 0xff = ink.
+    struct GlyphCacheEntry
+    {
+        uint8 *mask[KOREANFONT_MAX_SCALE];
+        bool empty;                 // no ink at all (space etc.)
+    };
+    std::vector<GlyphCacheEntry *> glyph_cache;
+    uint32 glyph_cache_hits;
+    uint32 glyph_cache_misses;
+
+    GlyphCacheEntry *getGlyph(uint16 index);
+    const uint8 *getGlyphMask(uint16 index, uint8 scale);
+    void decodeGlyph(uint16 index, uint8 *mask);
+    void clearGlyphCache();
+
 public:
     KoreanFont();
     ~KoreanFont();
@@ -88,6 +108,10 @@ public:
     // Check if this font supports a character
     bool hasChar(uint32 codepoint);
 
+    // Glyph cache statistics
+    uint32 getGlyphCacheHits() const { return glyph_cache_hits; }
+    uint32 getGlyphCacheMisses() const { return glyph_cache_misses; }
+
     // Anti-aliasing control
     void setAntialiasing(bool enable) { enable_antialiasing = enable; }
     bool isAntialiasingEnabled() const { return enable_antialiasing; }
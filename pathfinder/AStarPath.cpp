@@ -2,8 +2,18 @@
 #include "nuvieDefs.h"
 #include "DirFinder.h"
 #include "AStarPath.h"
-AStarPath::AStarPath() : final_node(0)
-{}void AStarPath::create_path()
+AStarPath::AStarPath() : nodes_used(0), push_count(0), final_node(0)
+{
+    node_table.assign(ASTAR_NODE_TABLE_MIN, (astar_node *)NULL);
+}
+
+AStarPath::~AStarPath()
+{
+    for(uint32 b = 0; b < node_blocks.size(); b++)
+        delete[] node_blocks[b];
+}
+
+void AStarPath::create_path()
 {    astar_node *i = final_node; // iterator through steps, from back
     delete_path();
     std::vector<astar_node *> reverse_list;
@@ -19,59 +29,47 @@ AStarPath::AStarPath() : final_node(0)
         reverse_list.pop_back();
     }
     set_path_size(step_count);
-}/* Get a new neighbor to nnode and score it, returning true if it's usable. */
-bool AStarPath::score_to_neighbor(sint8 dir, astar_node *nnode, astar_node *neighbor,
+}/* Get the location of a neighbor to nnode and the cost to reach it, returning
+ * true if it's usable. */
+bool AStarPath::score_to_neighbor(sint8 dir, astar_node *nnode, MapCoord &neighbor_loc,
                                   sint32 &nnode_to_neighbor)
 {    sint8 sx = -1, sy = -1;
     DirFinder::get_adjacent_dir(sx, sy, dir); // sx,sy = neighbor -1,-1 + dir
     // get neighbor of nnode towards sx,sy, and cost to that neighbor
-    neighbor->loc = nnode->loc.abs_coords(sx, sy);
-    nnode_to_neighbor = step_cost(nnode->loc, neighbor->loc);
+    neighbor_loc = nnode->loc.abs_coords(sx, sy);
+    nnode_to_neighbor = step_cost(nnode->loc, neighbor_loc);
     if(nnode_to_neighbor == -1)
-    {
-        delete neighbor; // this neighbor is blocked
-        return false;
-    }
+        return false; // this neighbor is blocked
     return true;
-}/* Compare a node's score to the start node to already scored neighbors. */
-bool AStarPath::compare_neighbors(astar_node *nnode, astar_node *neighbor,
-                                  sint32 nnode_to_neighbor, astar_node *in_open,
-                                  astar_node *in_closed)
-{    neighbor->to_start = nnode->to_start + nnode_to_neighbor;
-     // ignore this neighbor if already checked and closer to start
-    if((in_open && in_open->to_start <= neighbor->to_start)
-       || (in_closed && in_closed->to_start <= neighbor->to_start))
-    {
-        delete neighbor;
-        return false;
-    }
-    return true;
-}/* Check all neighbors of a node (location) and save them to the "seen" list. */
+}/* Check all neighbors of a node (location) and open the ones that are new or
+ * reached more cheaply than before. */
 bool AStarPath::search_node_neighbors(astar_node *nnode, MapCoord &goal,
                                       const uint32 max_score)
 {    for(uint32 dir = 1; dir < 8; dir += 2)
     {
-        astar_node *neighbor = new astar_node;
+        MapCoord neighbor_loc;
         sint32 nnode_to_neighbor = -1;
-        if(!score_to_neighbor(dir, nnode, neighbor, nnode_to_neighbor))
+        if(!score_to_neighbor(dir, nnode, neighbor_loc, nnode_to_neighbor))
             continue; // this neighbor is blocked
-        astar_node *in_open = find_open_node(neighbor),
-                   *in_closed = find_closed_node(neighbor);
-        if(!compare_neighbors(nnode, neighbor, nnode_to_neighbor, in_open, in_closed))
+        astar_node *neighbor = find_node(neighbor_loc);
+        uint32 to_start = nnode->to_start + nnode_to_neighbor;
+        // ignore this neighbor if already checked and closer to start
+        if(neighbor && neighbor->to_start <= to_start)
             continue;
+        uint32 to_goal = neighbor ? neighbor->to_goal : path_cost_est(neighbor_loc, goal);
+        if(to_start + to_goal > max_score)
+            continue; // too far away
+        if(!neighbor)
+            neighbor = new_node(neighbor_loc);
         neighbor->parent = nnode;
-        neighbor->to_goal = path_cost_est(neighbor->loc, goal);
-        neighbor->score = neighbor->to_start + neighbor->to_goal;
+        neighbor->to_start = to_start;
+        neighbor->to_goal = to_goal;
+        neighbor->score = to_start + to_goal;
         neighbor->len = nnode->len + 1;
-        if(neighbor->score > max_score)
-        {
-            delete neighbor; // too far away
-            continue;
-        }
-        // take neighbor out of closed list and put into open list
-        if(in_closed)
-            remove_closed_node(in_closed);
-        if(!in_open)
+        // a closed neighbor is put back into the open set
+        if(neighbor->state == ASTAR_NODE_OPEN)
+            update_open_node(neighbor);
+        else
             push_open_node(neighbor);
     }
     return true;
@@ -82,8 +80,7 @@ bool AStarPath::search_node_neighbors(astar_node *nnode, MapCoord &goal,
  * Returns true if a path is created
  */bool AStarPath::path_search(MapCoord &start, MapCoord &goal)
 {//DEBUG(0,LEVEL_DEBUGGING,"SEARCH: %d: %d,%d -> %d,%d\n",actor->get_actor_num(),start.x,start.y,goal.x,goal.y);
-    astar_node *start_node = new astar_node;
-    start_node->loc = start;
+    astar_node *start_node = new_node(start);
     start_node->to_start = 0;
     start_node->to_goal = path_cost_est(start, goal);
     start_node->score = start_node->to_start + start_node->to_goal;
@@ -91,7 +88,7 @@ bool AStarPath::search_node_neighbors(astar_node *nnode, MapCoord &goal,
     push_open_node(start_node);
     const uint32 max_score = get_max_score(start_node->to_goal);
     const uint32 max_steps = 8*2*4; // walk up to four screen lengths before searching again
-    while(!open_nodes.empty())
+    while(!open_heap.empty())
     {
         astar_node *nnode = pop_open_node(); // next closest
         if(nnode->loc == goal || nnode->len >= max_steps)
@@ -106,8 +103,6 @@ bool AStarPath::search_node_neighbors(astar_node *nnode, MapCoord &goal,
         }
         // check cardinal neighbors (starting at top going clockwise)
         search_node_neighbors(nnode, goal, max_score);
-        // node and neighbors checked, put into closed
-        closed_nodes.push_back(nnode);
     }
 //DEBUG(0,LEVEL_DEBUGGING,"FAIL\n");
     delete_nodes();
@@ -120,67 +115,163 @@ sint32 AStarPath::step_cost(MapCoord &c1, MapCoord &c2)
        || c2.distance(c1) > 1)
             return(-1);
     return(1);
-}/* Return an item in the list of closed nodes whose location matches `ncmp'.
- */astar_node *AStarPath::find_closed_node(astar_node *ncmp)
-{    std::list<astar_node *>::iterator n;
-    for(n = closed_nodes.begin(); n != closed_nodes.end(); n++)
-        if((*n)->loc == ncmp->loc)
-            return(*n);
-    return(NULL);
-}/* Return an item in the list of closed nodes whose location matches `ncmp'.
- */astar_node *AStarPath::find_open_node(astar_node *ncmp)
-{    std::list<astar_node *>::iterator n;
-    for(n = open_nodes.begin(); n != open_nodes.end(); n++)
-        if((*n)->loc == ncmp->loc)
-            return(*n);
+}
+
+/* Return the first table slot to probe for `loc'. node_table size is always a
+ * power of two.
+ */
+inline uint32 AStarPath::get_table_slot(MapCoord &loc)
+{
+    uint32 h = ((uint32)loc.x | ((uint32)loc.y << 16)) * 2654435761U;
+    h ^= (h >> 15) ^ loc.z;
+    return(h & (node_table.size() - 1));
+}
+
+/* Take a node for location `loc' from the pool and add it to the location
+ * table. The location must not have a node yet.
+ */
+astar_node *AStarPath::new_node(MapCoord &loc)
+{
+    if(nodes_used * 2 >= node_table.size())
+        grow_node_table();
+    if(nodes_used == node_blocks.size() * ASTAR_NODE_BLOCK_SIZE)
+        node_blocks.push_back(new astar_node[ASTAR_NODE_BLOCK_SIZE]);
+    astar_node *node = &node_blocks[nodes_used / ASTAR_NODE_BLOCK_SIZE][nodes_used % ASTAR_NODE_BLOCK_SIZE];
+    nodes_used++;
+
+    *node = astar_node();
+    node->loc = loc;
+    uint32 mask = node_table.size() - 1;
+    uint32 slot = get_table_slot(loc);
+    while(node_table[slot])
+        slot = (slot + 1) & mask;
+    node_table[slot] = node;
+    node->table_slot = slot;
+    return(node);
+}
+
+/* Return the node seen at location `loc', or NULL if it hasn't been seen in
+ * this search.
+ */
+astar_node *AStarPath::find_node(MapCoord &loc)
+{
+    uint32 mask = node_table.size() - 1;
+    for(uint32 slot = get_table_slot(loc); node_table[slot]; slot = (slot + 1) & mask)
+        if(node_table[slot]->loc == loc)
+            return(node_table[slot]);
     return(NULL);
-}/* Add new node pointer to the list of open nodes (sorting by score).
- */void AStarPath::push_open_node(astar_node *node)
-{    std::list<astar_node *>::iterator n, next;
-    if(open_nodes.empty())
+}
+
+/* Double the location table and re-add every node in it.
+ */
+void AStarPath::grow_node_table()
+{
+    std::vector<astar_node *> old_table;
+    old_table.swap(node_table);
+    node_table.assign(old_table.size() * 2, (astar_node *)NULL);
+    uint32 mask = node_table.size() - 1;
+    for(uint32 i = 0; i < old_table.size(); i++)
     {
-        open_nodes.push_front(node);
-        return;
+        astar_node *node = old_table[i];
+        if(!node)
+            continue;
+        uint32 slot = get_table_slot(node->loc);
+        while(node_table[slot])
+            slot = (slot + 1) & mask;
+        node_table[slot] = node;
+        node->table_slot = slot;
     }
-    n = open_nodes.begin();
-    // get to end of list or to a node with equal or greater score
-    while(n != open_nodes.end() && (*n++)->score < node->score);
-    open_nodes.insert(n, node); // and add before that location
-}/* Return pointer to the highest priority node from the list of open nodes, and
- * remove it.
- */astar_node *AStarPath::pop_open_node()
-{    astar_node *best = open_nodes.front();
-    open_nodes.pop_front(); // remove it
-    return(best);
 }
 
-/* Find item in the list of closed nodes whose location matched `ncmp', and
- * remove it from the list.
+/* Lower scores come first, and nodes with equal scores in the order they were
+ * pushed.
  */
-void AStarPath::remove_closed_node(astar_node *ncmp)
+inline bool AStarPath::heap_before(astar_node *n1, astar_node *n2)
 {
-    std::list<astar_node *>::iterator n;
-    for(n = closed_nodes.begin(); n != closed_nodes.end(); n++)
-        if((*n)->loc == ncmp->loc)
-        {
-            closed_nodes.erase(n);
-            return;
-        }
+    return(n1->score < n2->score || (n1->score == n2->score && n1->seq < n2->seq));
 }
 
-/* Delete nodes dereferenced from pointers in the lists.
- */
-void AStarPath::delete_nodes()
-{    while(!open_nodes.empty())
+void AStarPath::heap_up(uint32 i)
+{
+    astar_node *node = open_heap[i];
+    while(i > 0)
     {
-        astar_node *delnode = open_nodes.front();
-        open_nodes.pop_front();
-        delete delnode;
+        uint32 parent = (i - 1) / 2;
+        if(!heap_before(node, open_heap[parent]))
+            break;
+        open_heap[i] = open_heap[parent];
+        open_heap[i]->heap_index = i;
+        i = parent;
     }
-    while(!closed_nodes.empty())
+    open_heap[i] = node;
+    node->heap_index = i;
+}
+
+void AStarPath::heap_down(uint32 i)
+{
+    astar_node *node = open_heap[i];
+    uint32 count = open_heap.size();
+    while(true)
     {
-        astar_node *delnode = closed_nodes.front();
-        closed_nodes.pop_front();
-        delete delnode;
+        uint32 child = i * 2 + 1;
+        if(child >= count)
+            break;
+        if(child + 1 < count && heap_before(open_heap[child + 1], open_heap[child]))
+            child++;
+        if(!heap_before(open_heap[child], node))
+            break;
+        open_heap[i] = open_heap[child];
+        open_heap[i]->heap_index = i;
+        i = child;
     }
+    open_heap[i] = node;
+    node->heap_index = i;
+}
+
+/* Add node to the open set.
+ */
+void AStarPath::push_open_node(astar_node *node)
+{
+    node->state = ASTAR_NODE_OPEN;
+    node->seq = push_count++;
+    open_heap.push_back(node);
+    heap_up(open_heap.size() - 1);
+}
+
+/* Return pointer to the highest priority node from the open set, and move it
+ * to the closed set.
+ */
+astar_node *AStarPath::pop_open_node()
+{
+    astar_node *best = open_heap.front();
+    astar_node *last = open_heap.back();
+    open_heap.pop_back();
+    if(!open_heap.empty())
+    {
+        open_heap[0] = last;
+        heap_down(0);
+    }
+    best->state = ASTAR_NODE_CLOSED;
+    return(best);
+}
+
+/* Restore heap order after an open node's score was lowered.
+ */
+void AStarPath::update_open_node(astar_node *node)
+{
+    node->seq = push_count++;
+    heap_up(node->heap_index);
+}
+
+/* Return all nodes to the pool. The pool and tables keep their memory for the
+ * next search.
+ */
+void AStarPath::delete_nodes()
+{
+    for(uint32 n = 0; n < nodes_used; n++)
+        node_table[node_blocks[n / ASTAR_NODE_BLOCK_SIZE][n % ASTAR_NODE_BLOCK_SIZE].table_slot] = NULL;
+    nodes_used = 0;
+    push_count = 0;
+    open_heap.clear();
+    final_node = NULL;
 }
@@ -1,8 +1,14 @@
 #ifndef __AStarPath_h__
 #define __AStarPath_h__
-#include <list>
+#include <vector>
 #include "Map.h"
 #include "Path.h"
+
+#define ASTAR_NODE_BLOCK_SIZE 256 // nodes allocated at once by the node pool
+#define ASTAR_NODE_TABLE_MIN 1024 // initial size of the location table
+
+typedef enum { ASTAR_NODE_NEW, ASTAR_NODE_OPEN, ASTAR_NODE_CLOSED } astar_node_state;
+
 typedef struct astar_node_s
 {    MapCoord loc; // location
     uint32 to_start; // costs from this node to start and to goal
@@ -10,38 +16,52 @@ typedef struct astar_node_s
     uint32 score; // node score
     uint32 len; // number of nodes before this one, regardless of score
     struct astar_node_s *parent;
+    astar_node_state state;
+    uint32 heap_index; // position in open_heap while open
+    uint32 seq; // push order, breaks ties between equal scores
+    uint32 table_slot; // position in node_table
     astar_node_s() : loc(0,0,0), to_start(0), to_goal(0), score(0), len(0),
-                     parent(NULL) { }
+                     parent(NULL), state(ASTAR_NODE_NEW), heap_index(0), seq(0),
+                     table_slot(0) { }
 } astar_node;
 /* Provides A* search and cost methods for PathFinder and subclasses.
- */class AStarPath: public Path
+ * Nodes come from a pool that is kept between searches, the open set is a
+ * binary heap and every node seen is found by location through node_table.
+ */
+class AStarPath: public Path
 {protected:
-    std::list<astar_node *> open_nodes, closed_nodes; // nodes seen
+    std::vector<astar_node *> node_blocks; // node pool
+    uint32 nodes_used; // nodes handed out from the pool in this search
+    std::vector<astar_node *> open_heap; // open nodes, lowest score first
+    std::vector<astar_node *> node_table; // open addressing, keyed by location
+    uint32 push_count;
     astar_node *final_node; // last node in path search, used by create_path()
     /* Forms a usable path from results of a search. */
     void create_path();
     /* Search routine. */
     bool search_node_neighbors(astar_node *nnode, MapCoord &goal, const uint32 max_score);
-    bool compare_neighbors(astar_node *nnode, astar_node *neighbor,
-                           sint32 nnode_to_neighbor, astar_node *in_open,
-                           astar_node *in_closed);
-    bool score_to_neighbor(sint8 dir, astar_node *nnode, astar_node *neighbor,
+    bool score_to_neighbor(sint8 dir, astar_node *nnode, MapCoord &neighbor_loc,
                            sint32 &nnode_to_neighbor);
 public:
     AStarPath();
-    ~AStarPath() { }
+    ~AStarPath();
     bool path_search(MapCoord &start, MapCoord &goal);
     virtual uint32 path_cost_est(MapCoord &s, MapCoord &g)  { return(Path::path_cost_est(s, g)); }
     virtual uint32 get_max_score(uint32 cost) { return(Path::get_max_score(cost)); }
     uint32 path_cost_est(astar_node &n1, astar_node &n2) { return(Path::path_cost_est(n1.loc, n2.loc)); }
     sint32 step_cost(MapCoord &c1, MapCoord &c2);
 protected:
-    /* FIXME: These node functions can be replaced with a priority_queue and a list. */
-    astar_node *find_open_node(astar_node *ncmp);
+    astar_node *new_node(MapCoord &loc);
+    astar_node *find_node(MapCoord &loc);
     void push_open_node(astar_node *node);
     astar_node *pop_open_node();
-    astar_node *find_closed_node(astar_node *ncmp);
-    void remove_closed_node(astar_node *ncmp);
+    void update_open_node(astar_node *node);
     void delete_nodes();
+private:
+    inline uint32 get_table_slot(MapCoord &loc);
+    void grow_node_table();
+    inline bool heap_before(astar_node *n1, astar_node *n2);
+    void heap_up(uint32 i);
+    void heap_down(uint32 i);
 };
 #endif /* __AStarPath_h__ */
@@ -129,9 +129,7 @@ uint8 PortraitU6::get_portrait_num(Actor *actor)
 
 unsigned char *PortraitU6::get_portrait_data(Actor *actor)
 {
- U6Lzw lzw;
  U6Lib_n *portrait;
- unsigned char *lzw_data;
  uint32 new_length;
  unsigned char *new_portrait;
  uint8 num = get_portrait_num(actor);
@@ -153,11 +151,9 @@ unsigned char *PortraitU6::get_portrait_data(Actor *actor)
    }
  }
 
- lzw_data = portrait->get_item(num);
- if(!lzw_data)
+ new_portrait = portrait->get_item_lzw(num, new_length);
+ if(!new_portrait)
    return NULL;
- new_portrait = lzw.decompress_buffer(lzw_data, portrait->get_item_size(num), new_length);
- free(lzw_data);
  Game::get_game()->get_dither()->dither_bitmap(new_portrait,PORTRAIT_WIDTH,PORTRAIT_HEIGHT,true);
 
  return new_portrait;
@@ -80,14 +80,25 @@ static size_t utf8_safe_len(const std::string &s, size_t max_bytes) {
     return i;
 }
 
+#define SAVEGAME_SNAPSHOT_SIZE 0x40000 // initial size of the in-memory save, grows as needed
+
 SaveGame::SaveGame(Configuration *cfg)
 {
  config = cfg;
+ save_thread = NULL;
+ save_thread_mutex = SDL_CreateMutex();
+ save_thread_buf = NULL;
+ save_thread_done = false;
+ save_thread_result = false;
+ save_thread_ticks = 0;
  init(NULL); //we don't need ObjManager here as there will be nothing to clean at this stage. :-)
 }
 
 SaveGame::~SaveGame()
 {
+ wait_for_background_save();
+ if(save_thread_mutex)
+   SDL_DestroyMutex(save_thread_mutex);
  objlist.close();
  clean_up();
 }
@@ -174,6 +185,7 @@ bool SaveGame::load_original()
  NuvieIOFileRead *objblk_file;
  NuvieIOFileRead objlist_file;
  ObjManager *obj_manager;
+ uint32 start_ticks = SDL_GetTicks();
 
  objblk_file = new NuvieIOFileRead();
 
@@ -251,6 +263,8 @@ bool SaveGame::load_original()
 
  load_objlist();
 
+ DEBUG(0,LEVEL_INFORMATIONAL,"load_original: loaded in %d ms\n", SDL_GetTicks() - start_ticks);
+
  return true;
 }
 
@@ -394,6 +408,11 @@ bool SaveGame::load(const char *filename)
  int game_type;
  //char game_tag[3];
  ObjManager *obj_manager = Game::get_game()->get_obj_manager();
+ uint32 start_ticks;
+
+ wait_for_background_save(); // it may be writing this file
+
+ start_ticks = SDL_GetTicks();
 
  config->value("config/GameType",game_type);
 
@@ -450,13 +469,144 @@ bool SaveGame::load(const char *filename)
 
  load_objlist();
 
+ DEBUG(0,LEVEL_INFORMATIONAL,"Loaded %s in %d ms\n", filename, SDL_GetTicks() - start_ticks);
+
  return true;
 }
 
 bool SaveGame::save(const char *filename, std::string *save_description, bool silent)
+{
+ wait_for_background_save();
+
+ NuvieIOBufferWrite *savebuf = save_snapshot(save_description, silent);
+ if(savebuf == NULL)
+   return false;
+
+ bool ok = write_save_file(filename, savebuf);
+ delete savebuf;
+
+ return ok;
+}
+
+/* Save in two steps. The game state is written to memory here on the main
+ * thread, then a thread writes it to disk. A save still being written is
+ * waited for first. Returns false if the thread couldn't be started.
+ */
+bool SaveGame::save_in_background(const char *filename, std::string *save_description, bool silent)
+{
+ wait_for_background_save();
+
+ NuvieIOBufferWrite *savebuf = save_snapshot(save_description, silent);
+ if(savebuf == NULL)
+   return false;
+
+ save_thread_buf = savebuf;
+ save_thread_filename.assign(filename);
+ save_thread_done = false;
+ save_thread_result = false;
+ save_thread_ticks = 0;
+
+ if(save_thread_mutex)
+   save_thread = SDL_CreateThread(background_save_thread, "Save Thread", this);
+ if(save_thread == NULL)
+   {
+    DEBUG(0,LEVEL_WARNING,"Couldn't start save thread, saving %s now\n",filename);
+    save_thread_result = write_save_file(filename, savebuf);
+    delete savebuf;
+    save_thread_buf = NULL;
+    return save_thread_result;
+   }
+
+ return true;
+}
+
+int SaveGame::background_save_thread(void *data)
+{
+ SaveGame *savegame = (SaveGame *)data;
+ uint32 start_ticks = SDL_GetTicks();
+
+ bool result = write_save_file(savegame->save_thread_filename.c_str(), savegame->save_thread_buf);
+
+ SDL_LockMutex(savegame->save_thread_mutex);
+ savegame->save_thread_result = result;
+ savegame->save_thread_ticks = SDL_GetTicks() - start_ticks;
+ savegame->save_thread_done = true;
+ SDL_UnlockMutex(savegame->save_thread_mutex);
+
+ return 0;
+}
+
+/* Check on a background save without blocking. Returns true once, after it
+ * finished, with written set to whether the file was saved.
+ */
+bool SaveGame::poll_background_save(bool *written)
+{
+ if(save_thread == NULL)
+   return false;
+
+ SDL_LockMutex(save_thread_mutex);
+ bool done = save_thread_done;
+ SDL_UnlockMutex(save_thread_mutex);
+
+ if(!done)
+   return false;
+
+ *written = wait_for_background_save();
+ return true;
+}
+
+// Returns whether the last background save was written.
+bool SaveGame::wait_for_background_save()
+{
+ if(save_thread)
+   {
+    SDL_WaitThread(save_thread, NULL);
+    save_thread = NULL;
+    delete save_thread_buf;
+    save_thread_buf = NULL;
+   }
+
+ return save_thread_result;
+}
+
+/* Write the save to a temporary file next to filename and rename it over
+ * filename, so an interrupted save leaves the old file alone. Windows'
+ * rename() won't replace a file, so the old one is removed first there.
+ */
+bool SaveGame::write_save_file(const char *filename, NuvieIOBufferWrite *savebuf)
+{
+ std::string tmp_filename(filename);
+ tmp_filename.append(".tmp");
+
+ NuvieIOFileWrite savefile;
+ if(!savefile.open(tmp_filename))
+   {
+    DEBUG(0,LEVEL_ERROR,"Couldn't open %s for writing\n",tmp_filename.c_str());
+    return false;
+   }
+
+ bool written = (savefile.writeBuf(savebuf->get_raw_data(), savebuf->get_size()) == savebuf->get_size());
+ savefile.close();
+
+#ifdef WIN32
+ if(written)
+   remove(filename);
+#endif
+ if(!written || rename(tmp_filename.c_str(), filename) != 0)
+   {
+    DEBUG(0,LEVEL_ERROR,"Couldn't write %s\n",filename);
+    remove(tmp_filename.c_str());
+    return false;
+   }
+
+ return true;
+}
+
+// Write the whole save to a new memory buffer. Returns NULL on failure.
+NuvieIOBufferWrite *SaveGame::save_snapshot(std::string *save_description, bool silent)
 {
  uint8 i;
- NuvieIOFileWrite *savefile;
+ NuvieIOBufferWrite *savefile;
  int game_type;
  char game_tag[3];
  unsigned char player_name[14];
@@ -473,9 +623,13 @@ bool SaveGame::save(const char *filename, std::string *save_description, bool si
     config->write();
  }
 
- savefile = new NuvieIOFileWrite();
+ savefile = new NuvieIOBufferWrite();
 
- savefile->open(filename);
+ if(!savefile->open(SAVEGAME_SNAPSHOT_SIZE))
+   {
+    delete savefile;
+    return NULL;
+   }
 
  savefile->write2(NUVIE_SAVE_VERSION);
  savefile->writeBuf((const unsigned char *)"Nuvie Save", 11);
@@ -534,11 +688,7 @@ bool SaveGame::save(const char *filename, std::string *save_description, bool si
 
  savefile->writeBuf(objlist.get_raw_data(), objlist.get_size());
 
- savefile->close();
-
- delete savefile;
-
- return true;
+ return savefile;
 }
 
 bool SaveGame::save_objlist(bool silent)
@@ -586,7 +736,7 @@ bool SaveGame::save_objlist(bool silent)
  return true;
 }
 
-bool SaveGame::save_thumbnail(NuvieIOFileWrite *savefile)
+bool SaveGame::save_thumbnail(NuvieIO *savefile)
 {
  unsigned char *thumbnail;
 
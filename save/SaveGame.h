@@ -41,6 +41,7 @@ class Actor;
 class Map;
 class NuvieIO;
 class NuvieIOFileWrite;
+class NuvieIOBufferWrite;
 
 struct SaveHeader
 {
@@ -68,6 +69,15 @@ class SaveGame
 
  NuvieIOBuffer objlist;
 
+ // background save, see save_in_background()
+ SDL_Thread *save_thread;
+ SDL_mutex *save_thread_mutex;
+ NuvieIOBufferWrite *save_thread_buf;
+ std::string save_thread_filename;
+ bool save_thread_done; // guarded by save_thread_mutex
+ bool save_thread_result;
+ uint32 save_thread_ticks; // time the thread took to write the file
+
  public:
 
  SaveGame(Configuration *cfg);
@@ -83,6 +93,10 @@ class SaveGame
  bool check_version(NuvieIOFileRead *loadfile);
 
  bool save(const char *filename, std::string *save_description, bool silent = false);
+ bool save_in_background(const char *filename, std::string *save_description, bool silent = false);
+ bool poll_background_save(bool *written);
+ bool wait_for_background_save();
+ uint32 get_background_save_ticks() { return save_thread_ticks; }
 
 
  uint16 get_num_saves() { return header.num_saves; };
@@ -91,7 +105,10 @@ class SaveGame
 
  bool load_objlist();
  bool save_objlist(bool silent = false);
- bool save_thumbnail(NuvieIOFileWrite *savefile);
+ bool save_thumbnail(NuvieIO *savefile);
+ NuvieIOBufferWrite *save_snapshot(std::string *save_description, bool silent);
+ static bool write_save_file(const char *filename, NuvieIOBufferWrite *savebuf);
+ static int background_save_thread(void *data);
 
  void clean_up();
 
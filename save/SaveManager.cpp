@@ -67,6 +67,7 @@ SaveManager::SaveManager(Configuration *cfg)
  autosave_enabled = false;
  last_autosave_time = 0;
  autosave_pending = false;
+ last_autosave_stall = 0;
 }
 
 // setup the savedir variable.
@@ -270,7 +271,11 @@ bool SaveManager::quick_save(int save_num, bool load)
 		}
 	}
 
-	return savegame->save(fullpath_char, &save_name); // always true
+	if(savegame->save(fullpath_char, &save_name))
+		return true;
+
+	scroll->message("\nfailed!\n\n");
+	return false;
 }
 
 bool SaveManager::autosave()
@@ -313,12 +318,16 @@ bool SaveManager::autosave()
 	DEBUG(0, LEVEL_INFORMATIONAL, "Autosaving to %s\n", fullpath.c_str());
 	ConsoleAddInfo("Autosaving to %s", fullpath.c_str());
 
-	bool result = savegame->save(fullpath.c_str(), &save_desc, true);  // silent=true for autosave
+	// Only the in-memory snapshot holds up the game, the file is written by a thread
+	uint32 stall_start = SDL_GetTicks();
+	bool result = savegame->save_in_background(fullpath.c_str(), &save_desc, true);  // silent=true for autosave
+	last_autosave_stall = SDL_GetTicks() - stall_start;
 
 	if(result)
 	{
 		last_autosave_time = SDL_GetTicks();
-		ConsoleAddInfo("Autosave successful");
+		DEBUG(0, LEVEL_INFORMATIONAL, "Autosave main thread stall: %u ms\n", last_autosave_stall);
+		ConsoleAddInfo("Autosave started, main thread stall %u ms", last_autosave_stall);
 	}
 	else
 	{
@@ -330,6 +339,15 @@ bool SaveManager::autosave()
 
 void SaveManager::check_autosave()
 {
+	bool written;
+	if(savegame && savegame->poll_background_save(&written))
+	{
+		if(written)
+			ConsoleAddInfo("Autosave successful, written in %u ms", savegame->get_background_save_ticks());
+		else
+			ConsoleAddInfo("Autosave FAILED");
+	}
+
 	if(!autosave_enabled)
 		return;
 
@@ -57,6 +57,7 @@ class SaveManager : public GUI_CallBack
  bool autosave_enabled;
  uint32 last_autosave_time;
  bool autosave_pending;  // Set to true when level change triggers autosave
+ uint32 last_autosave_stall;  // ms the last autosave held up the main thread
 
  std::string savedir;
  std::string search_prefix; //eg. nuvieU6, nuvieMD or nuvieSE
@@ -86,6 +87,7 @@ class SaveManager : public GUI_CallBack
  void check_autosave();  // Called from game loop
  void trigger_autosave_on_map_change();  // Called on level change
  bool is_autosave_enabled() { return autosave_enabled; }
+ uint32 get_last_autosave_stall() { return last_autosave_stall; }
  void set_autosave_enabled(bool enabled) { autosave_enabled = enabled; if(enabled) last_autosave_time = SDL_GetTicks(); }
 
  std::string get_new_savefilename();
@@ -0,0 +1,692 @@
+/*
+ *  BlitKernels.cpp
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "nuvieDefs.h"
+#include "BlitKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__GNUC__) || defined(__clang__)
+#define BLIT_KERNELS_X86
+#define BLIT_TARGET_SSE2 __attribute__((target("sse2")))
+#define BLIT_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER)
+#define BLIT_KERNELS_X86
+#define BLIT_TARGET_SSE2
+#define BLIT_TARGET_AVX2
+#endif
+#endif
+
+#ifdef BLIT_KERNELS_X86
+#include <immintrin.h>
+#if SDL_VERSION_ATLEAST(2, 0, 4)
+#define BLIT_KERNELS_AVX2 // SDL_HasAVX2() arrived in 2.0.4
+#endif
+#endif
+
+#define BLIT_KERNEL_CHUNK     64 // source pixels expanded per pass by the vector kernels
+#define BLIT_KERNEL_MAX_SCALE 4
+
+/* Scalar reference kernels. These are the loops Screen used before the vector
+ * kernels existed and define the expected output.
+ */
+
+template<class T> static inline void scale_rows_scalar(T *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans)
+{
+ for(uint16 j = 0; j < src_w; j++)
+   {
+    if(trans && src[j] == 0xff)
+      continue;
+
+    T color = (T)colour32[src[j]];
+    T *block = dest + j * scale;
+    for(uint8 row = 0; row < scale; row++, block += dest_pitch)
+      for(uint8 k = 0; k < scale; k++)
+        block[k] = color;
+   }
+}
+
+template<class T> static inline void shade_row_scalar(T *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *f)
+{
+ for(uint16 j = 0; j < w; j++)
+   {
+    pixels[j] = ( ( (unsigned char)(( (float)(( pixels[j] & f->Rmask ) >> f->Rshift)) * (float)(shade[j])/255.0f) ) << f->Rshift ) | //R
+                ( ( (unsigned char)(( (float)(( pixels[j] & f->Gmask ) >> f->Gshift)) * (float)(shade[j])/255.0f) ) << f->Gshift ) | //G
+                ( ( (unsigned char)(( (float)(( pixels[j] & f->Bmask ) >> f->Bshift)) * (float)(shade[j])/255.0f) ) << f->Bshift );  //B
+   }
+}
+
+static void scale_rows16_scalar(uint16 *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans)
+{
+ scale_rows_scalar<uint16>(dest, dest_pitch, src, src_w, colour32, scale, trans);
+}
+
+static void scale_rows32_scalar(uint32 *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans)
+{
+ scale_rows_scalar<uint32>(dest, dest_pitch, src, src_w, colour32, scale, trans);
+}
+
+static void scale_rows8_scalar(unsigned char *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, uint8 scale, bool trans)
+{
+ for(uint16 j = 0; j < src_w; j++)
+   {
+    if(trans && src[j] == 0xff)
+      continue;
+
+    unsigned char *block = dest + j * scale;
+    for(uint8 row = 0; row < scale; row++, block += dest_pitch)
+      memset(block, src[j], scale);
+   }
+}
+
+static void shade_row16_scalar(uint16 *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *format)
+{
+ shade_row_scalar<uint16>(pixels, shade, w, format);
+}
+
+static void shade_row32_scalar(uint32 *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *format)
+{
+ shade_row_scalar<uint32>(pixels, shade, w, format);
+}
+
+#ifdef BLIT_KERNELS_X86
+
+/* The vector scale kernels expand a chunk of source pixels into one
+ * destination row (plus a transparency mask when needed) and then copy that
+ * row scale times. Shading uses floor(c*s/255) == (x + 1 + (x >> 8)) >> 8
+ * with x = c*s, which matches the float formula for all 8 bit c and s.
+ */
+
+// Copy count bytes of row to dest, leaving bytes whose mask byte is set alone.
+BLIT_TARGET_SSE2 static void store_row_sse2(unsigned char *dest, const unsigned char *row, const unsigned char *mask, uint32 count)
+{
+ if(mask == NULL)
+   {
+    memcpy(dest, row, count);
+    return;
+   }
+
+ uint32 i = 0;
+ for(; i + 16 <= count; i += 16)
+   {
+    __m128i m = _mm_loadu_si128((const __m128i *)(mask + i));
+    int bits = _mm_movemask_epi8(m);
+    if(bits == 0xffff)
+      continue; // all transparent
+
+    __m128i v = _mm_loadu_si128((const __m128i *)(row + i));
+    if(bits != 0)
+      v = _mm_or_si128(_mm_and_si128(m, _mm_loadu_si128((const __m128i *)(dest + i))), _mm_andnot_si128(m, v));
+    _mm_storeu_si128((__m128i *)(dest + i), v);
+   }
+
+ for(; i < count; i++)
+   {
+    if(mask[i] == 0)
+      dest[i] = row[i];
+   }
+}
+
+BLIT_TARGET_SSE2 static inline void expand_lanes16_sse2(uint16 *out, __m128i v, uint8 scale)
+{
+ __m128i lo = _mm_unpacklo_epi16(v, v);
+ __m128i hi = _mm_unpackhi_epi16(v, v);
+
+ if(scale == 2)
+   {
+    _mm_storeu_si128((__m128i *)out, lo);
+    _mm_storeu_si128((__m128i *)(out + 8), hi);
+    return;
+   }
+
+ _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi32(lo, lo));
+ _mm_storeu_si128((__m128i *)(out + 8), _mm_unpackhi_epi32(lo, lo));
+ _mm_storeu_si128((__m128i *)(out + 16), _mm_unpacklo_epi32(hi, hi));
+ _mm_storeu_si128((__m128i *)(out + 24), _mm_unpackhi_epi32(hi, hi));
+}
+
+BLIT_TARGET_SSE2 static inline void expand_lanes32_sse2(uint32 *out, __m128i v, uint8 scale)
+{
+ switch(scale)
+   {
+    case 2 :
+      _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi32(v, v));
+      _mm_storeu_si128((__m128i *)(out + 4), _mm_unpackhi_epi32(v, v));
+      break;
+    case 3 :
+      _mm_storeu_si128((__m128i *)out, _mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,0,0)));
+      _mm_storeu_si128((__m128i *)(out + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(2,2,1,1)));
+      _mm_storeu_si128((__m128i *)(out + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,2)));
+      break;
+    default :
+      _mm_storeu_si128((__m128i *)out, _mm_shuffle_epi32(v, _MM_SHUFFLE(0,0,0,0)));
+      _mm_storeu_si128((__m128i *)(out + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(1,1,1,1)));
+      _mm_storeu_si128((__m128i *)(out + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(2,2,2,2)));
+      _mm_storeu_si128((__m128i *)(out + 12), _mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,3)));
+      break;
+   }
+}
+
+// Scalar expansion of src[j..n-1], used for chunk tails.
+template<class T> static inline void expand_tail(T *row, T *mask, const unsigned char *src, uint16 j, uint16 n, const uint32 *colour32, uint8 scale)
+{
+ for(; j < n; j++)
+   {
+    T color = (T)colour32[src[j]];
+    T m = (src[j] == 0xff) ? (T)~0 : 0;
+    for(uint8 k = 0; k < scale; k++)
+      {
+       row[j * scale + k] = color;
+       if(mask)
+         mask[j * scale + k] = m;
+      }
+   }
+}
+
+BLIT_TARGET_SSE2 static void expand16_sse2(uint16 *row, uint16 *mask, const unsigned char *src, uint16 n, const uint32 *colour32, uint8 scale)
+{
+ uint16 j = 0;
+
+ if(scale != 3) // 3x needs a byte shuffle, SSE2 has none
+   {
+    const __m128i ff = _mm_set1_epi16(0xff);
+    for(; j + 8 <= n; j += 8)
+      {
+       const unsigned char *s = src + j;
+       __m128i c = _mm_setr_epi16((short)colour32[s[0]], (short)colour32[s[1]], (short)colour32[s[2]], (short)colour32[s[3]],
+                                  (short)colour32[s[4]], (short)colour32[s[5]], (short)colour32[s[6]], (short)colour32[s[7]]);
+       expand_lanes16_sse2(row + j * scale, c, scale);
+       if(mask)
+         {
+          __m128i idx = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)s), _mm_setzero_si128());
+          expand_lanes16_sse2(mask + j * scale, _mm_cmpeq_epi16(idx, ff), scale);
+         }
+      }
+   }
+
+ expand_tail<uint16>(row, mask, src, j, n, colour32, scale);
+}
+
+BLIT_TARGET_SSE2 static void expand32_sse2(uint32 *row, uint32 *mask, const unsigned char *src, uint16 n, const uint32 *colour32, uint8 scale)
+{
+ const __m128i ff = _mm_set1_epi32(0xff);
+ uint16 j = 0;
+
+ for(; j + 4 <= n; j += 4)
+   {
+    const unsigned char *s = src + j;
+    __m128i c = _mm_setr_epi32(colour32[s[0]], colour32[s[1]], colour32[s[2]], colour32[s[3]]);
+    expand_lanes32_sse2(row + j * scale, c, scale);
+    if(mask)
+      expand_lanes32_sse2(mask + j * scale, _mm_cmpeq_epi32(_mm_setr_epi32(s[0], s[1], s[2], s[3]), ff), scale);
+   }
+
+ expand_tail<uint32>(row, mask, src, j, n, colour32, scale);
+}
+
+BLIT_TARGET_SSE2 static void scale_rows16_sse2(uint16 *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans)
+{
+ if(scale < 2 || scale > BLIT_KERNEL_MAX_SCALE)
+   {
+    scale_rows16_scalar(dest, dest_pitch, src, src_w, colour32, scale, trans);
+    return;
+   }
+
+ uint16 row[BLIT_KERNEL_CHUNK * BLIT_KERNEL_MAX_SCALE];
+ uint16 mask[BLIT_KERNEL_CHUNK * BLIT_KERNEL_MAX_SCALE];
+
+ for(uint32 start = 0; start < src_w; start += BLIT_KERNEL_CHUNK)
+   {
+    uint16 n = (uint16)MIN(BLIT_KERNEL_CHUNK, src_w - start);
+    expand16_sse2(row, trans ? mask : NULL, src + start, n, colour32, scale);
+    for(uint8 r = 0; r < scale; r++)
+      store_row_sse2((unsigned char *)(dest + r * dest_pitch + start * scale), (const unsigned char *)row,
+                     trans ? (const unsigned char *)mask : NULL, n * scale * sizeof(uint16));
+   }
+}
+
+BLIT_TARGET_SSE2 static void scale_rows32_sse2(uint32 *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans)
+{
+ if(scale < 2 || scale > BLIT_KERNEL_MAX_SCALE)
+   {
+    scale_rows32_scalar(dest, dest_pitch, src, src_w, colour32, scale, trans);
+    return;
+   }
+
+ uint32 row[BLIT_KERNEL_CHUNK * BLIT_KERNEL_MAX_SCALE];
+ uint32 mask[BLIT_KERNEL_CHUNK * BLIT_KERNEL_MAX_SCALE];
+
+ for(uint32 start = 0; start < src_w; start += BLIT_KERNEL_CHUNK)
+   {
+    uint16 n = (uint16)MIN(BLIT_KERNEL_CHUNK, src_w - start);
+    expand32_sse2(row, trans ? mask : NULL, src + start, n, colour32, scale);
+    for(uint8 r = 0; r < scale; r++)
+      store_row_sse2((unsigned char *)(dest + r * dest_pitch + start * scale), (const unsigned char *)row,
+                     trans ? (const unsigned char *)mask : NULL, n * scale * sizeof(uint32));
+   }
+}
+
+BLIT_TARGET_SSE2 static inline __m128i div255_epi16_sse2(__m128i x)
+{
+ return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+BLIT_TARGET_SSE2 static inline __m128i shade_channel16_sse2(__m128i p, __m128i s, uint8 shift, uint32 mask)
+{
+ __m128i count = _mm_cvtsi32_si128(shift);
+ __m128i c = _mm_and_si128(_mm_srl_epi16(p, count), _mm_set1_epi16((short)(mask >> shift)));
+ return _mm_sll_epi16(div255_epi16_sse2(_mm_mullo_epi16(c, s)), count);
+}
+
+BLIT_TARGET_SSE2 static void shade_row16_sse2(uint16 *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *format)
+{
+ uint16 j = 0;
+ for(; j + 8 <= w; j += 8)
+   {
+    __m128i p = _mm_loadu_si128((const __m128i *)(pixels + j));
+    __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(shade + j)), _mm_setzero_si128());
+    __m128i r = shade_channel16_sse2(p, s, format->Rshift, format->Rmask);
+    r = _mm_or_si128(r, shade_channel16_sse2(p, s, format->Gshift, format->Gmask));
+    r = _mm_or_si128(r, shade_channel16_sse2(p, s, format->Bshift, format->Bmask));
+    _mm_storeu_si128((__m128i *)(pixels + j), r);
+   }
+
+ shade_row16_scalar(pixels + j, shade + j, w - j, format);
+}
+
+BLIT_TARGET_SSE2 static void shade_row32_sse2(uint32 *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *format)
+{
+ const __m128i zero = _mm_setzero_si128();
+ const __m128i keep = _mm_set1_epi32((int)(format->Rmask | format->Gmask | format->Bmask));
+ uint16 j = 0;
+
+ for(; j + 4 <= w; j += 4)
+   {
+    __m128i p = _mm_loadu_si128((const __m128i *)(pixels + j));
+    __m128i s = _mm_setr_epi32(shade[j], shade[j + 1], shade[j + 2], shade[j + 3]);
+    s = _mm_or_si128(s, _mm_slli_epi32(s, 16)); // shade in both 16 bit halves
+    __m128i lo = div255_epi16_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(p, zero), _mm_unpacklo_epi32(s, s)));
+    __m128i hi = div255_epi16_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(p, zero), _mm_unpackhi_epi32(s, s)));
+    _mm_storeu_si128((__m128i *)(pixels + j), _mm_and_si128(_mm_packus_epi16(lo, hi), keep));
+   }
+
+ shade_row32_scalar(pixels + j, shade + j, w - j, format);
+}
+
+#ifdef BLIT_KERNELS_AVX2
+
+BLIT_TARGET_AVX2 static void store_row_avx2(unsigned char *dest, const unsigned char *row, const unsigned char *mask, uint32 count)
+{
+ if(mask == NULL)
+   {
+    memcpy(dest, row, count);
+    return;
+   }
+
+ uint32 i = 0;
+ for(; i + 32 <= count; i += 32)
+   {
+    __m256i m = _mm256_loadu_si256((const __m256i *)(mask + i));
+    int bits = _mm256_movemask_epi8(m);
+    if(bits == -1)
+      continue; // all transparent
+
+    __m256i v = _mm256_loadu_si256((const __m256i *)(row + i));
+    if(bits != 0)
+      v = _mm256_blendv_epi8(v, _mm256_loadu_si256((const __m256i *)(dest + i)), m);
+    _mm256_storeu_si256((__m256i *)(dest + i), v);
+   }
+
+ for(; i < count; i++)
+   {
+    if(mask[i] == 0)
+      dest[i] = row[i];
+   }
+}
+
+BLIT_TARGET_AVX2 static void expand32_avx2(uint32 *row, uint32 *mask, const unsigned char *src, uint16 n, const uint32 *colour32, uint8 scale)
+{
+ // Lane k*8+l of the expanded row comes from source lane (k*8+l)/scale.
+ __m256i perm[BLIT_KERNEL_MAX_SCALE];
+ for(uint8 k = 0; k < scale; k++)
+   {
+    sint32 idx[8];
+    for(uint8 l = 0; l < 8; l++)
+      idx[l] = (k * 8 + l) / scale;
+    perm[k] = _mm256_loadu_si256((const __m256i *)idx);
+   }
+
+ const __m256i ff = _mm256_set1_epi32(0xff);
+ uint16 j = 0;
+ for(; j + 8 <= n; j += 8)
+   {
+    __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(src + j)));
+    __m256i c = _mm256_i32gather_epi32((const int *)colour32, idx, 4);
+    __m256i m = _mm256_cmpeq_epi32(idx, ff);
+    for(uint8 k = 0; k < scale; k++)
+      {
+       _mm256_storeu_si256((__m256i *)(row + j * scale + k * 8), _mm256_permutevar8x32_epi32(c, perm[k]));
+       if(mask)
+         _mm256_storeu_si256((__m256i *)(mask + j * scale + k * 8), _mm256_permutevar8x32_epi32(m, perm[k]));
+      }
+   }
+
+ expand_tail<uint32>(row, mask, src, j, n, colour32, scale);
+}
+
+BLIT_TARGET_AVX2 static void scale_rows16_avx2(uint16 *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans)
+{
+ if(scale < 2 || scale > BLIT_KERNEL_MAX_SCALE)
+   {
+    scale_rows16_scalar(dest, dest_pitch, src, src_w, colour32, scale, trans);
+    return;
+   }
+
+ uint16 row[BLIT_KERNEL_CHUNK * BLIT_KERNEL_MAX_SCALE];
+ uint16 mask[BLIT_KERNEL_CHUNK * BLIT_KERNEL_MAX_SCALE];
+
+ for(uint32 start = 0; start < src_w; start += BLIT_KERNEL_CHUNK)
+   {
+    uint16 n = (uint16)MIN(BLIT_KERNEL_CHUNK, src_w - start);
+    expand16_sse2(row, trans ? mask : NULL, src + start, n, colour32, scale);
+    for(uint8 r = 0; r < scale; r++)
+      store_row_avx2((unsigned char *)(dest + r * dest_pitch + start * scale), (const unsigned char *)row,
+                     trans ? (const unsigned char *)mask : NULL, n * scale * sizeof(uint16));
+   }
+}
+
+BLIT_TARGET_AVX2 static void scale_rows32_avx2(uint32 *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans)
+{
+ if(scale < 2 || scale > BLIT_KERNEL_MAX_SCALE)
+   {
+    scale_rows32_scalar(dest, dest_pitch, src, src_w, colour32, scale, trans);
+    return;
+   }
+
+ uint32 row[BLIT_KERNEL_CHUNK * BLIT_KERNEL_MAX_SCALE];
+ uint32 mask[BLIT_KERNEL_CHUNK * BLIT_KERNEL_MAX_SCALE];
+
+ for(uint32 start = 0; start < src_w; start += BLIT_KERNEL_CHUNK)
+   {
+    uint16 n = (uint16)MIN(BLIT_KERNEL_CHUNK, src_w - start);
+    expand32_avx2(row, trans ? mask : NULL, src + start, n, colour32, scale);
+    for(uint8 r = 0; r < scale; r++)
+      store_row_avx2((unsigned char *)(dest + r * dest_pitch + start * scale), (const unsigned char *)row,
+                     trans ? (const unsigned char *)mask : NULL, n * scale * sizeof(uint32));
+   }
+}
+
+BLIT_TARGET_AVX2 static inline __m256i div255_epi16_avx2(__m256i x)
+{
+ return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, _mm256_set1_epi16(1)), _mm256_srli_epi16(x, 8)), 8);
+}
+
+BLIT_TARGET_AVX2 static inline __m256i shade_channel16_avx2(__m256i p, __m256i s, uint8 shift, uint32 mask)
+{
+ __m128i count = _mm_cvtsi32_si128(shift);
+ __m256i c = _mm256_and_si256(_mm256_srl_epi16(p, count), _mm256_set1_epi16((short)(mask >> shift)));
+ return _mm256_sll_epi16(div255_epi16_avx2(_mm256_mullo_epi16(c, s)), count);
+}
+
+BLIT_TARGET_AVX2 static void shade_row16_avx2(uint16 *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *format)
+{
+ uint16 j = 0;
+ for(; j + 16 <= w; j += 16)
+   {
+    __m256i p = _mm256_loadu_si256((const __m256i *)(pixels + j));
+    __m256i s = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(shade + j)));
+    __m256i r = shade_channel16_avx2(p, s, format->Rshift, format->Rmask);
+    r = _mm256_or_si256(r, shade_channel16_avx2(p, s, format->Gshift, format->Gmask));
+    r = _mm256_or_si256(r, shade_channel16_avx2(p, s, format->Bshift, format->Bmask));
+    _mm256_storeu_si256((__m256i *)(pixels + j), r);
+   }
+
+ shade_row16_sse2(pixels + j, shade + j, w - j, format);
+}
+
+BLIT_TARGET_AVX2 static void shade_row32_avx2(uint32 *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *format)
+{
+ const __m256i zero = _mm256_setzero_si256();
+ const __m256i keep = _mm256_set1_epi32((int)(format->Rmask | format->Gmask | format->Bmask));
+ uint16 j = 0;
+
+ // unpack and pack work within 128 bit lanes, so lo holds pixels 0,1,4,5
+ // and hi 2,3,6,7; the shade vectors are built the same way.
+ for(; j + 8 <= w; j += 8)
+   {
+    __m256i p = _mm256_loadu_si256((const __m256i *)(pixels + j));
+    __m256i s = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(shade + j)));
+    s = _mm256_or_si256(s, _mm256_slli_epi32(s, 16));
+    __m256i lo = div255_epi16_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(p, zero), _mm256_unpacklo_epi32(s, s)));
+    __m256i hi = div255_epi16_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(p, zero), _mm256_unpackhi_epi32(s, s)));
+    _mm256_storeu_si256((__m256i *)(pixels + j), _mm256_and_si256(_mm256_packus_epi16(lo, hi), keep));
+   }
+
+ shade_row32_sse2(pixels + j, shade + j, w - j, format);
+}
+
+#endif /* BLIT_KERNELS_AVX2 */
+
+/* Self check. Runs a kernel and the scalar reference over the same
+ * pseudo-random data at odd widths and unaligned addresses.
+ */
+
+#define BLIT_CHECK_MAX_W 131
+#define BLIT_CHECK_BUF   ((BLIT_CHECK_MAX_W * BLIT_KERNEL_MAX_SCALE + 3) * BLIT_KERNEL_MAX_SCALE + 1)
+
+static const uint16 blit_check_widths[] = { 1, 3, 7, 8, 17, 64, 70, BLIT_CHECK_MAX_W };
+
+static uint32 blit_check_rand(uint32 &seed)
+{
+ seed = seed * 1103515245 + 12345;
+ return seed >> 8;
+}
+
+template<class T, class F> static bool check_scale_rows(F reference, F kernel)
+{
+ static T expect[BLIT_CHECK_BUF];
+ static T got[BLIT_CHECK_BUF];
+ uint32 colour32[256];
+ unsigned char src[BLIT_CHECK_MAX_W];
+ uint32 seed = 1;
+
+ for(uint16 i = 0; i < 256; i++)
+   colour32[i] = blit_check_rand(seed) ^ (blit_check_rand(seed) << 16);
+
+ for(uint8 w = 0; w < sizeof(blit_check_widths) / sizeof(uint16); w++)
+   {
+    uint16 src_w = blit_check_widths[w];
+    for(uint8 scale = 2; scale <= BLIT_KERNEL_MAX_SCALE; scale++)
+      {
+       for(uint8 trans = 0; trans < 2; trans++)
+         {
+          uint32 pitch = src_w * scale + 3;
+          for(uint16 j = 0; j < src_w; j++)
+            src[j] = (blit_check_rand(seed) & 3) ? (unsigned char)blit_check_rand(seed) : 0xff;
+          for(uint32 i = 0; i < BLIT_CHECK_BUF; i++)
+            expect[i] = got[i] = (T)blit_check_rand(seed);
+
+          reference(expect + 1, pitch, src, src_w, colour32, scale, trans != 0);
+          kernel(got + 1, pitch, src, src_w, colour32, scale, trans != 0);
+          if(memcmp(expect, got, sizeof(expect)) != 0)
+            return false;
+         }
+      }
+   }
+
+ return true;
+}
+
+template<class T, class F> static bool check_shade_row(F reference, F kernel, const BlitPixelFormat *format)
+{
+ static T expect[BLIT_CHECK_MAX_W + 1];
+ static T got[BLIT_CHECK_MAX_W + 1];
+ unsigned char shade[BLIT_CHECK_MAX_W + 1];
+ uint32 seed = 7;
+
+ for(uint8 w = 0; w < sizeof(blit_check_widths) / sizeof(uint16); w++)
+   {
+    for(uint32 i = 0; i <= BLIT_CHECK_MAX_W; i++)
+      {
+       expect[i] = got[i] = (T)(blit_check_rand(seed) ^ (blit_check_rand(seed) << 16));
+       shade[i] = (i & 7) ? (unsigned char)blit_check_rand(seed) : (unsigned char)((i & 8) ? 0xff : 0);
+      }
+
+    reference(expect + 1, shade + 1, blit_check_widths[w], format);
+    kernel(got + 1, shade + 1, blit_check_widths[w], format);
+    if(memcmp(expect, got, sizeof(expect)) != 0)
+      return false;
+   }
+
+ return true;
+}
+
+// The vector shading works on 8 bit lanes (32bpp) or on 16 bit pixels with
+// channels no wider than 8 bits.
+static bool shade_format_supported(const BlitPixelFormat *format, uint8 bits_per_pixel)
+{
+ const uint32 masks[3] = { format->Rmask, format->Gmask, format->Bmask };
+ const uint8 shifts[3] = { format->Rshift, format->Gshift, format->Bshift };
+
+ for(uint8 i = 0; i < 3; i++)
+   {
+    if(bits_per_pixel == 32)
+      {
+       if(shifts[i] % 8 != 0 || shifts[i] > 24 || masks[i] != (0xffU << shifts[i]))
+         return false;
+      }
+    else if(bits_per_pixel == 16)
+      {
+       if(shifts[i] >= 16 || masks[i] > 0xffff || (masks[i] >> shifts[i]) > 0xff)
+         return false;
+      }
+    else
+      return false;
+   }
+
+ return true;
+}
+
+#endif /* BLIT_KERNELS_X86 */
+
+void blit_kernels_scalar(BlitKernels *kernels)
+{
+ kernels->scale_name = "scalar";
+ kernels->shade_name = "scalar";
+ kernels->scale_rows16 = scale_rows16_scalar;
+ kernels->scale_rows32 = scale_rows32_scalar;
+ kernels->scale_rows8 = scale_rows8_scalar;
+ kernels->shade_row16 = shade_row16_scalar;
+ kernels->shade_row32 = shade_row32_scalar;
+}
+
+bool blit_kernels_named(BlitKernels *kernels, const char *name)
+{
+ blit_kernels_scalar(kernels);
+
+ if(strcmp(name, "scalar") == 0)
+   return true;
+
+#ifdef BLIT_KERNELS_X86
+#ifdef BLIT_KERNELS_AVX2
+ if(strcmp(name, "avx2") == 0 && SDL_HasAVX2())
+   {
+    kernels->scale_name = kernels->shade_name = "avx2";
+    kernels->scale_rows16 = scale_rows16_avx2;
+    kernels->scale_rows32 = scale_rows32_avx2;
+    kernels->shade_row16 = shade_row16_avx2;
+    kernels->shade_row32 = shade_row32_avx2;
+    return true;
+   }
+#endif
+ if(strcmp(name, "sse2") == 0 && SDL_HasSSE2())
+   {
+    kernels->scale_name = kernels->shade_name = "sse2";
+    kernels->scale_rows16 = scale_rows16_sse2;
+    kernels->scale_rows32 = scale_rows32_sse2;
+    kernels->shade_row16 = shade_row16_sse2;
+    kernels->shade_row32 = shade_row32_sse2;
+    return true;
+   }
+#endif
+
+ return false;
+}
+
+bool blit_kernels_shade_supported(const BlitPixelFormat *format, uint8 bits_per_pixel)
+{
+#ifdef BLIT_KERNELS_X86
+ return shade_format_supported(format, bits_per_pixel);
+#else
+ return false;
+#endif
+}
+
+void blit_kernels_select(BlitKernels *kernels, const BlitPixelFormat *format, uint8 bits_per_pixel, bool use_simd)
+{
+ blit_kernels_scalar(kernels);
+
+ if(!use_simd)
+   {
+    DEBUG(0,LEVEL_INFORMATIONAL,"Blit kernels: scalar (disabled by config)\n");
+    return;
+   }
+
+#ifdef BLIT_KERNELS_X86
+ BlitKernels candidate;
+
+ if(!blit_kernels_named(&candidate, "avx2"))
+   blit_kernels_named(&candidate, "sse2");
+
+ // tests/TestBlitKernels.cpp covers these, this only keeps a broken build usable
+ if(candidate.scale_rows16 != kernels->scale_rows16)
+   {
+    if(check_scale_rows<uint16>(kernels->scale_rows16, candidate.scale_rows16)
+       && check_scale_rows<uint32>(kernels->scale_rows32, candidate.scale_rows32))
+      {
+       kernels->scale_name = candidate.scale_name;
+       kernels->scale_rows16 = candidate.scale_rows16;
+       kernels->scale_rows32 = candidate.scale_rows32;
+      }
+    else
+      DEBUG(0,LEVEL_WARNING,"%s scale kernels differ from the scalar output, using scalar\n", candidate.scale_name);
+   }
+
+ if(candidate.shade_row16 != kernels->shade_row16 && shade_format_supported(format, bits_per_pixel))
+   {
+    bool same = (bits_per_pixel == 16) ? check_shade_row<uint16>(kernels->shade_row16, candidate.shade_row16, format)
+                                       : check_shade_row<uint32>(kernels->shade_row32, candidate.shade_row32, format);
+    if(same)
+      {
+       kernels->shade_name = candidate.shade_name;
+       kernels->shade_row16 = candidate.shade_row16;
+       kernels->shade_row32 = candidate.shade_row32;
+      }
+    else
+      DEBUG(0,LEVEL_WARNING,"%s shade kernels differ from the scalar output, using scalar\n", candidate.shade_name);
+   }
+#endif
+
+ DEBUG(0,LEVEL_INFORMATIONAL,"Blit kernels: scale %s, shade %s\n", kernels->scale_name, kernels->shade_name);
+}
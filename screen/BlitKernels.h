@@ -0,0 +1,70 @@
+#ifndef __BlitKernels_h__
+#define __BlitKernels_h__
+
+/*
+ *  BlitKernels.h
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+// Inner loops of Screen's scaled blits and smooth lighting. Every kernel set
+// must give byte for byte the same output as the scalar one.
+
+typedef struct
+{
+ uint32 Rmask, Gmask, Bmask;
+ uint8 Rshift, Gshift, Bshift;
+} BlitPixelFormat;
+
+// Write src_w palette indices as scale x scale blocks starting at dest.
+// dest_pitch is in pixels. With trans set, index 0xff leaves dest untouched.
+typedef void (*BlitScaleRows16)(uint16 *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans);
+typedef void (*BlitScaleRows32)(uint32 *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, const uint32 *colour32, uint8 scale, bool trans);
+// The same for an 8 bit (indexed) dest, where the indices are copied as they are.
+typedef void (*BlitScaleRows8)(unsigned char *dest, uint32 dest_pitch, const unsigned char *src, uint16 src_w, uint8 scale, bool trans);
+
+// Multiply the R, G and B channels of w pixels by shade[j]/255.
+typedef void (*BlitShadeRow16)(uint16 *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *format);
+typedef void (*BlitShadeRow32)(uint32 *pixels, const unsigned char *shade, uint16 w, const BlitPixelFormat *format);
+
+typedef struct
+{
+ const char *scale_name;
+ const char *shade_name;
+ BlitScaleRows16 scale_rows16;
+ BlitScaleRows32 scale_rows32;
+ BlitScaleRows8 scale_rows8; // scalar only, a row of memsets
+ BlitShadeRow16 shade_row16;
+ BlitShadeRow32 shade_row32;
+} BlitKernels;
+
+// Fill kernels with the scalar reference loops.
+void blit_kernels_scalar(BlitKernels *kernels);
+
+// Fill kernels with the named set, "scalar", "sse2" or "avx2", unchecked.
+// Returns false (leaving the scalar set) if the build or CPU lacks it.
+bool blit_kernels_named(BlitKernels *kernels, const char *name);
+
+// Whether the vector shade kernels handle this pixel format.
+bool blit_kernels_shade_supported(const BlitPixelFormat *format, uint8 bits_per_pixel);
+
+// Fill kernels with the fastest set the CPU and pixel format support. Each
+// vector kernel is checked against the scalar one first and is dropped if the
+// results differ. use_simd false gives the scalar set.
+void blit_kernels_select(BlitKernels *kernels, const BlitPixelFormat *format, uint8 bits_per_pixel, bool use_simd);
+
+#endif /* __BlitKernels_h__ */
@@ -52,12 +52,29 @@
 static const sint32 globeradius[]   = { 36, 112, 148, 192, 448 };
 static const sint32 globeradius_2[] = { 18, 56, 74, 96, 224 };
 
+// 4x4 ordered dither, used in indexed mode for blends an 8 bit surface can't hold
+static const uint8 dither_threshold[4][4] =
+{
+ {   8, 136,  40, 168 },
+ { 200,  72, 232, 104 },
+ {  56, 184,  24, 152 },
+ { 248, 120, 216,  88 }
+};
+
+// Whether the pixel at x,y shows a colour drawn with this opacity.
+static inline bool dither_visible(uint32 x, uint32 y, uint8 opacity)
+{
+ return opacity > dither_threshold[y & 3][x & 3];
+}
+
 Screen::Screen(Configuration *cfg)
 {
  config = cfg;
 
  sdl_surface = NULL;
  surface = NULL;
+ rgb_surface = NULL;
+ indexed = false;
  scaler = NULL;
  update_rects = NULL;
  shading_data = NULL;
@@ -70,6 +87,9 @@ Screen::Screen(Configuration *cfg)
  shading_ambient = 255;
  width = 320;
  height = 200;
+ palette_version = 0;
+ palette_rotation_count = 0;
+ memset(palette_rotating, 0, sizeof(palette_rotating));
 
  std::string str_lighting_style;
  config->value( "config/general/lighting", str_lighting_style );
@@ -83,12 +103,22 @@ Screen::Screen(Configuration *cfg)
  old_lighting_style = lighting_style;
  max_update_rects = 10;
  num_update_rects = 0;
+ dirty_rect_update = false;
+ full_update_required = true;
+ update_bytes = 0;
+ update_bytes_total = 0;
+ update_frames = 0;
  memset( shading_globe, 0, sizeof(shading_globe) );
+ shading_tile_scale = 1;
+ avatar_globe_x = avatar_globe_y = 0;
+ avatar_globe_r = 0;
+ blit_kernels_scalar(&blit_kernels);
 }
 
 Screen::~Screen()
 {
  delete surface;
+ delete rgb_surface;
  if (update_rects) free(update_rects);
  if (shading_data) free(shading_data);
 
@@ -141,8 +171,11 @@ config->value("config/video/scale_factor", scale_factor, 1);
 
  config->value("config/video/fullscreen", fullscreen, false);
  config->value("config/video/non_square_pixels", non_square_pixels, false);
+ config->value("config/video/dirty_rect_update", dirty_rect_update, false);
+ config->value("config/video/indexed_back_buffer", indexed, false);
 
  set_screen_mode();
+ init_blit_kernels();
 
 #if SDL_VERSION_ATLEAST(2, 0, 0)
     SDL_SetRenderDrawColor(sdlRenderer, 0, 0, 0, 255);
@@ -152,6 +185,62 @@ config->value("config/video/scale_factor", scale_factor, 1);
     return true;
 }
 
+/* Pick the blit kernels for the screen surface's pixel format. The vector
+ * kernels can be turned off with config/video/simd_blit to compare against
+ * the scalar loops.
+ */
+void Screen::init_blit_kernels()
+{
+ bool use_simd;
+ config->value("config/video/simd_blit", use_simd, true);
+
+ if(surface == NULL)
+   {
+    blit_kernels_scalar(&blit_kernels);
+    return;
+   }
+
+ BlitPixelFormat format;
+ format.Rmask = surface->Rmask;
+ format.Gmask = surface->Gmask;
+ format.Bmask = surface->Bmask;
+ format.Rshift = surface->Rshift;
+ format.Gshift = surface->Gshift;
+ format.Bshift = surface->Bshift;
+
+ // in indexed mode the 16/32 bit kernels expand to the display format
+ RenderSurface *display = indexed ? rgb_surface : surface;
+ blit_kernels_select(&blit_kernels, &format, (uint8)display->bits_per_pixel, use_simd);
+}
+
+/* Give an 8 bit SDL surface the game palette, so SDL blits and SDL_MapRGB()
+ * onto the indexed screen surface pick game colours. Only count entries from
+ * first are copied from the palette array. Palette rotation isn't passed on,
+ * RGB images drawn through SDL always map to the unrotated colours.
+ */
+void Screen::set_sdl_palette(SDL_Surface *dest, uint16 first, uint16 count)
+{
+ SDL_Color colors[256];
+
+ for(uint16 i = 0; i < count; i++)
+   {
+    colors[i].r = palette[(first + i) * 3];
+    colors[i].g = palette[(first + i) * 3 + 1];
+    colors[i].b = palette[(first + i) * 3 + 2];
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+    colors[i].a = 255;
+#else
+    colors[i].unused = 0;
+#endif
+   }
+
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+ SDL_SetPaletteColors(dest->format->palette, colors, first, count);
+#else
+ SDL_SetColors(dest, colors, first, count);
+#endif
+}
+
 void Screen::set_lighting_style(int lighting)
 {
 	lighting_style = lighting;
@@ -192,6 +281,10 @@ bool Screen::set_palette(uint8 *p)
 		surface->colour32[i] = c;
 	 }
 
+ if(indexed)
+   set_sdl_palette(surface->get_sdl_surface());
+
+ palette_version++;
  return true;
 }
 
@@ -208,6 +301,9 @@ bool Screen::set_palette_entry(uint8 idx, uint8 r, uint8 g, uint8 b)
  uint32	c= ((((uint32)r)>>RenderSurface::Rloss)<<RenderSurface::Rshift) | ((((uint32)g)>>RenderSurface::Gloss)<<RenderSurface::Gshift) | ((((uint32)b)>>RenderSurface::Bloss)<<RenderSurface::Bshift);
 
  surface->colour32[idx] = c;
+ if(indexed)
+   set_sdl_palette(surface->get_sdl_surface(), idx, 1);
+ palette_version++;
 
  return true;
 }
@@ -217,6 +313,15 @@ bool Screen::rotate_palette(uint8 pos, uint8 length)
  uint32 tmp_colour;
  uint8 i;
 
+ // caches that skip rotation checks for unaffected colours need to see new ranges
+ if(!palette_rotating[pos] || !palette_rotating[pos + length - 1])
+  {
+   for(i = 0; i < length; i++)
+     palette_rotating[pos + i] = true;
+   palette_version++;
+  }
+ palette_rotation_count++;
+
  // Rotate internal palette array
  uint8 tmp_r = palette[(pos + length - 1) * 3 + 0];
  uint8 tmp_g = palette[(pos + length - 1) * 3 + 1];
@@ -352,6 +457,9 @@ bool Screen::fill(uint8 colour_num, uint16 x, uint16 y, sint16 w, sint16 h)
  if(surface->bits_per_pixel == 16)
     return fill16(colour_num, x, y, w, h);
 
+ if(surface->bits_per_pixel == 8)
+    return fill8(colour_num, x, y, w, h);
+
  return fill32(colour_num, x, y, w, h);
 }
 
@@ -395,10 +503,31 @@ bool Screen::fill32(uint8 colour_num, uint16 x, uint16 y, sint16 w, sint16 h)
 
  return true;
 }
+
+bool Screen::fill8(uint8 colour_num, uint16 x, uint16 y, sint16 w, sint16 h)
+{
+ uint8 *pixels;
+ uint16 i;
+
+ pixels = (uint8 *)surface->pixels;
+
+ pixels += y * surface->w + x;
+
+ for(i=0;i<h;i++)
+    {
+     memset(pixels, colour_num, w);
+
+     pixels += surface->w;
+    }
+
+ return true;
+}
 void Screen::fade(uint16 dest_x, uint16 dest_y, uint16 src_w, uint16 src_h, uint8 opacity, uint8 fade_bg_color)
 {
 if(surface->bits_per_pixel == 16)
 	fade16(dest_x, dest_y, src_w, src_h, opacity, fade_bg_color);
+else if(surface->bits_per_pixel == 8)
+	fade8(dest_x, dest_y, src_w, src_h, opacity, fade_bg_color);
 else
 	fade32(dest_x, dest_y, src_w, src_h, opacity, fade_bg_color);
 }
@@ -449,6 +578,30 @@ void Screen::fade32(uint16 dest_x, uint16 dest_y, uint16 src_w, uint16 src_h, ui
 	 return;
 }
 
+// An 8 bit surface can't hold a blend, so the background is dithered in.
+void Screen::fade8(uint16 dest_x, uint16 dest_y, uint16 src_w, uint16 src_h, uint8 opacity, uint8 fade_bg_color)
+{
+	 uint8 *pixels;
+	 uint16 i,j;
+
+	 pixels = (uint8 *)surface->pixels;
+
+	 pixels += dest_y * surface->w + dest_x;
+
+	 for(i=0;i<src_h;i++)
+	  {
+	   for(j=0;j<src_w;j++)
+	    {
+	       if(!dither_visible(dest_x + j, dest_y + i, opacity))
+	         pixels[j] = fade_bg_color;
+	    }
+
+	   pixels += surface->w; //surface->pitch;
+	  }
+
+	 return;
+}
+
 void Screen::stipple_8bit(uint8 color_num)
 {
 	stipple_8bit(color_num, 0, 0, surface->w, surface->h);
@@ -473,7 +626,22 @@ void Screen::stipple_8bit(uint8 color_num, uint16 x, uint16 y, uint16 w, uint16
 		w = surface->w - x;
 	}
 
-	if(surface->bits_per_pixel == 16)
+	if(surface->bits_per_pixel == 8)
+	{
+		uint8 *pixels = (uint8 *)surface->pixels;
+
+		pixels += y * surface->w + x;
+
+		for(i=0;i<h;i++)
+		{
+			for(j=i%2;j<w;j+=2)
+			{
+				pixels[j] = color_num;
+			}
+			pixels += surface->w;
+		}
+	}
+	else if(surface->bits_per_pixel == 16)
 	{
 		uint16 color = (uint16)surface->colour32[color_num];
 		uint16 *pixels = (uint16 *)surface->pixels;
@@ -526,7 +694,12 @@ void Screen::stipple_8bit(uint8 color_num, uint16 x, uint16 y, uint16 w, uint16
 }
 void Screen::put_pixel(uint8 colour_num, uint16 x, uint16 y)
 {
-	if(surface->bits_per_pixel == 16)
+	if(surface->bits_per_pixel == 8)
+	{
+		uint8 *pixel = (uint8 *)surface->pixels + y * surface->w + x;
+		*pixel = colour_num;
+	}
+	else if(surface->bits_per_pixel == 16)
 	{
 		uint16 *pixel = (uint16 *)surface->pixels + y * surface->w + x;
 		*pixel = (uint16)surface->colour32[colour_num];
@@ -633,6 +806,9 @@ bool Screen::blit(sint32 dest_x, sint32 dest_y, unsigned char *src_buf, uint16 s
    src_buf += src_y * src_pitch + src_x;
   }
 
+ if(surface->bits_per_pixel == 8)
+   return blit8(dest_x, dest_y, src_buf, src_bpp, src_w, src_h, src_pitch, trans, opacity);
+
  if(surface->bits_per_pixel == 16)
  {
 	 if(opacity < 255)
@@ -747,46 +923,28 @@ bool Screen::blit2x(sint32 dest_x, sint32 dest_y, unsigned char *src_buf, uint16
   }
 
  // Perform 2x scaled blit
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
  {
-   uint16 *pixels = (uint16 *)surface->pixels;
+   uint8 *pixels = (uint8 *)surface->pixels;
    pixels += dest_y * surface->w + dest_x;
 
-   if(trans)
+   for(uint16 i = 0; i < src_h; i++)
    {
-     for(uint16 i = 0; i < src_h; i++)
-     {
-       for(uint16 j = 0; j < src_w; j++)
-       {
-         if(src_buf[j] != 0xff)
-         {
-           uint16 color = (uint16)surface->colour32[src_buf[j]];
-           // Write 2x2 block
-           pixels[j*2] = color;
-           pixels[j*2 + 1] = color;
-           pixels[surface->w + j*2] = color;
-           pixels[surface->w + j*2 + 1] = color;
-         }
-       }
-       src_buf += src_pitch;
-       pixels += surface->w * 2; // Skip 2 rows
-     }
+     blit_kernels.scale_rows8(pixels, surface->w, src_buf, src_w, 2, trans);
+     src_buf += src_pitch;
+     pixels += surface->w * 2;
    }
-   else
+ }
+ else if(surface->bits_per_pixel == 16)
+ {
+   uint16 *pixels = (uint16 *)surface->pixels;
+   pixels += dest_y * surface->w + dest_x;
+
+   for(uint16 i = 0; i < src_h; i++)
    {
-     for(uint16 i = 0; i < src_h; i++)
-     {
-       for(uint16 j = 0; j < src_w; j++)
-       {
-         uint16 color = (uint16)surface->colour32[src_buf[j]];
-         pixels[j*2] = color;
-         pixels[j*2 + 1] = color;
-         pixels[surface->w + j*2] = color;
-         pixels[surface->w + j*2 + 1] = color;
-       }
-       src_buf += src_pitch;
-       pixels += surface->w * 2;
-     }
+     blit_kernels.scale_rows16(pixels, surface->w, src_buf, src_w, surface->colour32, 2, trans);
+     src_buf += src_pitch;
+     pixels += surface->w * 2; // Skip 2 rows
    }
  }
  else // 32-bit
@@ -794,41 +952,11 @@ bool Screen::blit2x(sint32 dest_x, sint32 dest_y, unsigned char *src_buf, uint16
    uint32 *pixels = (uint32 *)surface->pixels;
    pixels += dest_y * surface->w + dest_x;
 
-   if(trans)
-   {
-     for(uint16 i = 0; i < src_h; i++)
-     {
-       for(uint16 j = 0; j < src_w; j++)
-       {
-         if(src_buf[j] != 0xff)
-         {
-           uint32 color = surface->colour32[src_buf[j]];
-           // Write 2x2 block
-           pixels[j*2] = color;
-           pixels[j*2 + 1] = color;
-           pixels[surface->w + j*2] = color;
-           pixels[surface->w + j*2 + 1] = color;
-         }
-       }
-       src_buf += src_pitch;
-       pixels += surface->w * 2;
-     }
-   }
-   else
+   for(uint16 i = 0; i < src_h; i++)
    {
-     for(uint16 i = 0; i < src_h; i++)
-     {
-       for(uint16 j = 0; j < src_w; j++)
-       {
-         uint32 color = surface->colour32[src_buf[j]];
-         pixels[j*2] = color;
-         pixels[j*2 + 1] = color;
-         pixels[surface->w + j*2] = color;
-         pixels[surface->w + j*2 + 1] = color;
-       }
-       src_buf += src_pitch;
-       pixels += surface->w * 2;
-     }
+     blit_kernels.scale_rows32(pixels, surface->w, src_buf, src_w, surface->colour32, 2, trans);
+     src_buf += src_pitch;
+     pixels += surface->w * 2;
    }
  }
 
@@ -933,56 +1061,28 @@ bool Screen::blit3x(sint32 dest_x, sint32 dest_y, unsigned char *src_buf, uint16
   }
 
  // Perform 3x scaled blit
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
  {
-   uint16 *pixels = (uint16 *)surface->pixels;
+   uint8 *pixels = (uint8 *)surface->pixels;
    pixels += dest_y * surface->w + dest_x;
 
-   if(trans)
+   for(uint16 i = 0; i < src_h; i++)
    {
-     for(uint16 i = 0; i < src_h; i++)
-     {
-       for(uint16 j = 0; j < src_w; j++)
-       {
-         if(src_buf[j] != 0xff)
-         {
-           uint16 color = (uint16)surface->colour32[src_buf[j]];
-           // Write 3x3 block
-           pixels[j*3] = color;
-           pixels[j*3 + 1] = color;
-           pixels[j*3 + 2] = color;
-           pixels[surface->w + j*3] = color;
-           pixels[surface->w + j*3 + 1] = color;
-           pixels[surface->w + j*3 + 2] = color;
-           pixels[surface->w*2 + j*3] = color;
-           pixels[surface->w*2 + j*3 + 1] = color;
-           pixels[surface->w*2 + j*3 + 2] = color;
-         }
-       }
-       src_buf += src_pitch;
-       pixels += surface->w * 3; // Skip 3 rows
-     }
+     blit_kernels.scale_rows8(pixels, surface->w, src_buf, src_w, 3, trans);
+     src_buf += src_pitch;
+     pixels += surface->w * 3;
    }
-   else
+ }
+ else if(surface->bits_per_pixel == 16)
+ {
+   uint16 *pixels = (uint16 *)surface->pixels;
+   pixels += dest_y * surface->w + dest_x;
+
+   for(uint16 i = 0; i < src_h; i++)
    {
-     for(uint16 i = 0; i < src_h; i++)
-     {
-       for(uint16 j = 0; j < src_w; j++)
-       {
-         uint16 color = (uint16)surface->colour32[src_buf[j]];
-         pixels[j*3] = color;
-         pixels[j*3 + 1] = color;
-         pixels[j*3 + 2] = color;
-         pixels[surface->w + j*3] = color;
-         pixels[surface->w + j*3 + 1] = color;
-         pixels[surface->w + j*3 + 2] = color;
-         pixels[surface->w*2 + j*3] = color;
-         pixels[surface->w*2 + j*3 + 1] = color;
-         pixels[surface->w*2 + j*3 + 2] = color;
-       }
-       src_buf += src_pitch;
-       pixels += surface->w * 3;
-     }
+     blit_kernels.scale_rows16(pixels, surface->w, src_buf, src_w, surface->colour32, 3, trans);
+     src_buf += src_pitch;
+     pixels += surface->w * 3; // Skip 3 rows
    }
  }
  else // 32-bit
@@ -990,51 +1090,11 @@ bool Screen::blit3x(sint32 dest_x, sint32 dest_y, unsigned char *src_buf, uint16
    uint32 *pixels = (uint32 *)surface->pixels;
    pixels += dest_y * surface->w + dest_x;
 
-   if(trans)
-   {
-     for(uint16 i = 0; i < src_h; i++)
-     {
-       for(uint16 j = 0; j < src_w; j++)
-       {
-         if(src_buf[j] != 0xff)
-         {
-           uint32 color = surface->colour32[src_buf[j]];
-           // Write 3x3 block
-           pixels[j*3] = color;
-           pixels[j*3 + 1] = color;
-           pixels[j*3 + 2] = color;
-           pixels[surface->w + j*3] = color;
-           pixels[surface->w + j*3 + 1] = color;
-           pixels[surface->w + j*3 + 2] = color;
-           pixels[surface->w*2 + j*3] = color;
-           pixels[surface->w*2 + j*3 + 1] = color;
-           pixels[surface->w*2 + j*3 + 2] = color;
-         }
-       }
-       src_buf += src_pitch;
-       pixels += surface->w * 3;
-     }
-   }
-   else
+   for(uint16 i = 0; i < src_h; i++)
    {
-     for(uint16 i = 0; i < src_h; i++)
-     {
-       for(uint16 j = 0; j < src_w; j++)
-       {
-         uint32 color = surface->colour32[src_buf[j]];
-         pixels[j*3] = color;
-         pixels[j*3 + 1] = color;
-         pixels[j*3 + 2] = color;
-         pixels[surface->w + j*3] = color;
-         pixels[surface->w + j*3 + 1] = color;
-         pixels[surface->w + j*3 + 2] = color;
-         pixels[surface->w*2 + j*3] = color;
-         pixels[surface->w*2 + j*3 + 1] = color;
-         pixels[surface->w*2 + j*3 + 2] = color;
-       }
-       src_buf += src_pitch;
-       pixels += surface->w * 3;
-     }
+     blit_kernels.scale_rows32(pixels, surface->w, src_buf, src_w, surface->colour32, 3, trans);
+     src_buf += src_pitch;
+     pixels += surface->w * 3;
    }
  }
 
@@ -1162,7 +1222,59 @@ bool Screen::blit4x(sint32 dest_x, sint32 dest_y, unsigned char *src_buf, uint16
   }
 
  // Perform 4x scaled blit
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
+ {
+   uint8 *pixels = (uint8 *)surface->pixels;
+   pixels += dest_y * surface->w + dest_x;
+   uint32 row_stride = surface->w;
+
+   for(uint16 i = 0; i < src_h; i++)
+   {
+     if(dissolve == 255 && opacity == 255)
+     {
+       blit_kernels.scale_rows8(pixels, row_stride, src_buf, src_w, 4, trans);
+       src_buf += src_pitch;
+       pixels += row_stride * 4;
+       continue;
+     }
+
+     for(uint16 j = 0; j < src_w; j++)
+     {
+       if(trans && src_buf[j] == 0xff)
+         continue;
+
+       if(dissolve < 255)
+       {
+         // same threshold as the 16/32 bit dissolve
+         uint32 hash = (i * 31337) ^ (j * 7919) ^ ((i + j) * 1013);
+         hash = ((hash >> 16) ^ hash) * 0x45d9f3b;
+         hash = ((hash >> 16) ^ hash) * 0x45d9f3b;
+         hash = (hash >> 16) ^ hash;
+         if((uint8)(hash & 0xFF) >= dissolve)
+           continue;
+
+         for(int row = 0; row < 4; row++)
+           memset(pixels + row * row_stride + j * 4, src_buf[j], 4);
+       }
+       else
+       {
+         // opacity is dithered per destination pixel
+         for(int row = 0; row < 4; row++)
+         {
+           uint8 *row_ptr = pixels + row * row_stride + j * 4;
+           for(int k = 0; k < 4; k++)
+           {
+             if(dither_visible(dest_x + j * 4 + k, dest_y + i * 4 + row, opacity))
+               row_ptr[k] = src_buf[j];
+           }
+         }
+       }
+     }
+     src_buf += src_pitch;
+     pixels += row_stride * 4;
+   }
+ }
+ else if(surface->bits_per_pixel == 16)
  {
    uint16 *pixels = (uint16 *)surface->pixels;
    pixels += dest_y * surface->w + dest_x;
@@ -1289,52 +1401,12 @@ bool Screen::blit4x(sint32 dest_x, sint32 dest_y, unsigned char *src_buf, uint16
    }
    else
    {
-     // Full opacity - original fast path
-     if(trans)
-     {
-       for(uint16 i = 0; i < src_h; i++)
-       {
-         for(uint16 j = 0; j < src_w; j++)
-         {
-           if(src_buf[j] != 0xff)
-           {
-             uint16 color = (uint16)surface->colour32[src_buf[j]];
-             uint32 base = j * 4;
-             // Write 4x4 block
-             for(int row = 0; row < 4; row++)
-             {
-               uint16 *row_ptr = pixels + row * row_stride + base;
-               row_ptr[0] = color;
-               row_ptr[1] = color;
-               row_ptr[2] = color;
-               row_ptr[3] = color;
-             }
-           }
-         }
-         src_buf += src_pitch;
-         pixels += row_stride * 4; // Skip 4 rows
-       }
-     }
-     else
+     // Full opacity
+     for(uint16 i = 0; i < src_h; i++)
      {
-       for(uint16 i = 0; i < src_h; i++)
-       {
-         for(uint16 j = 0; j < src_w; j++)
-         {
-           uint16 color = (uint16)surface->colour32[src_buf[j]];
-           uint32 base = j * 4;
-           for(int row = 0; row < 4; row++)
-           {
-             uint16 *row_ptr = pixels + row * row_stride + base;
-             row_ptr[0] = color;
-             row_ptr[1] = color;
-             row_ptr[2] = color;
-             row_ptr[3] = color;
-           }
-         }
-         src_buf += src_pitch;
-         pixels += row_stride * 4;
-       }
+       blit_kernels.scale_rows16(pixels, row_stride, src_buf, src_w, surface->colour32, 4, trans);
+       src_buf += src_pitch;
+       pixels += row_stride * 4; // Skip 4 rows
      }
    }
  }
@@ -1464,52 +1536,12 @@ bool Screen::blit4x(sint32 dest_x, sint32 dest_y, unsigned char *src_buf, uint16
    }
    else
    {
-     // Full opacity - original fast path
-     if(trans)
-     {
-       for(uint16 i = 0; i < src_h; i++)
-       {
-         for(uint16 j = 0; j < src_w; j++)
-         {
-           if(src_buf[j] != 0xff)
-           {
-             uint32 color = surface->colour32[src_buf[j]];
-             uint32 base = j * 4;
-             // Write 4x4 block
-             for(int row = 0; row < 4; row++)
-             {
-               uint32 *row_ptr = pixels + row * row_stride + base;
-               row_ptr[0] = color;
-               row_ptr[1] = color;
-               row_ptr[2] = color;
-               row_ptr[3] = color;
-             }
-           }
-         }
-         src_buf += src_pitch;
-         pixels += row_stride * 4;
-       }
-     }
-     else
+     // Full opacity
+     for(uint16 i = 0; i < src_h; i++)
      {
-       for(uint16 i = 0; i < src_h; i++)
-       {
-         for(uint16 j = 0; j < src_w; j++)
-         {
-           uint32 color = surface->colour32[src_buf[j]];
-           uint32 base = j * 4;
-           for(int row = 0; row < 4; row++)
-           {
-             uint32 *row_ptr = pixels + row * row_stride + base;
-             row_ptr[0] = color;
-             row_ptr[1] = color;
-             row_ptr[2] = color;
-             row_ptr[3] = color;
-           }
-         }
-         src_buf += src_pitch;
-         pixels += row_stride * 4;
-       }
+       blit_kernels.scale_rows32(pixels, row_stride, src_buf, src_w, surface->colour32, 4, trans);
+       src_buf += src_pitch;
+       pixels += row_stride * 4; // Skip 4 rows
      }
    }
  }
@@ -1561,7 +1593,37 @@ bool Screen::blit4xWithAlpha(sint32 dest_x, sint32 dest_y, unsigned char *src_bu
  src_buf += src_y_off * orig_pitch + src_x_off;
  alpha_buf += src_y_off * orig_pitch + src_x_off;
 
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
+ {
+   uint8 *pixels = (uint8 *)surface->pixels;
+   pixels += dest_y * surface->w + dest_x;
+   uint32 row_stride = surface->w;
+
+   for(uint16 i = 0; i < src_h; i++)
+   {
+     for(uint16 j = 0; j < src_w; j++)
+     {
+       uint8 alpha = alpha_buf[i * orig_pitch + j];
+       if(alpha > 0)  // Skip fully transparent pixels
+       {
+         uint8 fg_color = src_buf[i * orig_pitch + j];
+
+         // Write 4x4 block, dithering partial alpha
+         for(int row = 0; row < 4; row++)
+         {
+           uint8 *row_ptr = pixels + row * row_stride + j * 4;
+           for(int k = 0; k < 4; k++)
+           {
+             if(alpha >= 255 || dither_visible(dest_x + j * 4 + k, dest_y + i * 4 + row, alpha))
+               row_ptr[k] = fg_color;
+           }
+         }
+       }
+     }
+     pixels += row_stride * 4; // Skip 4 rows
+   }
+ }
+ else if(surface->bits_per_pixel == 16)
  {
    uint16 *pixels = (uint16 *)surface->pixels;
    pixels += dest_y * surface->w + dest_x;
@@ -1817,9 +1879,49 @@ bool Screen::blit32WithOpacity(uint16 dest_x, uint16 dest_y, unsigned char *src_
  return true;
 }
 
+// Indices are copied as they are. opacity below 255 is dithered.
+inline bool Screen::blit8(uint16 dest_x, uint16 dest_y, unsigned char *src_buf, uint16 src_bpp, uint16 src_w, uint16 src_h, uint16 src_pitch, bool trans, uint8 opacity)
+{
+ uint8 *pixels;
+ uint16 i,j;
+
+ pixels = (uint8 *)surface->pixels;
+
+ pixels += dest_y * surface->w + dest_x;
+
+ if(!trans && opacity == 255)
+  {
+   for(i=0;i<src_h;i++)
+     {
+      memcpy(pixels, src_buf, src_w);
+      src_buf += src_pitch;
+      pixels += surface->w; //surface->pitch;
+     }
+
+   return true;
+  }
+
+ for(i=0;i<src_h;i++)
+   {
+    for(j=0;j<src_w;j++)
+      {
+       if(trans && src_buf[j] == 0xff)
+         continue;
+       if(opacity == 255 || dither_visible(dest_x + j, dest_y + i, opacity))
+         pixels[j] = src_buf[j];
+      }
+    src_buf += src_pitch;
+    pixels += surface->w; //pitch;
+   }
+
+ return true;
+}
+
 void Screen::blitbitmap(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color)
 {
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
+   blitbitmap8(dest_x, dest_y, src_buf, src_w, src_h, fg_color, bg_color);
+ else if(surface->bits_per_pixel == 16)
    blitbitmap16(dest_x, dest_y, src_buf, src_w, src_h, fg_color, bg_color);
  else
    blitbitmap32(dest_x, dest_y, src_buf, src_w, src_h, fg_color, bg_color);
@@ -1827,6 +1929,31 @@ void Screen::blitbitmap(uint16 dest_x, uint16 dest_y, const unsigned char *src_b
  return;
 }
 
+void Screen::blitbitmap8(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color)
+{
+ uint8 *pixels;
+ uint16 i,j;
+
+ pixels = (uint8 *)surface->pixels;
+
+ pixels += dest_y * surface->w + dest_x;
+
+ for(i=0;i<src_h;i++)
+  {
+   for(j=0;j<src_w;j++)
+    {
+     if(src_buf[j])
+       pixels[j] = fg_color;
+     else
+       pixels[j] = bg_color;
+    }
+   src_buf += src_w;
+   pixels += surface->w; //surface->pitch;
+  }
+
+ return;
+}
+
 void Screen::blitbitmap16(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color)
 {
  uint16 *pixels;
@@ -1883,7 +2010,24 @@ void Screen::blitbitmap3x(uint16 dest_x, uint16 dest_y, const unsigned char *src
 
  // Each source pixel becomes 3x3 destination pixels
  // Only draw foreground pixels (transparent background)
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
+ {
+   uint8 *pixels = (uint8 *)surface->pixels;
+
+   for(i=0; i<src_h; i++)
+   {
+     for(j=0; j<src_w; j++)
+     {
+       if(src_buf[j]) { // Only draw foreground, skip background (transparent)
+         // Fill 3x3 block
+         for(di=0; di<3; di++)
+           memset(pixels + (dest_y + i*3 + di) * surface->w + (dest_x + j*3), fg_color, 3);
+       }
+     }
+     src_buf += src_w;
+   }
+ }
+ else if(surface->bits_per_pixel == 16)
  {
    uint16 *pixels = (uint16 *)surface->pixels;
    uint16 color = (uint16)surface->colour32[fg_color];
@@ -1941,7 +2085,24 @@ void Screen::blitbitmap4x(uint16 dest_x, uint16 dest_y, const unsigned char *src
 
  // Each source pixel becomes 4x4 destination pixels
  // Only draw foreground pixels (transparent background)
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
+ {
+   uint8 *pixels = (uint8 *)surface->pixels;
+
+   for(i=0; i<src_h; i++)
+   {
+     for(j=0; j<src_w; j++)
+     {
+       if(src_buf[j]) { // Only draw foreground, skip background (transparent)
+         // Fill 4x4 block
+         for(di=0; di<4; di++)
+           memset(pixels + (dest_y + i*4 + di) * surface->w + (dest_x + j*4), fg_color, 4);
+       }
+     }
+     src_buf += src_w;
+   }
+ }
+ else if(surface->bits_per_pixel == 16)
  {
    uint16 *pixels = (uint16 *)surface->pixels;
    uint16 color = (uint16)surface->colour32[fg_color];
@@ -1993,6 +2154,144 @@ void Screen::blitbitmap4x(uint16 dest_x, uint16 dest_y, const unsigned char *src
  return;
 }
 
+/* Copy a tile already scaled and converted to the surface format. src_pixels
+ * is 16*scale pixels square. spans lists the opaque runs of the unscaled tile
+ * as (row, x, length) triplets, everything outside them is left untouched.
+ */
+void Screen::blit_scaled_tile(sint32 dest_x, sint32 dest_y, const unsigned char *src_pixels, uint8 scale, const uint8 *spans, uint16 num_spans, SDL_Rect *clip_rect)
+{
+ sint32 clip_x1 = 0, clip_y1 = 0, clip_x2 = width, clip_y2 = height;
+ uint16 size = 16 * scale;
+ uint8 bytes_per_pixel = surface->bytes_per_pixel;
+
+ if(clip_rect)
+   {
+    clip_x1 = MAX(clip_x1, clip_rect->x);
+    clip_y1 = MAX(clip_y1, clip_rect->y);
+    clip_x2 = MIN(clip_x2, clip_rect->x + clip_rect->w);
+    clip_y2 = MIN(clip_y2, clip_rect->y + clip_rect->h);
+   }
+
+ if(dest_x >= clip_x2 || dest_y >= clip_y2 || dest_x + size <= clip_x1 || dest_y + size <= clip_y1)
+   return;
+
+ unsigned char *pixels = (unsigned char *)surface->pixels;
+ uint32 dest_pitch = surface->w * bytes_per_pixel;
+ uint32 src_pitch = size * bytes_per_pixel;
+
+ for(uint16 i = 0; i < num_spans; i++, spans += 3)
+   {
+    sint32 x1 = dest_x + spans[1] * scale;
+    sint32 x2 = x1 + spans[2] * scale;
+    sint32 y1 = dest_y + spans[0] * scale;
+    sint32 y2 = y1 + scale;
+
+    if(x1 < clip_x1) x1 = clip_x1;
+    if(x2 > clip_x2) x2 = clip_x2;
+    if(y1 < clip_y1) y1 = clip_y1;
+    if(y2 > clip_y2) y2 = clip_y2;
+    if(x1 >= x2 || y1 >= y2)
+      continue;
+
+    const unsigned char *src = src_pixels + (y1 - dest_y) * src_pitch + (x1 - dest_x) * bytes_per_pixel;
+    unsigned char *dest = pixels + y1 * dest_pitch + x1 * bytes_per_pixel;
+    for(sint32 y = y1; y < y2; y++)
+      {
+       memcpy(dest, src, (x2 - x1) * bytes_per_pixel);
+       src += src_pitch;
+       dest += dest_pitch;
+      }
+   }
+}
+
+// Draw fg color wherever mask is non-zero. mask is an unscaled w x h coverage
+// map (e.g. a pre-scaled font glyph), clipped against the screen.
+void Screen::blitmask(sint32 dest_x, sint32 dest_y, const unsigned char *mask, uint16 mask_w, uint16 mask_h, uint8 color)
+{
+ sint32 src_x = 0;
+ sint32 src_y = 0;
+ sint32 w = mask_w;
+ sint32 h = mask_h;
+
+ if(dest_x >= (sint32)surface->w || dest_y >= (sint32)surface->h)
+   return;
+
+ if(dest_x < 0)
+   {
+    src_x = -dest_x;
+    w += dest_x;
+    dest_x = 0;
+   }
+
+ if(dest_y < 0)
+   {
+    src_y = -dest_y;
+    h += dest_y;
+    dest_y = 0;
+   }
+
+ if(dest_x + w > (sint32)surface->w)
+   w = surface->w - dest_x;
+
+ if(dest_y + h > (sint32)surface->h)
+   h = surface->h - dest_y;
+
+ if(w <= 0 || h <= 0)
+   return;
+
+ mask += src_y * mask_w + src_x;
+
+ if(surface->bits_per_pixel == 8)
+ {
+   uint8 *pixels = (uint8 *)surface->pixels + dest_y * surface->w + dest_x;
+
+   for(sint32 i = 0; i < h; i++)
+   {
+     for(sint32 j = 0; j < w; j++)
+     {
+       if(mask[j])
+         pixels[j] = color;
+     }
+     mask += mask_w;
+     pixels += surface->w;
+   }
+ }
+ else if(surface->bits_per_pixel == 16)
+ {
+   uint16 *pixels = (uint16 *)surface->pixels + dest_y * surface->w + dest_x;
+   uint16 fg = (uint16)surface->colour32[color];
+
+   for(sint32 i = 0; i < h; i++)
+   {
+     for(sint32 j = 0; j < w; j++)
+     {
+       if(mask[j])
+         pixels[j] = fg;
+     }
+     mask += mask_w;
+     pixels += surface->w;
+   }
+ }
+ else // 32-bit
+ {
+   uint32 *pixels = (uint32 *)surface->pixels + dest_y * surface->w + dest_x;
+   uint32 fg = surface->colour32[color];
+
+   for(sint32 i = 0; i < h; i++)
+   {
+     for(sint32 j = 0; j < w; j++)
+     {
+       if(mask[j])
+         pixels[j] = fg;
+     }
+     mask += mask_w;
+     pixels += surface->w;
+   }
+ }
+
+ return;
+}
+
 //4 is pure-light
 //0 is pitch-black
 //Globe of r 1 is just a single tile of 2
@@ -2126,6 +2425,7 @@ void Screen::clearalphamap8( uint16 x, uint16 y, uint16 w, uint16 h, uint8 opaci
         tile_scale = game->get_map_window()->get_map_tile_scale();
     }
     uint16 tile_pixels = 16 * tile_scale;
+    shading_tile_scale = tile_scale;
 
     if( shading_data == NULL )
     {
@@ -2164,9 +2464,79 @@ void Screen::clearalphamap8( uint16 x, uint16 y, uint16 w, uint16 h, uint8 opaci
         x_off = 0;
     //Light globe around the avatar
     if( lighting_style == LIGHTING_STYLE_ORIGINAL )
-        drawalphamap8globe( (shading_rect.w-1 + x_off/16)/2 - SHADING_BORDER, (shading_rect.h-1)/2 - SHADING_BORDER, opacity/20 + 4); //range 4 - 10
+    {
+        avatar_globe_x = (shading_rect.w-1 + x_off/16)/2 - SHADING_BORDER;
+        avatar_globe_y = (shading_rect.h-1)/2 - SHADING_BORDER;
+        avatar_globe_r = opacity/20 + 4; //range 4 - 10
+    }
+    else // LIGHTING_STYLE_SMOOTH
+    {
+        avatar_globe_x = (((shading_rect.w-(tile_pixels/2) + x_off)/tile_pixels)-1)/2 - SHADING_BORDER;
+        avatar_globe_y = (((shading_rect.h-(tile_pixels/2))/tile_pixels)-1)/2 - SHADING_BORDER;
+        avatar_globe_r = party_light_source ? 5 : 4;
+    }
+    drawalphamap8globe( avatar_globe_x, avatar_globe_y, avatar_globe_r );
+}
+
+/* Set an area of the shading map back to the state clearalphamap8() left it
+ * in, so the light globes over it can be drawn again clipped to the area.
+ */
+void Screen::resetalphamap8( const SDL_Rect *rect )
+{
+    if( shading_data == NULL || shading_ambient == 0xFF )
+        return;
+    if( lighting_style == LIGHTING_STYLE_NONE )
+        return;
+
+    for( sint32 j = rect->y; j < rect->y + rect->h; j++ )
+        memset( &shading_data[j*shading_rect.w + rect->x], shading_ambient, rect->w );
+
+    drawalphamap8globe( avatar_globe_x, avatar_globe_y, avatar_globe_r, rect );
+}
+
+/* Get the part of the shading map that drawalphamap8globe() would change for
+ * a globe. Returns false if the globe wouldn't change anything.
+ */
+bool Screen::get_alphamap8globe_rect( sint16 x, sint16 y, uint16 r, SDL_Rect *rect )
+{
+    if( r < 1 || shading_data == NULL )
+        return false;
+
+    sint32 x1, y1, x2, y2;
+    if( lighting_style == LIGHTING_STYLE_ORIGINAL )
+    {
+        sint32 rad = (r < 6) ? r - 1 : 5;
+        x1 = x + SHADING_BORDER - rad;
+        y1 = y + SHADING_BORDER - rad;
+        x2 = x + SHADING_BORDER + rad + 1;
+        y2 = y + SHADING_BORDER + rad + 1;
+    }
     else if( lighting_style == LIGHTING_STYLE_SMOOTH )
-        drawalphamap8globe( (((shading_rect.w-(tile_pixels/2) + x_off)/tile_pixels)-1)/2 - SHADING_BORDER, (((shading_rect.h-(tile_pixels/2))/tile_pixels)-1)/2 - SHADING_BORDER, party_light_source ? 5 : 4 );
+    {
+        uint16 tile_pixels = 16 * shading_tile_scale;
+        sint32 cx = (x+SHADING_BORDER)*tile_pixels + (tile_pixels / 2);
+        sint32 cy = (y+SHADING_BORDER)*tile_pixels + (tile_pixels / 2);
+        sint32 scaled_radius = globeradius_2[MIN(r, NUM_GLOBES) - 1] * shading_tile_scale;
+        x1 = cx - scaled_radius;
+        y1 = cy - scaled_radius;
+        x2 = cx + scaled_radius;
+        y2 = cy + scaled_radius;
+    }
+    else
+        return false;
+
+    x1 = MAX(x1, 0);
+    y1 = MAX(y1, 0);
+    x2 = MIN(x2, (sint32)shading_rect.w);
+    y2 = MIN(y2, (sint32)shading_rect.h);
+    if( x1 >= x2 || y1 >= y2 )
+        return false;
+
+    rect->x = x1;
+    rect->y = y1;
+    rect->w = x2 - x1;
+    rect->h = y2 - y1;
+    return true;
 }
 
 void Screen::buildalphamap8()
@@ -2216,7 +2586,8 @@ void Screen::buildalphamap8()
 }
 
 
-void Screen::drawalphamap8globe( sint16 x, sint16 y, uint16 r )
+// clip: only change this part of the shading map (shading map pixels)
+void Screen::drawalphamap8globe( sint16 x, sint16 y, uint16 r, const SDL_Rect *clip )
 {
     sint16 i,j;
 // check shouldn't be needed since items only have 3 intensites
@@ -2246,17 +2617,16 @@ void Screen::drawalphamap8globe( sint16 x, sint16 y, uint16 r )
 					continue;
 				if( y + j - rad < 0 || y + j - rad >= shading_rect.h  )
 					continue;
+				if( clip && (x + i - rad < clip->x || x + i - rad >= clip->x + clip->w
+				             || y + j - rad < clip->y || y + j - rad >= clip->y + clip->h) )
+					continue;
 				shading_data[(y+j-rad)*shading_rect.w+(x+i-rad)] = MIN( shading_data[(y+j-rad)*shading_rect.w+(x+i-rad)] + TileGlobe[r-1][j*(rad*2+1)+i], 4 );
 			}
         return;
     }
 
-    // Get tile_scale for SMOOTH lighting pixel calculations
-    uint8 tile_scale = 1;
-    Game *game = Game::get_game();
-    if(game && game->get_map_window()) {
-        tile_scale = game->get_map_window()->get_map_tile_scale();
-    }
+    // tile_scale for SMOOTH lighting pixel calculations, set by clearalphamap8()
+    uint8 tile_scale = shading_tile_scale;
     uint16 tile_pixels = 16 * tile_scale;
 
     x = (x+SHADING_BORDER)*tile_pixels + (tile_pixels / 2);
@@ -2269,8 +2639,18 @@ void Screen::drawalphamap8globe( sint16 x, sint16 y, uint16 r )
     // Scale the globe radius by tile_scale
     sint16 scaled_radius = globeradius_2[r] * tile_scale;
 
-    for(i=-scaled_radius;i<scaled_radius;i++)
-        for(j=-scaled_radius;j<scaled_radius;j++)
+    sint16 i_start = -scaled_radius, i_end = scaled_radius;
+    sint16 j_start = -scaled_radius, j_end = scaled_radius;
+    if( clip )
+    {
+        i_start = MAX(i_start, clip->y - y);
+        i_end = MIN(i_end, clip->y + clip->h - y);
+        j_start = MAX(j_start, clip->x - x);
+        j_end = MIN(j_end, clip->x + clip->w - x);
+    }
+
+    for(i=i_start;i<i_end;i++)
+        for(j=j_start;j<j_end;j++)
         {
             if( (y+i)-1 < 0 ||
                 (x+j)-1 < 0 ||
@@ -2410,8 +2790,35 @@ void Screen::blitalphamap8(sint16 x, sint16 y, SDL_Rect *clip_rect)
      }
 
 
+    BlitPixelFormat format;
+    format.Rmask = surface->Rmask;
+    format.Gmask = surface->Gmask;
+    format.Bmask = surface->Bmask;
+    format.Rshift = surface->Rshift;
+    format.Gshift = surface->Gshift;
+    format.Bshift = surface->Bshift;
+
     switch( surface->bits_per_pixel )
     {
+    case 8:
+        // no channels to scale, darken by dithering toward black
+        uint8 *pixels8;
+        pixels8 = (uint8 *)surface->pixels;
+
+        pixels8 += y*surface->w+x;
+
+        for(i=0;i<src_h;i++)
+        {
+            for(j=0;j<src_w;j++)
+            {
+                if(!dither_visible(x+j, y+i, src_buf[j]))
+                    pixels8[j] = 0;
+            }
+            pixels8 += surface->w;
+            src_buf += shading_rect.w;
+        }
+        return;
+        break;
     case 16:
         uint16 *pixels16;
         pixels16 = (uint16 *)surface->pixels;
@@ -2420,12 +2827,7 @@ void Screen::blitalphamap8(sint16 x, sint16 y, SDL_Rect *clip_rect)
 
         for(i=0;i<src_h;i++)
         {
-            for(j=0;j<src_w;j++)
-            {
-                pixels16[j] = ( ( (unsigned char)(( (float)(( pixels16[j] & surface->Rmask ) >> surface->Rshift)) * (float)(src_buf[j])/255.0f) ) << surface->Rshift ) | //R
-                              ( ( (unsigned char)(( (float)(( pixels16[j] & surface->Gmask ) >> surface->Gshift)) * (float)(src_buf[j])/255.0f) ) << surface->Gshift ) | //G
-                              ( ( (unsigned char)(( (float)(( pixels16[j] & surface->Bmask ) >> surface->Bshift)) * (float)(src_buf[j])/255.0f) ) << surface->Bshift );  //B
-            }
+            blit_kernels.shade_row16(pixels16, src_buf, src_w, &format);
             pixels16 += surface->w;
             src_buf += shading_rect.w;
         }
@@ -2440,12 +2842,7 @@ void Screen::blitalphamap8(sint16 x, sint16 y, SDL_Rect *clip_rect)
 
         for(i=0;i<src_h;i++)
         {
-            for(j=0;j<src_w;j++)
-            {
-            	pixels[j] = ( ( (unsigned char)(( (float)(( pixels[j] & surface->Rmask ) >> surface->Rshift)) * (float)(src_buf[j])/255.0f) ) << surface->Rshift ) | //R
-                            ( ( (unsigned char)(( (float)(( pixels[j] & surface->Gmask ) >> surface->Gshift)) * (float)(src_buf[j])/255.0f) ) << surface->Gshift ) | //G
-                            ( ( (unsigned char)(( (float)(( pixels[j] & surface->Bmask ) >> surface->Bshift)) * (float)(src_buf[j])/255.0f) ) << surface->Bshift );  //B
-            }
+            blit_kernels.shade_row32(pixels, src_buf, src_w, &format);
             pixels += surface->w;
             src_buf += shading_rect.w;
         }
@@ -2466,7 +2863,11 @@ SDL_Surface *Screen::create_sdl_surface_8(unsigned char *src_buf, uint16 src_w,
     SDL_Surface *new_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, src_w, src_h, 8, 0, 0, 0, 0);
     unsigned char *pixels = (unsigned char *)new_surface->pixels;
 
-    if(surface->bits_per_pixel == 16)
+    if(surface->bits_per_pixel == 8)
+    {
+        memcpy(pixels, src_buf, src_w * src_h);
+    }
+    else if(surface->bits_per_pixel == 16)
     {
         uint16 *src = (uint16 *)src_buf;
         for(int p = 0; p < (src_w * src_h); p++)
@@ -2497,10 +2898,26 @@ SDL_Surface *Screen::create_sdl_surface_from(unsigned char *src_buf, uint16 src_
  SDL_Surface *new_surface;
  uint16 i,j;
 
- new_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, src_w, src_h, surface->bits_per_pixel,
-                                    surface->Rmask, surface->Gmask, surface->Bmask, 0);
+ // SDL2 won't create an 8 bit surface with colour masks, it has a palette
+ if(surface->bits_per_pixel == 8)
+   new_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, src_w, src_h, 8, 0, 0, 0, 0);
+ else
+   new_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, src_w, src_h, surface->bits_per_pixel,
+                                      surface->Rmask, surface->Gmask, surface->Bmask, 0);
 
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
+   {
+    uint8 *pixels = (uint8 *)new_surface->pixels;
+
+    set_sdl_palette(new_surface);
+    for(i=0;i<src_h;i++)
+      {
+       memcpy(pixels, src_buf, src_w);
+       src_buf += src_pitch;
+       pixels += new_surface->pitch;
+      }
+   }
+ else if(surface->bits_per_pixel == 16)
    {
     uint16 *pixels = (uint16 *)new_surface->pixels;
 
@@ -2541,10 +2958,26 @@ SDL_Surface *Screen::create_sdl_surface_from_4x(unsigned char *src_buf, uint16 s
  uint16 dest_w = src_w * 4;
  uint16 dest_h = src_h * 4;
 
- new_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, dest_w, dest_h, surface->bits_per_pixel,
-                                    surface->Rmask, surface->Gmask, surface->Bmask, 0);
+ // SDL2 won't create an 8 bit surface with colour masks, it has a palette
+ if(surface->bits_per_pixel == 8)
+   new_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, dest_w, dest_h, 8, 0, 0, 0, 0);
+ else
+   new_surface = SDL_CreateRGBSurface(SDL_SWSURFACE, dest_w, dest_h, surface->bits_per_pixel,
+                                      surface->Rmask, surface->Gmask, surface->Bmask, 0);
 
- if(surface->bits_per_pixel == 16)
+ if(surface->bits_per_pixel == 8)
+   {
+    uint8 *pixels = (uint8 *)new_surface->pixels;
+
+    set_sdl_palette(new_surface);
+    for(i=0;i<src_h;i++)
+      {
+       blit_kernels.scale_rows8(pixels, new_surface->pitch, src_buf, src_w, 4, false);
+       src_buf += src_pitch;
+       pixels += new_surface->pitch * 4;
+      }
+   }
+ else if(surface->bits_per_pixel == 16)
    {
     uint16 *pixels = (uint16 *)new_surface->pixels;
 
@@ -2602,7 +3035,9 @@ uint16 Screen::get_bpp()
 
 void Screen::update()
 {
- if(scaler)
+ if(indexed)
+   expand_area(0, 0, surface->w, surface->h);
+ else if(scaler)
   {
    scaler->Scale(surface->format_type, surface->pixels,		// type, source
                  0, 0, surface->w, surface->h,							// x, y, w, h
@@ -2613,7 +3048,7 @@ void Screen::update()
   }
 
 #if SDL_VERSION_ATLEAST(2, 0, 0)
-    SDL_UpdateTexture(sdlTexture, NULL, sdl_surface->pixels, sdl_surface->pitch);
+    upload_texture(NULL, 0);
     SDL_RenderClear(sdlRenderer);
     SDL_RenderCopy(sdlRenderer, sdlTexture, NULL, NULL);
     SDL_RenderPresent(sdlRenderer);
@@ -2648,7 +3083,7 @@ void Screen::update(sint32 x, sint32 y, uint16 w, uint16 h)
  if((x + w) > width) w = width - x;
  if((y + h) > height) h = height - y;
 
- if(scaler)
+ if(scaler && !indexed) // indexed mode scales in preformUpdate()
   {
    scaler->Scale(surface->format_type, surface->pixels,		// type, source
                  x, y, w, h,							// x, y, w, h
@@ -2680,8 +3115,15 @@ void Screen::update(sint32 x, sint32 y, uint16 w, uint16 h)
 
 void Screen::preformUpdate()
 {
+ if(indexed)
+   expand_update_rects();
+
 #if SDL_VERSION_ATLEAST(2, 0, 0)
-    SDL_UpdateTexture(sdlTexture, NULL, sdl_surface->pixels, sdl_surface->pitch);
+    if(dirty_rect_update && !full_update_required)
+        upload_texture(update_rects, merge_update_rects());
+    else
+        upload_texture(NULL, 0);
+
     SDL_RenderClear(sdlRenderer);
     SDL_RenderCopy(sdlRenderer, sdlTexture, NULL, NULL);
     SDL_RenderPresent(sdlRenderer);
@@ -2691,6 +3133,174 @@ void Screen::preformUpdate()
  num_update_rects = 0;
 }
 
+// Expand what preformUpdate() is about to present from the indexed surface.
+void Screen::expand_update_rects()
+{
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+ // the whole texture is uploaded, so all of it has to be current
+ if(!scaler && (!dirty_rect_update || full_update_required))
+   {
+    expand_area(0, 0, surface->w, surface->h);
+    return;
+   }
+#endif
+
+ for(uint16 i = 0; i < num_update_rects; i++)
+   {
+    expand_area(update_rects[i].x / scale_factor, update_rects[i].y / scale_factor,
+                update_rects[i].w / scale_factor, update_rects[i].h / scale_factor);
+   }
+}
+
+/* Turn palette indices in surface into display colours. The point scaler is
+ * done by the blit kernels straight into sdl_surface, any other scaler gets
+ * an unscaled rgb_surface to read, like it would outside indexed mode.
+ */
+void Screen::expand_area(sint32 x, sint32 y, uint16 w, uint16 h)
+{
+ unsigned char *dest;
+ uint32 dest_pitch;
+ uint8 scale = 1;
+
+ if(x < 0 || y < 0 || x + w > surface->w || y + h > surface->h || w == 0 || h == 0)
+   return;
+
+ if(scaler && scaler == scaler_reg.GetPointScaler())
+   {
+    scale = scale_factor;
+    dest = (unsigned char *)sdl_surface->pixels;
+    dest_pitch = sdl_surface->pitch / sdl_surface->format->BytesPerPixel;
+   }
+ else
+   {
+    dest = (unsigned char *)rgb_surface->pixels;
+    dest_pitch = rgb_surface->pitch / rgb_surface->bytes_per_pixel;
+   }
+
+ const unsigned char *src = (const unsigned char *)surface->pixels + y * surface->pitch + x;
+ uint32 dest_offset = (y * dest_pitch + x) * scale;
+
+ if(rgb_surface->bits_per_pixel == 16)
+   {
+    uint16 *pixels = (uint16 *)dest + dest_offset;
+    for(uint16 i = 0; i < h; i++)
+      {
+       blit_kernels.scale_rows16(pixels, dest_pitch, src, w, surface->colour32, scale, false);
+       src += surface->pitch;
+       pixels += dest_pitch * scale;
+      }
+   }
+ else
+   {
+    uint32 *pixels = (uint32 *)dest + dest_offset;
+    for(uint16 i = 0; i < h; i++)
+      {
+       blit_kernels.scale_rows32(pixels, dest_pitch, src, w, surface->colour32, scale, false);
+       src += surface->pitch;
+       pixels += dest_pitch * scale;
+      }
+   }
+
+ if(scaler && scale == 1)
+  {
+   scaler->Scale(rgb_surface->format_type, rgb_surface->pixels,		// type, source
+                 x, y, w, h,							// x, y, w, h
+                 rgb_surface->pitch/rgb_surface->bytes_per_pixel, rgb_surface->h,	// pixels/line, pixels/col
+                 sdl_surface->pixels,									// dest
+                 sdl_surface->pitch/sdl_surface->format->BytesPerPixel,	// destpixels/line
+                 scale_factor);
+  }
+}
+
+#if SDL_VERSION_ATLEAST(2, 0, 0)
+// Clip update_rects to sdl_surface and merge rects that overlap or sit close
+// enough that one upload is cheaper than two. Returns the new rect count.
+uint16 Screen::merge_update_rects()
+{
+ uint16 n = 0;
+
+ for(uint16 i = 0; i < num_update_rects; i++)
+   {
+    SDL_Rect r = update_rects[i];
+    if(r.x + r.w > sdl_surface->w)
+      r.w = sdl_surface->w - r.x;
+    if(r.y + r.h > sdl_surface->h)
+      r.h = sdl_surface->h - r.y;
+    if(r.w <= 0 || r.h <= 0)
+      continue;
+    update_rects[n++] = r;
+   }
+
+ bool merged = true;
+ while(merged)
+   {
+    merged = false;
+    for(uint16 i = 0; i < n && !merged; i++)
+      {
+       for(uint16 j = i + 1; j < n; j++)
+         {
+          SDL_Rect *a = &update_rects[i];
+          SDL_Rect *b = &update_rects[j];
+          sint32 x1 = a->x < b->x ? a->x : b->x;
+          sint32 y1 = a->y < b->y ? a->y : b->y;
+          sint32 x2 = a->x + a->w > b->x + b->w ? a->x + a->w : b->x + b->w;
+          sint32 y2 = a->y + a->h > b->y + b->h ? a->y + a->h : b->y + b->h;
+
+          // merge if the union wastes no more than a quarter of its area
+          uint32 union_area = (x2 - x1) * (y2 - y1);
+          uint32 sum_area = a->w * a->h + b->w * b->h;
+          if(union_area * 3 <= sum_area * 4)
+            {
+             a->x = x1;
+             a->y = y1;
+             a->w = x2 - x1;
+             a->h = y2 - y1;
+             update_rects[j] = update_rects[--n];
+             merged = true;
+             break;
+            }
+         }
+      }
+   }
+
+ return n;
+}
+
+// Copy sdl_surface to the texture. rects == NULL uploads the whole surface.
+void Screen::upload_texture(SDL_Rect *rects, uint16 count)
+{
+ uint32 bytes = 0;
+ uint8 bpp = sdl_surface->format->BytesPerPixel;
+
+ if(rects == NULL)
+   {
+    SDL_UpdateTexture(sdlTexture, NULL, sdl_surface->pixels, sdl_surface->pitch);
+    bytes = sdl_surface->w * sdl_surface->h * bpp;
+    full_update_required = false;
+   }
+ else
+   {
+    for(uint16 i = 0; i < count; i++)
+      {
+       uint8 *pixels = (uint8 *)sdl_surface->pixels + rects[i].y * sdl_surface->pitch + rects[i].x * bpp;
+       SDL_UpdateTexture(sdlTexture, &rects[i], pixels, sdl_surface->pitch);
+       bytes += rects[i].w * rects[i].h * bpp;
+      }
+   }
+
+ update_bytes = bytes;
+ update_bytes_total += bytes;
+ update_frames++;
+ if(update_frames == 300)
+   {
+    DEBUG(0,LEVEL_DEBUGGING,"Screen: %s upload averaging %d bytes/frame\n",
+          dirty_rect_update ? "dirty rect" : "full", update_bytes_total / update_frames);
+    update_bytes_total = 0;
+    update_frames = 0;
+   }
+}
+#endif
+
 void Screen::lock()
 {
 // SDL_LockSurface(scaled_surface);
@@ -2784,6 +3394,7 @@ bool Screen::create_sdl_surface_and_texture(sint32 w, sint32 h, Uint32 format)
                                    format,
                                    SDL_TEXTUREACCESS_STREAMING,
                                    w, h);
+    full_update_required = true;
 
     if(sdlTexture == NULL) {
         SDL_FreeSurface(sdl_surface);
@@ -2889,6 +3500,13 @@ void Screen::set_screen_mode()
 
 	surface->set_format(sdl_surface->format);
 
+	// draw into palette indices, surface is expanded to rgb_surface when presented
+	if (indexed) {
+		rgb_surface = surface;
+		surface = CreateRenderSurface(width, height, 8);
+		DEBUG(0,LEVEL_NOTIFICATION,"Using an indexed back buffer\n");
+	}
+
 
 //	if (zbuffer) screen->create_zbuffer();
 }
@@ -2943,6 +3561,7 @@ bool Screen::set_fullscreen(bool value)
 {
 #if SDL_VERSION_ATLEAST(2, 0, 0)
     fullscreen = value;
+    full_update_required = true;
     Uint32 windowFlags = SDL_GetWindowFlags(sdlWindow);
 
     if(fullscreen)
@@ -3077,6 +3696,9 @@ bool Screen::try_scaler(int w, int h, uint32 flags, int hwdepth)
 //Note! assumes area divides evenly by down_scale factor
 unsigned char *Screen::copy_area(SDL_Rect *area, uint16 down_scale)
 {
+ if(surface->bits_per_pixel == 8)
+   return(copy_area8(area, down_scale, false));
+
  if(surface->bits_per_pixel == 16)
    return(copy_area16(area, down_scale));
 
@@ -3146,6 +3768,52 @@ unsigned char *Screen::copy_area16(SDL_Rect *area, uint16 down_scale)
  return dst_pixels;
 }
 
+// Colours come from the palette array, so rotated colours are as shown.
+unsigned char *Screen::copy_area8(SDL_Rect *area, uint16 down_scale, bool point_sample)
+{
+ unsigned char *dst_pixels = NULL;
+ unsigned char *ptr;
+ uint8 *src_pixels;
+ uint32 r,g,b;
+ uint16 x, y;
+ uint8 x1, y1;
+ uint8 samples = point_sample ? 1 : down_scale;
+
+ dst_pixels = new unsigned char[((area->w / down_scale) * (area->h / down_scale)) * 3];
+ ptr = dst_pixels;
+
+ for(y = 0; y < area->h; y += down_scale)
+  {
+   for(x = 0; x < area->w; x += down_scale)
+    {
+     r = 0;
+     g = 0;
+     b = 0;
+
+     src_pixels = (uint8 *)surface->pixels;
+     src_pixels += ((area->y + y) * surface->w + (area->x + x));
+
+     for(y1 = 0; y1 < samples; y1++)
+      {
+       for(x1 = 0; x1 < samples; x1++)
+        {
+         r += palette[src_pixels[x1] * 3];
+         g += palette[src_pixels[x1] * 3 + 1];
+         b += palette[src_pixels[x1] * 3 + 2];
+        }
+       src_pixels += surface->w;
+      }
+
+     ptr[0] = (uint8)(r/(samples*samples));
+     ptr[1] = (uint8)(g/(samples*samples));
+     ptr[2] = (uint8)(b/(samples*samples));
+     ptr += 3;
+    }
+  }
+
+ return dst_pixels;
+}
+
 unsigned char *Screen::copy_area32(SDL_Rect *area, uint16 down_scale)
 {
  SDL_PixelFormat *fmt;
@@ -3218,6 +3886,9 @@ unsigned char *Screen::copy_area_point(SDL_Rect *area, uint16 down_scale)
  unsigned char *ptr;
  uint16 x, y;
 
+ if(surface->bits_per_pixel == 8)
+   return(copy_area8(area, down_scale, true));
+
  dst_pixels = new unsigned char[((area->w / down_scale) * (area->h / down_scale)) * 3];
  ptr = dst_pixels;
 
@@ -3277,6 +3948,8 @@ unsigned char *Screen::copy_area(SDL_Rect *area, unsigned char *buf)
     if(!area)
         area = &screen_area;
 
+    if(surface->bits_per_pixel == 8)
+        return(copy_area8(area, buf));
     if(surface->bits_per_pixel == 16)
         return(copy_area16(area, buf));
     return(copy_area32(area, buf));
@@ -3293,7 +3966,9 @@ void Screen::restore_area(unsigned char *pixels, SDL_Rect *area,
     if(!area)
         area = &screen_area;
 
-    if(surface->bits_per_pixel == 16)
+    if(surface->bits_per_pixel == 8)
+        restore_area8(pixels, area, target, target_area, free_src);
+    else if(surface->bits_per_pixel == 16)
         restore_area16(pixels, area, target, target_area, free_src);
     else
         restore_area32(pixels, area, target, target_area, free_src);
@@ -3452,6 +4127,80 @@ void Screen::restore_area16(unsigned char *pixels, SDL_Rect *area,
     }
 }
 
+unsigned char *Screen::copy_area8(SDL_Rect *area, unsigned char *buf)
+{
+  uint8 *copied = (uint8 *)buf;
+  if(buf==NULL)
+  {
+    copied = (uint8 *)malloc(area->w * area->h);
+  }
+  uint8 *dest = copied;
+  uint8 *src = (uint8 *)surface->pixels;
+  uint16 src_x_off = abs(area->x);
+  uint16 src_y_off = abs(area->y);
+  uint16 src_w = area->w;
+  uint16 src_h = area->h;
+
+  if(area->x < 0)
+  {
+    src_x_off = 0;
+    src_w += area->x;
+    dest += abs(area->x);
+  }
+
+  if(area->y < 0)
+  {
+    src_y_off = 0;
+    src_h += area->y;
+    dest += (area->w * abs(area->y));
+  }
+
+  if(src_x_off + src_w > surface->w)
+  {
+    src_w -= ((src_x_off + src_w) - surface->w);
+  }
+
+  if(src_y_off + src_h > surface->h)
+  {
+    src_h -= ((src_y_off + src_h) - surface->h);
+  }
+
+  src += src_y_off * surface->w + src_x_off;
+
+  for(uint32 i = 0; i < src_h; i++)
+  {
+      memcpy(dest, src, src_w);
+      dest += area->w;
+      src += surface->w;
+  }
+  return((unsigned char *)copied);
+}
+
+
+void Screen::restore_area8(unsigned char *pixels, SDL_Rect *area,
+                           unsigned char *target, SDL_Rect *target_area, bool free_src)
+{
+    uint8 *src = (uint8 *)pixels;
+    uint8 *dest = (uint8 *)surface->pixels;
+            dest += area->y * surface->w + area->x;
+    if(target) // restore to target instead of screen
+    {
+        dest = (uint8 *)target;
+        dest += (area->y-target_area->y) * target_area->w + (area->x-target_area->x);
+    }
+
+    for(uint32 i = 0; i < area->h; i++)
+    {
+        memcpy(dest, src, area->w);
+        src += area->w;
+        dest += target ? target_area->w : surface->w;
+    }
+    if(free_src)
+    {
+        free(pixels);
+    }
+}
+
 void Screen::draw_line (int sx, int sy, int ex, int ey, uint8 color)
 {
 	if(surface == NULL)
@@ -3558,7 +4307,54 @@ bool Screen::blitSurface3x(sint32 dest_x, sint32 dest_y, SDL_Surface *src_surfac
 
     SDL_LockSurface(src_surface);
 
-    if (surface->bits_per_pixel == 16) {
+    if (surface->bits_per_pixel == 8) {
+        uint8 *pixels = (uint8 *)surface->pixels;
+        SDL_PixelFormat *index_format = surface->get_sdl_surface()->format;
+        sint16 index_map[256]; // paletted sources map each colour once
+        for (int i = 0; i < 256; i++)
+            index_map[i] = -1;
+
+        for (sint32 sy = 0; sy < src_h; sy++) {
+            for (sint32 sx = 0; sx < src_w; sx++) {
+                // Get source pixel as the nearest game colour
+                Uint32 pixel;
+                Uint8 *src_ptr = (Uint8 *)src_surface->pixels + (src_y_start + sy) * src_surface->pitch;
+
+                if (src_surface->format->BytesPerPixel == 1) {
+                    Uint8 idx = src_ptr[src_x_start + sx];
+                    if (use_transparency && idx == transparent_color) continue;
+                    if (index_map[idx] < 0) {
+                        SDL_Color col = src_surface->format->palette->colors[idx];
+                        index_map[idx] = (sint16)SDL_MapRGB(index_format, col.r, col.g, col.b);
+                    }
+                    pixel = (Uint32)index_map[idx];
+                } else if (src_surface->format->BytesPerPixel == 2 || src_surface->format->BytesPerPixel == 4) {
+                    Uint32 src_pixel;
+                    if (src_surface->format->BytesPerPixel == 2)
+                        src_pixel = ((Uint16 *)src_ptr)[src_x_start + sx];
+                    else
+                        src_pixel = ((Uint32 *)src_ptr)[src_x_start + sx];
+                    if (use_transparency && src_pixel == transparent_color) continue;
+                    Uint8 r, g, b;
+                    SDL_GetRGB(src_pixel, src_surface->format, &r, &g, &b);
+                    pixel = SDL_MapRGB(index_format, r, g, b);
+                } else {
+                    continue;
+                }
+
+                // Draw 3x3 block
+                for (int dy = 0; dy < 3; dy++) {
+                    sint32 py = dest_y + sy * 3 + dy;
+                    if (py < 0 || py >= (sint32)screen_height) continue;
+                    for (int dx = 0; dx < 3; dx++) {
+                        sint32 px = dest_x + sx * 3 + dx;
+                        if (px < 0 || px >= (sint32)screen_width) continue;
+                        pixels[py * surface->w + px] = (uint8)pixel;
+                    }
+                }
+            }
+        }
+    } else if (surface->bits_per_pixel == 16) {
         uint16 *pixels = (uint16 *)surface->pixels;
         for (sint32 sy = 0; sy < src_h; sy++) {
             for (sint32 sx = 0; sx < src_w; sx++) {
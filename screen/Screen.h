@@ -30,6 +30,7 @@
 #include "Game.h"
 #include "Surface.h"
 #include "Scale.h"
+#include "BlitKernels.h"
 
 #define LIGHTING_STYLE_NONE 0
 #define LIGHTING_STYLE_SMOOTH 1
@@ -42,6 +43,8 @@ class Screen
  Configuration *config;
  SDL_Surface *sdl_surface;
  RenderSurface *surface;
+ RenderSurface *rgb_surface; // indexed mode: surface holds palette indices and is expanded into this at present time
+ bool indexed;               // config/video/indexed_back_buffer
 #if SDL_VERSION_ATLEAST(2, 0, 0)
  SDL_Window *sdlWindow;
  SDL_Renderer *sdlRenderer;
@@ -59,17 +62,31 @@ class Screen
  bool non_square_pixels;
 
  uint8 palette[768];
+ uint32 palette_version; // bumped by set_palette()/set_palette_entry() and when rotate_palette() cycles a new range
+ uint32 palette_rotation_count; // bumped by rotate_palette()
+ bool palette_rotating[256]; // colours that rotate_palette() has cycled
  uint16 width;
  uint16 height;
  SDL_Rect *update_rects;
  uint16 num_update_rects;
  uint16 max_update_rects;
 
+ bool dirty_rect_update;     // only upload update_rects to the texture in preformUpdate()
+ bool full_update_required;  // texture contents unknown, next present must upload everything
+ uint32 update_bytes;        // bytes uploaded by the last present
+ uint32 update_bytes_total;  // bytes uploaded since the last stats report
+ uint32 update_frames;
+
  SDL_Rect shading_rect;
  uint8 *shading_data;
  uint8 *shading_globe[6];
  uint8 shading_ambient;
  uint8 *shading_tile[4];
+ uint8 shading_tile_scale; // map tile scale when the shading map was last cleared
+ sint16 avatar_globe_x, avatar_globe_y; // light globe drawn by clearalphamap8()
+ uint16 avatar_globe_r;
+
+ BlitKernels blit_kernels; // inner loops of the scaled blits and smooth lighting
 
  public:
    Screen(Configuration *cfg);
@@ -79,6 +96,7 @@ class Screen
 
    bool is_fullscreen() { return fullscreen; }
    bool is_non_square_pixels() { return non_square_pixels; }
+   bool is_indexed() { return indexed; }
    int get_scaler_index() { return scaler_index; }
    ScalerRegistry *get_scaler_reg() { return &scaler_reg; }
    bool toggle_darkness_cheat();
@@ -99,6 +117,10 @@ class Screen
    uint16 get_width() { return width; }
    uint16 get_height() { return height; }
    const uint8 *get_palette() { return palette; }
+   uint32 get_palette_version() { return palette_version; }
+   uint32 get_palette_rotation_count() { return palette_rotation_count; }
+   bool is_rotating_colour(uint8 idx) { return palette_rotating[idx]; }
+   uint32 get_colour32(uint8 idx) { return surface->colour32[idx]; }
    uint16 get_translated_x(uint16 x);
    uint16 get_translated_y(uint16 y);
 
@@ -116,11 +138,15 @@ class Screen
    void blitbitmap(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color);
    void blitbitmap3x(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color);
    void blitbitmap4x(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color);
+   void blitmask(sint32 dest_x, sint32 dest_y, const unsigned char *mask, uint16 mask_w, uint16 mask_h, uint8 color);
+   void blit_scaled_tile(sint32 dest_x, sint32 dest_y, const unsigned char *src_pixels, uint8 scale, const uint8 *spans, uint16 num_spans, SDL_Rect *clip_rect=NULL);
    bool blitSurface3x(sint32 dest_x, sint32 dest_y, SDL_Surface *src_surface, SDL_Rect *src_rect = NULL, uint32 transparent_color = 0, bool use_transparency = false);
 
    void buildalphamap8();
    void clearalphamap8( uint16 x, uint16 y, uint16 w, uint16 h, uint8 opacity, bool party_light_source);
-   void drawalphamap8globe( sint16 x, sint16 y, uint16 radius );
+   void drawalphamap8globe( sint16 x, sint16 y, uint16 radius, const SDL_Rect *clip=NULL );
+   bool get_alphamap8globe_rect( sint16 x, sint16 y, uint16 radius, SDL_Rect *rect );
+   void resetalphamap8( const SDL_Rect *rect );
    void blitalphamap8(sint16 x, sint16 y, SDL_Rect *clip_rect);
 
    int get_lighting_style() { return lighting_style; }
@@ -133,6 +159,7 @@ class Screen
    void update();
    void update(sint32 x, sint32 y, uint16 w, uint16 h);
    void preformUpdate();
+   uint32 get_update_bytes() { return update_bytes; }
    void lock();
    void unlock();
 
@@ -160,8 +187,11 @@ protected:
 
    bool fill32(uint8 colour_num, uint16 x, uint16 y, sint16 w, sint16 h);
 
+   bool fill8(uint8 colour_num, uint16 x, uint16 y, sint16 w, sint16 h);
+
    void fade16(uint16 dest_x, uint16 dest_y, uint16 src_w, uint16 src_h, uint8 opacity, uint8 fade_bg_color);
    void fade32(uint16 dest_x, uint16 dest_y, uint16 src_w, uint16 src_h, uint8 opacity, uint8 fade_bg_color);
+   void fade8(uint16 dest_x, uint16 dest_y, uint16 src_w, uint16 src_h, uint8 opacity, uint8 fade_bg_color);
 
    inline uint16 blendpixel16(uint16 p, uint16 p1, uint8 opacity);
    inline uint32 blendpixel32(uint32 p, uint32 p1, uint8 opacity);
@@ -172,17 +202,24 @@ inline bool blit16WithOpacity(uint16 dest_x, uint16 dest_y, unsigned char *src_b
 inline bool blit32(uint16 dest_x, uint16 dest_y, unsigned char *src_buf, uint16 src_bpp, uint16 src_w, uint16 src_h, uint16 src_pitch, bool trans);
 inline bool blit32WithOpacity(uint16 dest_x, uint16 dest_y, unsigned char *src_buf, uint16 src_bpp, uint16 src_w, uint16 src_h, uint16 src_pitch, bool trans, uint8 opacity);
 
+inline bool blit8(uint16 dest_x, uint16 dest_y, unsigned char *src_buf, uint16 src_bpp, uint16 src_w, uint16 src_h, uint16 src_pitch, bool trans, uint8 opacity);
+
 inline void blitbitmap16(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color);
 
 inline void blitbitmap32(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color);
 
+inline void blitbitmap8(uint16 dest_x, uint16 dest_y, const unsigned char *src_buf, uint16 src_w, uint16 src_h, uint8 fg_color, uint8 bg_color);
+
    unsigned char *copy_area16(SDL_Rect *area, uint16 down_scale);
    unsigned char *copy_area32(SDL_Rect *area, uint16 down_scale);
+   unsigned char *copy_area8(SDL_Rect *area, uint16 down_scale, bool point_sample);
 
    unsigned char *copy_area16(SDL_Rect *area, unsigned char *buf);
    unsigned char *copy_area32(SDL_Rect *area, unsigned char *buf);
+   unsigned char *copy_area8(SDL_Rect *area, unsigned char *buf);
    void restore_area16(unsigned char *pixels, SDL_Rect *area, unsigned char *target = NULL, SDL_Rect *target_area = NULL, bool free_src = true);
    void restore_area32(unsigned char *pixels, SDL_Rect *area, unsigned char *target = NULL, SDL_Rect *target_area = NULL, bool free_src = true);
+   void restore_area8(unsigned char *pixels, SDL_Rect *area, unsigned char *target = NULL, SDL_Rect *target_area = NULL, bool free_src = true);
 
 void set_screen_mode();
 bool try_scaler(int w, int h, uint32 flags, int hwdepth);
@@ -193,8 +230,14 @@ bool try_scaler(int w, int h, uint32 flags, int hwdepth);
 
 private:
     int get_screen_bpp();
+    void init_blit_kernels();
+    void set_sdl_palette(SDL_Surface *dest, uint16 first = 0, uint16 count = 256);
+    void expand_area(sint32 x, sint32 y, uint16 w, uint16 h);
+    void expand_update_rects();
 
 #if SDL_VERSION_ATLEAST(2, 0, 0)
+    uint16 merge_update_rects();
+    void upload_texture(SDL_Rect *rects, uint16 count);
     bool init_sdl2_window(uint16 scale);
     bool create_sdl_surface_and_texture(sint32 w, sint32 h, Uint32 format);
 #else
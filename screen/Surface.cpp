@@ -57,6 +57,7 @@ RenderSurface::RenderSurface(uint32 width, uint32 height, uint32 bpp, uint8 *p)
 {
 	// Set default formats for the buffer
 	if (bpp == 32) set_format888();
+	else if (bpp == 8) set_format8();
 	else set_format565();
 }
 
@@ -68,6 +69,7 @@ RenderSurface::RenderSurface(uint32 width, uint32 height, uint32 bpp, sint32 gua
 {
 	// Set default formats for the buffer
 	if (bpp == 32) set_format888();
+	else if (bpp == 8) set_format8();
 	else set_format565();
 
 	buffer = new uint8[pitch * (height+2*gb)];
@@ -225,9 +227,21 @@ void RenderSurface::set_format888(int rsft, int gsft, int bsft)
 		format_type = 32;
 }
 
+//
+// Set an 8 bit palette index format. The colour shifting values are shared
+// by all surfaces, so they are left describing the display format.
+//
+void RenderSurface::set_format8()
+{
+	bits_per_pixel = 8;
+	bytes_per_pixel = 1;
+	format_type = 8;
+}
+
 void RenderSurface::draw_line (int sx, int sy, int ex, int ey, unsigned char col)
 {
 	if (bytes_per_pixel == 4) draw_line32 (sx, sy,ex,ey,col);
+	else if (bytes_per_pixel == 1) draw_line8 (sx, sy,ex,ey,col);
 	else draw_line16 (sx, sy,ex,ey,col);
 }
 
@@ -475,6 +489,125 @@ void RenderSurface::draw_line32 (int sx, int sy, int ex, int ey, unsigned char c
 
 }
 
+void RenderSurface::draw_line8 (int sx, int sy, int ex, int ey, unsigned char col)
+{
+#ifdef WANT_OPENGL
+	if (opengl) {
+		opengl->draw_line(sx, sy+1, 0, ex, ey+1, 0, col);
+		return;
+	}
+#endif
+
+	int xinc = 1;
+	int yinc = 1;
+
+	if (sx == ex) {
+		sx --;
+		if (sy > ey) {
+			yinc = -1;
+			sy--;
+		}
+	}
+	else {
+		if (sx > ex) {
+			sx--;
+			xinc = -1;
+		}
+		else {
+			ex--;
+		}
+
+		if (sy > ey) {
+			yinc = -1;
+			sy--;
+			ey--;
+		}
+	}
+
+	uint8 * pixptr = pixels + pitch*sy + sx;
+	uint8 * pixend = pixels + pitch*ey + ex;
+	int pitch = this->pitch*yinc;
+
+	int cury = sy;
+	int curx = sx;
+	int width = w;
+	int height = h;
+	bool no_clip = true;
+
+	if (sx >= width && ex >= width) return;
+	if (sy >= height && ey >= height) return;
+	if (sx < 0 && ex < 0) return;
+	if (sy < 0 && ey < 0) return;
+
+	if (sy < 0 || sy >= height || sx < 0 || sx >= width) no_clip = false;
+	if (ey < 0 || ey >= height || ex < 0 || ex >= width) no_clip = false;
+
+	// vertical
+	if (sx == ex) {
+		//std::cout << "Vertical" << std::endl;
+		// start is below end
+		while (pixptr != pixend) {
+			if (no_clip || (cury >= 0 && cury < height)) *pixptr = col;
+			pixptr+=pitch;
+			cury+=yinc;
+		}
+	}
+	// Horizontal
+	else if (sy == ey) {
+		//std::cout << "Horizontal" << std::endl;
+		while (pixptr != pixend) {
+			if (no_clip || (curx >= 0 && curx < width)) *pixptr = col;
+			pixptr+=xinc;
+			curx+=xinc;
+		}
+	}
+	// Diagonal xdiff >= ydiff
+	else if (std::labs(sx-ex) >= std::labs(sy-ey)) {
+		//std::cout << "Diagonal 1" << std::endl;
+		uint32 fraction = std::labs((LINE_FRACTION * (sy-ey)) / (sx-ex));
+		uint32 ycounter = 0;
+
+		for ( ; ; ) {
+			if ((no_clip || (cury >= 0 && cury < height && curx >= 0 && curx < width)))
+				*pixptr = col;
+			pixptr+=xinc;
+			if (curx == ex) break;
+			curx  +=xinc;
+			ycounter += fraction;
+
+			// Need to work out if we need to change line
+			if (ycounter > LINE_FRACTION) {
+				ycounter -= LINE_FRACTION;
+				pixptr+=pitch;
+				cury  +=yinc;
+			}
+		}
+	}
+	// Diagonal ydiff > xdiff
+	else {
+		//std::cout << "Diagonal 2" << std::endl;
+		uint32 fraction = std::labs((LINE_FRACTION * (sx-ex)) / (sy-ey));
+		uint32 xcounter = 0;
+
+		for ( ; ; ) {
+			if ((no_clip || (cury >= 0 && cury < height && curx >= 0 && curx < width)))
+				*pixptr = col;
+			pixptr+=pitch;
+			if (cury == ey) break;
+			cury  +=yinc;
+			xcounter += fraction;
+
+			// Need to work out if we need to change line
+			if (xcounter > LINE_FRACTION) {
+				xcounter -= LINE_FRACTION;
+				pixptr+=xinc;
+				curx+=xinc;
+			}
+		}
+	}
+
+}
+
 //
 //
 //
@@ -529,7 +662,12 @@ RenderSurface *CreateRenderSurface(OpenGL *ogl)
 SDL_Surface *RenderSurface::get_sdl_surface()
 {
  if(sdl_surface == NULL)
-   sdl_surface = SDL_CreateRGBSurfaceFrom(pixels, w, h, bits_per_pixel, pitch, Rmask, Gmask, Bmask, 0);
+  {
+   if(bits_per_pixel == 8) // gets its own palette, see Screen::set_palette()
+     sdl_surface = SDL_CreateRGBSurfaceFrom(pixels, w, h, 8, pitch, 0, 0, 0, 0);
+   else
+     sdl_surface = SDL_CreateRGBSurfaceFrom(pixels, w, h, bits_per_pixel, pitch, Rmask, Gmask, Bmask, 0);
+  }
 
  return sdl_surface;
 }
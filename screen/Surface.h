@@ -34,14 +34,14 @@ public:
 	OpenGL	*opengl;				// OpenGL surface
 
 	// Pixel Format (also see 'Colour shifting values' later)
-	int		bytes_per_pixel;		// 2 or 4
-	int		bits_per_pixel;			// 16 or 32
-	int		format_type;			// 16, 555, 565, 32 or 888
+	int		bytes_per_pixel;		// 1, 2 or 4
+	int		bits_per_pixel;			// 8, 16 or 32
+	int		format_type;			// 8, 16, 555, 565, 32 or 888
 
 	uint8	*pixels;				// What we draw to
 	uint16	*zbuffer;				// Z Buffer
 
-	uint32	colour32[256];			// Palette as 16/32 bit colours
+	uint32	colour32[256];			// Palette as 16/32 bit colours (of the display format when 8 bit)
 
 	// Dimentions
 	uint32	w, h;					// Surface width and height
@@ -90,6 +90,9 @@ public:
 	// Set a custom 888 format
 	void set_format888(int rsft = 16, int gsft = 8, int bsft = 0);
 
+	// Set an 8 bit palette index format
+	void set_format8();
+
 	// Draw Lines
 	void draw_line (int sx, int sy, int ex, int ey, unsigned char col);
 	void draw_3d_line (int x, int y, int sx, int sy, int sz, int ex, int ey, int ez, unsigned char col);
@@ -137,6 +140,9 @@ private:
 	// Draw Lines
 	void draw_line32 (int sx, int sy, int ex, int ey, unsigned char col);
 
+	// Draw Lines
+	void draw_line8 (int sx, int sy, int ex, int ey, unsigned char col);
+
 };
 
 RenderSurface *CreateRenderSurface(uint32 width, uint32 height, uint32 bpp, uint8 *p);
@@ -138,6 +138,10 @@ static iAVLKey get_iAVLKey(const void *item)
 
 static NuvieIO *g_objlist_file = NULL;
 
+// Obj userdata by Obj pointer, so each object has one handle while scripts hold it.
+// The values are weak, a handle is dropped from here before its __gc runs.
+static int obj_handles_ref = LUA_NOREF;
+
 // used for garbage collection.
 //returns current object reference count. Or -1 on error.
 static sint32 nscript_inc_obj_ref_count(Obj *obj);
@@ -148,12 +152,16 @@ Obj *nscript_get_obj_from_args(lua_State *L, int lua_stack_offset);
 extern Actor *nscript_get_actor_from_args(lua_State *L, int lua_stack_offset=1);
 
 void nscript_new_obj_var(lua_State *L, Obj *obj);
+static bool nscript_push_obj_handle(lua_State *L, Obj *obj);
+static void nscript_set_obj_handle(lua_State *L, Obj *obj);
 
 inline bool nscript_obj_init_from_obj(lua_State *L, Obj *dst_obj);
 inline bool nscript_obj_init_from_args(lua_State *L, int nargs, Obj *s_obj);
 static int nscript_obj_newobj(lua_State *L);
 int nscript_obj_new(lua_State *L, Obj *obj);
 static int nscript_obj_gc(lua_State *L);
+void nscript_set_field_accessor(lua_State *L, const char *metamethod, lua_CFunction accessor, const char *names[], int num_names);
+int nscript_get_field_id(lua_State *L);
 static int nscript_obj_get(lua_State *L);
 static int nscript_obj_set(lua_State *L);
 static int nscript_obj_movetomap(lua_State *L);
@@ -178,12 +186,67 @@ static const struct luaL_Reg nscript_objlib_f[] =
 };
 static const struct luaL_Reg nscript_objlib_m[] =
 {
-   { "__index", nscript_obj_get },
-   { "__newindex", nscript_obj_set },
    { "__gc", nscript_obj_gc },
    { NULL, NULL }
 };
 
+//Obj variables - in the same order as obj_vars
+enum
+{
+   OBJ_VAR_FRAME_N,
+   OBJ_VAR_GETABLE,
+   OBJ_VAR_IN_CONTAINER,
+   OBJ_VAR_INVISIBLE,
+   OBJ_VAR_LOOK_STRING,
+   OBJ_VAR_LUATYPE,
+   OBJ_VAR_NAME,
+   OBJ_VAR_OBJ_N,
+   OBJ_VAR_OK_TO_TAKE,
+   OBJ_VAR_ON_MAP,
+   OBJ_VAR_PARENT,
+   OBJ_VAR_QTY,
+   OBJ_VAR_QUALITY,
+   OBJ_VAR_READIED,
+   OBJ_VAR_STACKABLE,
+   OBJ_VAR_STATUS,
+   OBJ_VAR_TEMPORARY,
+   OBJ_VAR_TILE_NUM,
+   OBJ_VAR_TILE_NUM_ORIGINAL,
+   OBJ_VAR_WEIGHT,
+   OBJ_VAR_X,
+   OBJ_VAR_XYZ,
+   OBJ_VAR_Y,
+   OBJ_VAR_Z
+};
+
+static const char *obj_vars[] =
+{
+   "frame_n",
+   "getable",
+   "in_container",
+   "invisible",
+   "look_string",
+   "luatype",
+   "name",
+   "obj_n",
+   "ok_to_take",
+   "on_map",
+   "parent",
+   "qty",
+   "quality",
+   "readied",
+   "stackable",
+   "status",
+   "temporary",
+   "tile_num",
+   "tile_num_original",
+   "weight",
+   "x",
+   "xyz",
+   "y",
+   "z"
+};
+
 static int nscript_u6link_gc(lua_State *L);
 
 static const struct luaL_Reg nscript_u6linklib_m[] =
@@ -352,6 +415,11 @@ int nscript_init_u6link_iter(lua_State *L, U6LList *list, bool is_recursive);
 
 static int nscript_find_obj(lua_State *L);
 static int nscript_find_obj_from_area(lua_State *L);
+static int nscript_map_get_objs_in_area(lua_State *L);
+static int nscript_map_get_actors_in_area(lua_State *L);
+static int nscript_map_get_objs_in_radius(lua_State *L);
+static int nscript_map_get_actors_in_radius(lua_State *L);
+static int nscript_map_get_objs_and_actors_in_area(lua_State *L);
 
 Script *Script::script = NULL;
 
@@ -503,8 +571,7 @@ uint8 ScriptThread::resume(int narg)
 
    if(ret == 0)
    {
-      lua_gc(L, LUA_GCCOLLECT, 0); //FIXME! How often should we collect the garbage?
-      state = NUVIE_SCRIPT_FINISHED;
+      state = NUVIE_SCRIPT_FINISHED; // garbage is collected by Script::update_gc()
    }
    else if(ret == LUA_YIELD)
    {
@@ -584,6 +651,17 @@ Script::Script(Configuration *cfg, GUI *gui, SoundManager *sm, nuvie_game_t type
    L = luaL_newstate();
    luaL_openlibs(L);
 
+   int gc_value;
+   config->value("config/general/lua_gc_budget", gc_value, 1);
+   gc_budget = clamp_min(gc_value, 1);
+   config->value("config/general/lua_gc_full_collect_kb", gc_value, 65536);
+   gc_full_collect_kb = clamp_min(gc_value, 1024);
+   gc_next_cycle_kb = 0;
+   gc_frames = gc_time = gc_max_time = gc_full_collects = 0;
+
+   lua_gc(L, LUA_GCSETPAUSE, SCRIPT_GC_PAUSE);
+   lua_gc(L, LUA_GCSETSTEPMUL, SCRIPT_GC_STEPMUL);
+
    luaL_newmetatable(L, "nuvie.U6Link");
    luaL_register(L, NULL, nscript_u6linklib_m);
 
@@ -594,6 +672,15 @@ Script::Script(Configuration *cfg, GUI *gui, SoundManager *sm, nuvie_game_t type
    //lua_pushvalue(L, -1); //duplicate metatable
    //lua_setfield(L, -2, "__index"); // add __index to metatable
    luaL_register(L, NULL, nscript_objlib_m);
+   nscript_set_field_accessor(L, "__index", nscript_obj_get, obj_vars, sizeof(obj_vars) / sizeof(obj_vars[0]));
+   nscript_set_field_accessor(L, "__newindex", nscript_obj_set, obj_vars, sizeof(obj_vars) / sizeof(obj_vars[0]));
+
+   lua_newtable(L); // obj handle cache
+   lua_newtable(L);
+   lua_pushstring(L, "v");
+   lua_setfield(L, -2, "__mode");
+   lua_setmetatable(L, -2);
+   obj_handles_ref = luaL_ref(L, LUA_REGISTRYINDEX);
 
    luaL_register(L, "Obj", nscript_objlib_f);
 
@@ -672,6 +759,21 @@ Script::Script(Configuration *cfg, GUI *gui, SoundManager *sm, nuvie_game_t type
    lua_pushcfunction(L, nscript_find_obj_from_area);
    lua_setglobal(L, "find_obj_from_area");
 
+   lua_pushcfunction(L, nscript_map_get_objs_in_area);
+   lua_setglobal(L, "map_get_objs_in_area");
+
+   lua_pushcfunction(L, nscript_map_get_actors_in_area);
+   lua_setglobal(L, "map_get_actors_in_area");
+
+   lua_pushcfunction(L, nscript_map_get_objs_in_radius);
+   lua_setglobal(L, "map_get_objs_in_radius");
+
+   lua_pushcfunction(L, nscript_map_get_actors_in_radius);
+   lua_setglobal(L, "map_get_actors_in_radius");
+
+   lua_pushcfunction(L, nscript_map_get_objs_and_actors_in_area);
+   lua_setglobal(L, "map_get_objs_and_actors_in_area");
+
    lua_pushcfunction(L, nscript_timer_set);
    lua_setglobal(L, "timer_set");
 
@@ -956,6 +1058,51 @@ Script::~Script()
       lua_close(L);
 }
 
+/* Run the incremental collector for up to gc_budget ms. Script threads
+ * finishing used to trigger a full collection of the whole heap each time.
+ * Steps are taken until a cycle completes, then wait until the heap has grown
+ * by SCRIPT_GC_PAUSE again. Lua's own collector still runs on allocation in
+ * between, so long scripts and cutscenes don't grow the heap unchecked.
+ */
+void Script::update_gc()
+{
+   uint32 start_time = SDL_GetTicks();
+   uint32 heap_kb = lua_gc(L, LUA_GCCOUNT, 0);
+
+   if(heap_kb >= gc_full_collect_kb)
+   {
+      lua_gc(L, LUA_GCCOLLECT, 0);
+      heap_kb = lua_gc(L, LUA_GCCOUNT, 0);
+      gc_next_cycle_kb = heap_kb * SCRIPT_GC_PAUSE / 100;
+      if(heap_kb * 2 > gc_full_collect_kb) // mostly live data, don't collect it again every frame
+         gc_full_collect_kb = heap_kb * 2;
+      gc_full_collects++;
+   }
+   else if(heap_kb >= gc_next_cycle_kb)
+   {
+      do
+      {
+         if(lua_gc(L, LUA_GCSTEP, 0) == 1) // finished a cycle
+         {
+            gc_next_cycle_kb = lua_gc(L, LUA_GCCOUNT, 0) * SCRIPT_GC_PAUSE / 100;
+            break;
+         }
+      } while(SDL_GetTicks() - start_time < gc_budget);
+   }
+
+   uint32 time = SDL_GetTicks() - start_time;
+   gc_time += time;
+   if(time > gc_max_time)
+      gc_max_time = time;
+
+   if(++gc_frames == 600)
+   {
+      DEBUG(0, LEVEL_DEBUGGING, "Lua GC: heap %d KB, %d ms in %d frames (peak %d ms), %d full collections\n",
+            lua_gc(L, LUA_GCCOUNT, 0), gc_time, gc_frames, gc_max_time, gc_full_collects);
+      gc_frames = gc_time = gc_max_time = gc_full_collects = 0;
+   }
+}
+
 bool Script::init()
 {
 	std::string dir, path;
@@ -1742,6 +1889,10 @@ Obj *nscript_get_obj_from_args(lua_State *L, int lua_stack_offset)
 void nscript_new_obj_var(lua_State *L, Obj *obj)
 {
 	Obj **p_obj;
+
+	if(nscript_push_obj_handle(L, obj))
+		return;
+
     p_obj = (Obj **)lua_newuserdata(L, sizeof(Obj *));
 
     luaL_getmetatable(L, "nuvie.Obj");
@@ -1750,6 +1901,39 @@ void nscript_new_obj_var(lua_State *L, Obj *obj)
     *p_obj = obj;
 
     nscript_inc_obj_ref_count(obj);
+    nscript_set_obj_handle(L, obj);
+}
+
+/* Push the existing userdata for obj. Returns false, pushing nothing, if
+ * scripts don't hold one.
+ */
+static bool nscript_push_obj_handle(lua_State *L, Obj *obj)
+{
+   if(obj == NULL)
+      return false;
+
+   lua_rawgeti(L, LUA_REGISTRYINDEX, obj_handles_ref);
+   lua_pushlightuserdata(L, obj);
+   lua_rawget(L, -2);
+   lua_remove(L, -2);
+
+   if(lua_isnil(L, -1))
+   {
+      lua_pop(L, 1);
+      return false;
+   }
+
+   return true;
+}
+
+// Cache the userdata on top of the stack as the handle for obj.
+static void nscript_set_obj_handle(lua_State *L, Obj *obj)
+{
+   lua_rawgeti(L, LUA_REGISTRYINDEX, obj_handles_ref);
+   lua_pushlightuserdata(L, obj);
+   lua_pushvalue(L, -3);
+   lua_rawset(L, -3);
+   lua_pop(L, 1);
 }
 
 /***
@@ -1776,6 +1960,9 @@ int nscript_obj_new(lua_State *L, Obj *obj)
 {
    Obj **p_obj;
 
+   if(nscript_push_obj_handle(L, obj))
+      return 1;
+
    p_obj = (Obj **)lua_newuserdata(L, sizeof(Obj *));
 
    luaL_getmetatable(L, "nuvie.Obj");
@@ -1803,6 +1990,7 @@ int nscript_obj_new(lua_State *L, Obj *obj)
    *p_obj = obj;
 
    nscript_inc_obj_ref_count(obj);
+   nscript_set_obj_handle(L, obj);
 
    return 1;
 }
@@ -1977,12 +2165,40 @@ static void nscript_update_obj_location_variables(Obj *obj, uint16 x, uint16 y,
   }
 }
 
+/* __index and __newindex get a table of field name -> index + 1 as their
+ * upvalue. Lua strings are interned, so finding the field is one hash lookup
+ * on the key rather than a run of strcmp() calls, and the accessor can switch
+ * on the index.
+ */
+void nscript_set_field_accessor(lua_State *L, const char *metamethod, lua_CFunction accessor, const char *names[], int num_names)
+{
+   lua_createtable(L, 0, num_names);
+   for(int i = 0; i < num_names; i++)
+   {
+      lua_pushinteger(L, i + 1);
+      lua_setfield(L, -2, names[i]);
+   }
+
+   lua_pushcclosure(L, accessor, 1);
+   lua_setfield(L, -2, metamethod);
+}
+
+// Index into the names of the key at stack index 2, or -1 when it isn't one.
+int nscript_get_field_id(lua_State *L)
+{
+   lua_pushvalue(L, 2);
+   lua_rawget(L, lua_upvalueindex(1));
+   int id = (int)lua_tointeger(L, -1) - 1;
+   lua_pop(L, 1);
+
+   return id;
+}
+
 static int nscript_obj_set(lua_State *L)
 {
    Obj **s_obj;
    Obj *obj;
    //Obj *ptr;
-   const char *key;
 
    s_obj = (Obj **)lua_touserdata(L, 1);
    if(s_obj == NULL)
@@ -1994,72 +2210,54 @@ static int nscript_obj_set(lua_State *L)
 
    // ptr = nscript_get_obj_ptr(s_obj);
 
-   key = lua_tostring(L, 2);
-
-   if(!strcmp(key, "x"))
+   switch(nscript_get_field_id(L))
    {
+   case OBJ_VAR_X :
       nscript_update_obj_location_variables(obj, (uint16)lua_tointeger(L, 3), obj->y, obj->z);
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "y"))
-   {
+   case OBJ_VAR_Y :
       nscript_update_obj_location_variables(obj, obj->x, (uint16)lua_tointeger(L, 3), obj->z);
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "z"))
-   {
+   case OBJ_VAR_Z :
       nscript_update_obj_location_variables(obj, obj->x, obj->y, (uint8)lua_tointeger(L, 3));
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "obj_n"))
-   {
+   case OBJ_VAR_OBJ_N :
       obj->obj_n = (uint16)lua_tointeger(L, 3);
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "frame_n"))
-   {
+   case OBJ_VAR_FRAME_N :
       obj->frame_n = (uint8)lua_tointeger(L, 3);
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "quality"))
-   {
+   case OBJ_VAR_QUALITY :
       obj->quality = (uint8)lua_tointeger(L, 3);
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "qty"))
-   {
+   case OBJ_VAR_QTY :
       obj->qty = (uint8)lua_tointeger(L, 3);
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "status"))
-   {
+   case OBJ_VAR_STATUS :
       obj->status = (uint8)lua_tointeger(L, 3);
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "invisible"))
-   {
+   case OBJ_VAR_INVISIBLE :
       obj->set_invisible((bool)lua_toboolean(L, 3));
-      return 0;
-   }
+      break;
 
-   if(!strcmp(key, "ok_to_take"))
-   {
+   case OBJ_VAR_OK_TO_TAKE :
 	   obj->set_ok_to_take((bool)lua_toboolean(L, 3));
-	   return 0;
-   }
+	   break;
 
-   if(!strcmp(key, "temporary"))
-   {
+   case OBJ_VAR_TEMPORARY :
 	   obj->set_temporary((bool)lua_toboolean(L, 3));
-	   return 0;
+	   break;
+
+   default :
+      break;
    }
 
    return 0;
@@ -2069,7 +2267,6 @@ static int nscript_obj_get(lua_State *L)
 {
    Obj **s_obj;
    Obj *obj;
-   const char *key;
 
    s_obj = (Obj **)lua_touserdata(L, 1);
    if(s_obj == NULL)
@@ -2081,49 +2278,33 @@ static int nscript_obj_get(lua_State *L)
 
    //ptr = nscript_get_obj_ptr(s_obj);
 
-   key = lua_tostring(L, 2);
-
-   if(!strcmp(key, "luatype"))
+   switch(nscript_get_field_id(L))
    {
+   case OBJ_VAR_LUATYPE :
       lua_pushstring(L, "obj"); return 1;
-   }
 
-   if(!strcmp(key, "x"))
-   {
+   case OBJ_VAR_X :
       lua_pushinteger(L, obj->x); return 1;
-   }
 
-   if(!strcmp(key, "y"))
-   {
+   case OBJ_VAR_Y :
       lua_pushinteger(L, obj->y); return 1;
-   }
 
-   if(!strcmp(key, "z"))
-   {
+   case OBJ_VAR_Z :
       lua_pushinteger(L, obj->z); return 1;
-   }
 
-   if(!strcmp(key, "obj_n"))
-   {
+   case OBJ_VAR_OBJ_N :
       lua_pushinteger(L, obj->obj_n); return 1;
-   }
 
-   if(!strcmp(key, "frame_n"))
-   {
+   case OBJ_VAR_FRAME_N :
       lua_pushinteger(L, obj->frame_n); return 1;
-   }
 
-   if(!strcmp(key, "quality"))
-   {
+   case OBJ_VAR_QUALITY :
       lua_pushinteger(L, obj->quality); return 1;
-   }
 
-   if(!strcmp(key, "qty"))
-   {
+   case OBJ_VAR_QTY :
       lua_pushinteger(L, obj->qty); return 1;
-   }
 
-   if(!strcmp(key, "name"))
+   case OBJ_VAR_NAME :
    {
       ObjManager *obj_manager = Game::get_game()->get_obj_manager();
       lua_pushstring(L, obj_manager->get_obj_name(obj->obj_n, obj->frame_n));
@@ -2149,39 +2330,31 @@ static int nscript_obj_get(lua_State *L)
 	   return 2;
    }
 */
-   if(!strcmp(key, "look_string"))
+   case OBJ_VAR_LOOK_STRING :
    {
       ObjManager *obj_manager = Game::get_game()->get_obj_manager();
       lua_pushstring(L, obj_manager->look_obj(obj, true)); return 1;
    }
-   
-   if(!strcmp(key, "on_map"))
-   {
+
+   case OBJ_VAR_ON_MAP :
       lua_pushboolean(L, (int)obj->is_on_map()); return 1;
-   }
 
-   if(!strcmp(key, "in_container"))
-   {
+   case OBJ_VAR_IN_CONTAINER :
       lua_pushboolean(L, (int)obj->is_in_container()); return 1;
-   }
 
-   if(!strcmp(key, "readied"))
-   {
+   case OBJ_VAR_READIED :
       lua_pushboolean(L, (int)obj->is_readied()); return 1;
-   }
 
-   if(!strcmp(key, "stackable"))
+   case OBJ_VAR_STACKABLE :
    {
       ObjManager *obj_manager = Game::get_game()->get_obj_manager();
       lua_pushboolean(L, (int)obj_manager->is_stackable(obj)); return 1;
    }
 
-   if(!strcmp(key, "status"))
-   {
+   case OBJ_VAR_STATUS :
       lua_pushnumber(L, obj->status); return 1;
-   }
 
-   if(!strcmp(key, "weight"))
+   case OBJ_VAR_WEIGHT :
    {
       ObjManager *obj_manager = Game::get_game()->get_obj_manager();
       float weight = obj_manager->get_obj_weight(obj,OBJ_WEIGHT_INCLUDE_CONTAINER_ITEMS,OBJ_WEIGHT_DONT_SCALE);
@@ -2190,14 +2363,14 @@ static int nscript_obj_get(lua_State *L)
       lua_pushnumber(L, (lua_Number)weight); return 1;
    }
 
-   if(!strcmp(key, "tile_num"))
+   case OBJ_VAR_TILE_NUM :
    {
       ObjManager *obj_manager = Game::get_game()->get_obj_manager();
       Tile *tile = obj_manager->get_obj_tile(obj->obj_n, obj->frame_n);
       lua_pushinteger(L, (int)tile->tile_num); return 1;
    }
 
-   if(!strcmp(key, "tile_num_original"))
+   case OBJ_VAR_TILE_NUM_ORIGINAL :
    {
       ObjManager *obj_manager = Game::get_game()->get_obj_manager();
       TileManager *tile_manager = Game::get_game()->get_tile_manager();
@@ -2205,19 +2378,16 @@ static int nscript_obj_get(lua_State *L)
       lua_pushinteger(L, (int)tile->tile_num); return 1;
    }
 
-
-   if(!strcmp(key, "getable"))
+   case OBJ_VAR_GETABLE :
    {
 	   ObjManager *obj_manager = Game::get_game()->get_obj_manager();
 	   lua_pushboolean(L, (int)obj_manager->can_get_obj(obj)); return 1;
    }
 
-   if(!strcmp(key, "ok_to_take"))
-   {
+   case OBJ_VAR_OK_TO_TAKE :
 	   lua_pushboolean(L, (int)obj->is_ok_to_take()); return 1;
-   }
 
-   if(!strcmp(key, "parent"))
+   case OBJ_VAR_PARENT :
    {
      Obj *parent_container = obj->get_container_obj();
      if(parent_container)
@@ -2233,10 +2403,10 @@ static int nscript_obj_get(lua_State *L)
          return 1;
        }
      }
+     break;
    }
 
-   if(!strcmp(key, "xyz"))
-   {
+   case OBJ_VAR_XYZ :
       lua_newtable(L);
       lua_pushstring(L, "x");
       lua_pushinteger(L, obj->x);
@@ -2251,11 +2421,12 @@ static int nscript_obj_get(lua_State *L)
       lua_settable(L, -3);
 
       return 1;
-   }
 
-   if(!strcmp(key, "invisible"))
-   {
+   case OBJ_VAR_INVISIBLE :
       lua_pushboolean(L, (int)obj->is_invisible()); return 1;
+
+   default :
+      break;
    }
 
    return 0;
@@ -4486,6 +4657,232 @@ static int nscript_find_obj_from_area(lua_State *L)
    return 1;
 }
 
+// Turn loc into the wrapped top left corner of the square within radius
+// tiles of it. The radius is limited to the map size, past that the square
+// is the whole map.
+void nscript_get_radius_area(MapCoord *loc, lua_Integer radius, uint16 *width, uint16 *height)
+{
+   uint16 r = (uint16)clamp(radius, 0, 1024);
+   loc->x = WRAPPED_COORD(loc->x - r, loc->z);
+   loc->y = WRAPPED_COORD(loc->y - r, loc->z);
+   *width = *height = r * 2 + 1;
+}
+
+// Read the area arguments of the map_get_*_in_area/radius functions: a
+// location then width and height, or a centre location then a radius. The
+// returned corner is wrapped, the index of the next argument is returned.
+static int nscript_get_area_from_args(lua_State *L, MapCoord *loc, uint16 *width, uint16 *height, bool radius)
+{
+   int stackOffset = 4;
+   if(nscript_get_location_from_args(L, &loc->x, &loc->y, &loc->z) == false)
+      return 0;
+   if(lua_istable(L, 1))
+   {
+      stackOffset = 2;
+   }
+
+   if(radius)
+   {
+      nscript_get_radius_area(loc, luaL_checkinteger(L, stackOffset++), width, height);
+   }
+   else
+   {
+      *width = (uint16)luaL_checkinteger(L, stackOffset++);
+      *height = (uint16)luaL_checkinteger(L, stackOffset++);
+   }
+
+   return stackOffset;
+}
+
+// Push an array of the objects on the map in the area, wrapping around the
+// edge of the map. The area is cut to the map size so no tile is seen twice.
+static void nscript_push_objs_in_area(lua_State *L, const MapCoord &loc, uint16 width, uint16 height, bool match_obj_n, uint16 obj_n, uint8 status_mask)
+{
+   ObjManager *obj_manager = Game::get_game()->get_obj_manager();
+   uint16 map_side = WRAPPED_COORD(0xffff, loc.z) + 1;
+   width = MIN(width, map_side);
+   height = MIN(height, map_side);
+
+   std::vector<Obj *> objs;
+   for(uint16 dy = 0; dy < height; dy++)
+   {
+      for(uint16 dx = 0; dx < width; dx++)
+      {
+         U6LList *obj_list = obj_manager->get_obj_list(WRAPPED_COORD(loc.x + dx, loc.z), WRAPPED_COORD(loc.y + dy, loc.z), loc.z);
+         if(obj_list == NULL)
+            continue;
+
+         for(U6Link *link = obj_list->start(); link != NULL; link = link->next)
+         {
+            Obj *obj = (Obj *)link->data;
+            if((!match_obj_n || obj->obj_n == obj_n) && (obj->status & status_mask) == status_mask)
+               objs.push_back(obj);
+         }
+      }
+   }
+
+   lua_createtable(L, objs.size(), 0);
+   for(uint32 i = 0; i < objs.size(); i++)
+   {
+      nscript_new_obj_var(L, objs[i]);
+      lua_rawseti(L, -2, i + 1);
+   }
+}
+
+// Push an array of the actors in the area, see ActorManager::get_actors_in_area().
+void nscript_push_actors_in_area(lua_State *L, const MapCoord &loc, uint16 width, uint16 height, bool match_align, uint8 align)
+{
+   ActorManager *actor_manager = Game::get_game()->get_actor_manager();
+   ActorList *actors = actor_manager->get_actors_in_area(loc.x, loc.y, width, height, loc.z);
+
+   lua_createtable(L, actors->size(), 0);
+   int i = 1;
+   for(ActorIterator a = actors->begin(); a != actors->end(); a++)
+   {
+      if(match_align && (*a)->get_alignment() != align)
+         continue;
+      nscript_new_actor_var(L, (*a)->get_actor_num());
+      lua_rawseti(L, -2, i++);
+   }
+   delete actors;
+}
+
+static int nscript_get_objs_in_area(lua_State *L, bool radius)
+{
+   MapCoord loc;
+   uint16 width, height;
+   int stackOffset = nscript_get_area_from_args(L, &loc, &width, &height, radius);
+   if(stackOffset == 0)
+      return 0;
+
+   bool match_obj_n = !lua_isnoneornil(L, stackOffset);
+   uint16 obj_n = (uint16)lua_tointeger(L, stackOffset++);
+   uint8 status_mask = (uint8)lua_tointeger(L, stackOffset);
+
+   nscript_push_objs_in_area(L, loc, width, height, match_obj_n, obj_n, status_mask);
+   return 1;
+}
+
+static int nscript_get_actors_in_area(lua_State *L, bool radius)
+{
+   MapCoord loc;
+   uint16 width, height;
+   int stackOffset = nscript_get_area_from_args(L, &loc, &width, &height, radius);
+   if(stackOffset == 0)
+      return 0;
+
+   bool match_align = !lua_isnoneornil(L, stackOffset);
+   uint8 align = (uint8)lua_tointeger(L, stackOffset);
+
+   nscript_push_actors_in_area(L, loc, width, height, match_align, align);
+   return 1;
+}
+
+/***
+Get all objects on the map within a given area in one call, as an array.
+Objects are listed row by row, in the order they are stacked on each tile.
+Objects inside containers aren't included. The area wraps around the edge
+of the map.
+@function map_get_objs_in_area
+@tparam MapCoord|x,y,z location top left corner of the area
+@int width width of area to search
+@int height height of area to search
+@int[opt] obj_n only return objects of this type
+@int[opt] status_mask only return objects with all of these status bits set
+@treturn table array of objects, empty if none were found
+@usage
+   local obj
+   for _,obj in ipairs(map_get_objs_in_area(x - 5, y - 5, z, 11, 11, 317)) do
+      map_remove_obj(obj)
+   end
+@within Object
+ */
+static int nscript_map_get_objs_in_area(lua_State *L)
+{
+   return nscript_get_objs_in_area(L, false);
+}
+
+/***
+Get all actors within a given area in one call, as an array in actor number order.
+Actors are found by their own location, so large actors are returned once.
+The area wraps around the edge of the map.
+@function map_get_actors_in_area
+@tparam MapCoord|x,y,z location top left corner of the area
+@int width width of area to search
+@int height height of area to search
+@int[opt] align only return actors with this alignment
+@treturn table array of actors, empty if none were found
+@usage
+   local actor
+   for _,actor in ipairs(map_get_actors_in_area(x - 5, y - 5, z, 11, 11)) do
+      actor.visible = true
+   end
+@within Actor
+ */
+static int nscript_map_get_actors_in_area(lua_State *L)
+{
+   return nscript_get_actors_in_area(L, false);
+}
+
+/***
+Get all objects on the map within radius tiles of a location, as an array.
+Distance is the larger of the x and y distance, as with the spell areas,
+so this is the same as map_get_objs_in_area() on the square around it.
+@function map_get_objs_in_radius
+@tparam MapCoord|x,y,z location centre of the area
+@int radius
+@int[opt] obj_n only return objects of this type
+@int[opt] status_mask only return objects with all of these status bits set
+@treturn table array of objects, empty if none were found
+@within Object
+ */
+static int nscript_map_get_objs_in_radius(lua_State *L)
+{
+   return nscript_get_objs_in_area(L, true);
+}
+
+/***
+Get all actors within radius tiles of a location, as an array in actor number order.
+Distance is the larger of the x and y distance, as with the spell areas.
+@function map_get_actors_in_radius
+@tparam MapCoord|x,y,z location centre of the area
+@int radius
+@int[opt] align only return actors with this alignment
+@treturn table array of actors, empty if none were found
+@usage
+   local actor
+   for _,actor in ipairs(map_get_actors_in_radius(caster, 5)) do
+      actor.visible = true
+   end
+@within Actor
+ */
+static int nscript_map_get_actors_in_radius(lua_State *L)
+{
+   return nscript_get_actors_in_area(L, true);
+}
+
+/***
+Get all objects and all actors within a given area in one call.
+@function map_get_objs_and_actors_in_area
+@tparam MapCoord|x,y,z location top left corner of the area
+@int width width of area to search
+@int height height of area to search
+@treturn table array of objects, as map_get_objs_in_area() returns them
+@treturn table array of actors, as map_get_actors_in_area() returns them
+@within Object
+ */
+static int nscript_map_get_objs_and_actors_in_area(lua_State *L)
+{
+   MapCoord loc;
+   uint16 width, height;
+   if(nscript_get_area_from_args(L, &loc, &width, &height, false) == 0)
+      return 0;
+
+   nscript_push_objs_in_area(L, loc, width, height, false, 0, 0);
+   nscript_push_actors_in_area(L, loc, width, height, false, 0);
+   return 2;
+}
+
 /***
 Set specific game timer counter (U6).
 These counters are decremented each turn and are used for things like torch duration, eclipse etc.
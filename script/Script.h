@@ -82,6 +82,9 @@ public:
   uint8 get_state() { return state; }
 };
 
+#define SCRIPT_GC_PAUSE   150 // % of the heap after a cycle to wait for before the next one
+#define SCRIPT_GC_STEPMUL 300 // collector speed relative to allocation, %
+
 #define SCRIPT_DISPLAY_HIT_MSG true
 class Script
 {
@@ -91,12 +94,19 @@ class Script
  SoundManager *soundManager;
  lua_State *L;
 
+ // garbage collection is spread over frames by update_gc()
+ uint32 gc_budget; // ms per frame
+ uint32 gc_full_collect_kb; // heap size that forces a full collection
+ uint32 gc_next_cycle_kb; // don't start a new cycle until the heap grows past this
+ uint32 gc_frames, gc_time, gc_max_time, gc_full_collects; // stats since the last report
+
  public:
 
  Script(Configuration *cfg, GUI *gui, SoundManager *sm, nuvie_game_t type);
  ~Script();
 
  bool init();
+ void update_gc(); // call once per frame
 
  /* Return instance of self */
  static Script *get_script()           { return(script); }
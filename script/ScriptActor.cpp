@@ -119,9 +119,17 @@ extern void nscript_new_obj_var(lua_State *L, Obj *obj);
 extern int nscript_obj_new(lua_State *L, Obj *obj);
 extern int nscript_u6llist_iter(lua_State *L);
 extern int nscript_init_u6link_iter(lua_State *L, U6LList *list, bool is_recursive);
+extern void nscript_set_field_accessor(lua_State *L, const char *metamethod, lua_CFunction accessor, const char *names[], int num_names);
+extern int nscript_get_field_id(lua_State *L);
+extern void nscript_get_radius_area(MapCoord *loc, lua_Integer radius, uint16 *width, uint16 *height);
+extern void nscript_push_actors_in_area(lua_State *L, const MapCoord &loc, uint16 width, uint16 height, bool match_align, uint8 align);
 
 bool nscript_new_actor_var(lua_State *L, uint16 actor_num);
 
+// Actor userdata by actor_num + 1. The userdata only holds the actor number,
+// so a handle stays valid when its temp actor slot is reused.
+static int actor_handles_ref = LUA_NOREF;
+
 static int nscript_actor_new(lua_State *L);
 static int nscript_actor_clone(lua_State *L);
 static int nscript_get_actor_from_num(lua_State *L);
@@ -200,15 +208,9 @@ static const struct luaL_Reg nscript_actorlib_f[] =
 
    { NULL, NULL }
 };
-static const struct luaL_Reg nscript_actorlib_m[] =
-{
-   { "__index", nscript_actor_get },
-   { "__newindex", nscript_actor_set },
-   { NULL, NULL }
-};
 
 
-//Actor variables - must be in alphabetical order
+//Actor variables - in the same order as actor_set_func
 static const char *actor_set_vars[] =
 {
    "align",
@@ -245,7 +247,7 @@ static const char *actor_set_vars[] =
    "z"
 };
 
-//Actor variables - must be in alphabetical order
+//Actor variables - in the same order as actor_get_func
 static const char *actor_get_vars[] =
 {
    "actor_num",
@@ -464,6 +466,9 @@ int (*actor_get_func[])(Actor *, lua_State *) =
 
 static int nscript_map_get_actor(lua_State *L);
 static int nscript_update_actor_schedules(lua_State *L);
+static int nscript_actor_next_to_move(lua_State *L);
+static int nscript_actors_in_range(lua_State *L);
+static int nscript_actors_in_range_iter(lua_State *L);
 
 static int nscript_actor_inv(lua_State *L);
 
@@ -471,16 +476,26 @@ void nscript_init_actor(lua_State *L)
 {
    luaL_newmetatable(L, "nuvie.Actor");
 
-   luaL_register(L, NULL, nscript_actorlib_m);
+   nscript_set_field_accessor(L, "__index", nscript_actor_get, actor_get_vars, sizeof(actor_get_vars) / sizeof(actor_get_vars[0]));
+   nscript_set_field_accessor(L, "__newindex", nscript_actor_set, actor_set_vars, sizeof(actor_set_vars) / sizeof(actor_set_vars[0]));
 
    luaL_register(L, "Actor", nscript_actorlib_f);
 
+   lua_createtable(L, ACTORMANAGER_MAX_ACTORS, 0); // actor handle cache, filled as handles are needed
+   actor_handles_ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
    lua_pushcfunction(L, nscript_map_get_actor);
    lua_setglobal(L, "map_get_actor");
 
    lua_pushcfunction(L, nscript_update_actor_schedules);
    lua_setglobal(L, "update_actor_schedules");
 
+   lua_pushcfunction(L, nscript_actor_next_to_move);
+   lua_setglobal(L, "actor_next_to_move");
+
+   lua_pushcfunction(L, nscript_actors_in_range);
+   lua_setglobal(L, "actors_in_range");
+
    lua_pushcfunction(L, nscript_actor_inv);
    lua_setglobal(L, "actor_inventory");
 }
@@ -489,6 +504,18 @@ bool nscript_new_actor_var(lua_State *L, uint16 actor_num)
 {
    uint16 *userdata;
 
+   if(actor_num < ACTORMANAGER_MAX_ACTORS)
+   {
+      lua_rawgeti(L, LUA_REGISTRYINDEX, actor_handles_ref);
+      lua_rawgeti(L, -1, actor_num + 1);
+      if(!lua_isnil(L, -1))
+      {
+         lua_remove(L, -2);
+         return true;
+      }
+      lua_pop(L, 1);
+   }
+
    userdata = (uint16 *)lua_newuserdata(L, sizeof(uint16));
 
    luaL_getmetatable(L, "nuvie.Actor");
@@ -496,6 +523,13 @@ bool nscript_new_actor_var(lua_State *L, uint16 actor_num)
 
    *userdata = actor_num;
 
+   if(actor_num < ACTORMANAGER_MAX_ACTORS)
+   {
+      lua_pushvalue(L, -1);
+      lua_rawseti(L, -3, actor_num + 1);
+      lua_remove(L, -2);
+   }
+
    return true;
 }
 
@@ -669,15 +703,12 @@ static int nscript_get_player_actor(lua_State *L)
 static int nscript_actor_set(lua_State *L)
 {
    Actor *actor;
-   const char *key;
 
    actor = nscript_get_actor_from_args(L);
    if(actor == NULL)
       return 0;
 
-   key = lua_tostring(L, 2);
-
-   int idx = str_bsearch(actor_set_vars, sizeof(actor_set_vars) / sizeof(actor_set_vars[0]), (char *)key);
+   int idx = nscript_get_field_id(L);
    if(idx == -1)
       return 0;
 
@@ -881,15 +912,12 @@ static int nscript_actor_set_z(Actor *actor, lua_State *L)
 static int nscript_actor_get(lua_State *L)
 {
    Actor *actor;
-   const char *key;
 
    actor = nscript_get_actor_from_args(L);
    if(actor == NULL)
       return 0;
 
-   key = lua_tostring(L, 2);
-
-   int idx = str_bsearch(actor_get_vars, sizeof(actor_get_vars) / sizeof(actor_get_vars[0]), (char *)key);
+   int idx = nscript_get_field_id(L);
    if(idx == -1)
       return 0;
 
@@ -1829,6 +1857,94 @@ static int nscript_update_actor_schedules(lua_State *L)
 	return 0;
 }
 
+/***
+Pick the next actor to move this turn. Only actors on level z within 0x27
+tiles of x,y are picked; the one that has its dexterity in movement points
+first, else the one with the most movement points for its dexterity.
+Actors in party follow mode are skipped. Worktype 0x80 is replaced with
+the actor's schedule worktype on the way.
+@function actor_next_to_move
+@int x
+@int y
+@int z
+@treturn Actor|nil the actor, or nil if nobody has movement points left
+@treturn int the actor's movement points, 0 if nobody was picked
+@treturn table|nil array of scheduled actors (worktype 0x83 - 0x86) that are too far away, or nil
+@within Actor
+ */
+static int nscript_actor_next_to_move(lua_State *L)
+{
+   ActorManager *actor_manager = Game::get_game()->get_actor_manager();
+   ActorList offscreen_scheduled;
+   sint8 moves;
+
+   Actor *actor = actor_manager->get_next_actor_to_move((sint32)luaL_checkinteger(L, 1), (sint32)luaL_checkinteger(L, 2), (uint8)luaL_checkinteger(L, 3), &moves, &offscreen_scheduled);
+
+   if(actor)
+      nscript_new_actor_var(L, actor->get_actor_num());
+   else
+      lua_pushnil(L);
+
+   lua_pushinteger(L, moves);
+
+   if(offscreen_scheduled.empty())
+      return 2;
+
+   lua_createtable(L, offscreen_scheduled.size(), 0);
+   int i = 1;
+   for(ActorIterator a = offscreen_scheduled.begin(); a != offscreen_scheduled.end(); a++, i++)
+   {
+      nscript_new_actor_var(L, (*a)->get_actor_num());
+      lua_rawseti(L, -2, i);
+   }
+
+   return 3;
+}
+
+/***
+Iterate through the actors on level z within range tiles of x,y (a square),
+in actor number order. The square wraps around the edge of the map.
+@function actors_in_range
+@int x
+@int y
+@int z
+@int range
+@usage
+   for actor in actors_in_range(x, y, z, 5) do
+      if actor.alive then
+         actor_hit(actor, dmg)
+      end
+   end
+@within Actor
+ */
+static int nscript_actors_in_range(lua_State *L)
+{
+   MapCoord loc((uint16)luaL_checkinteger(L, 1), (uint16)luaL_checkinteger(L, 2), (uint8)luaL_checkinteger(L, 3));
+   uint16 width, height;
+
+   // the same square map_get_actors_in_radius() returns
+   nscript_get_radius_area(&loc, luaL_checkinteger(L, 4), &width, &height);
+   nscript_push_actors_in_area(L, loc, width, height, false, 0);
+
+   lua_pushinteger(L, 0);
+   lua_pushcclosure(L, &nscript_actors_in_range_iter, 2);
+   return 1;
+}
+
+static int nscript_actors_in_range_iter(lua_State *L)
+{
+   int i = (int)lua_tointeger(L, lua_upvalueindex(2)) + 1;
+
+   lua_rawgeti(L, lua_upvalueindex(1), i);
+   if(lua_isnil(L, -1))
+      return 0;
+
+   lua_pushinteger(L, i);
+   lua_replace(L, lua_upvalueindex(2));
+
+   return 1;
+}
+
 /***
 Iterate through objects in the actor's inventory.
 @function actor_inventory
@@ -59,7 +59,10 @@ bool SongMP3::Init(const char *filename) {
 
 bool SongMP3::Play(bool looping) {
     if (stream) {
-        stream->rewind();
+        // Opens the decoder and fills the first chunk
+        if (!stream->rewind()) {
+            return false;
+        }
 
         // Always use LoopingAudioStream - BGM should always loop
         Audio::LoopingAudioStream *looping_stream =
@@ -74,7 +77,7 @@ bool SongMP3::Play(bool looping) {
 bool SongMP3::Stop() {
     if (stream) {
         mixer->stopHandle(handle);
-        stream->rewind();
+        stream->close(); // stop decoding and free the buffers until the next Play()
     }
     return true;
 }
@@ -143,6 +143,21 @@ SoundManager::SoundManager ()
 
   opl = NULL;
   current_music_style = MUSIC_STYLE_NATIVE;
+
+  // ambient sound lookups for update_map_sfx()
+  obj_sfx_ids.resize(1024, NUVIE_SFX_NONE);
+  for(uint16 i = 0; i < SOUNDMANANGER_OBJSFX_TBL_SIZE; i++)
+    obj_sfx_ids[u6_obj_lookup_tbl[i].obj_n] = u6_obj_lookup_tbl[i].sfx_id;
+  tile_sfx_ids.resize(2048, NUVIE_SFX_NONE);
+  for(uint16 i = 0; i < SOUNDMANAGER_TILESFX_TBL_SIZE; i++)
+    tile_sfx_ids[u6_tile_lookup_tbl[i].tile_num] = u6_tile_lookup_tbl[i].sfx_id;
+
+  for(uint8 dy = 0; dy < SOUNDMANAGER_SFX_RANGE; dy++)
+    for(uint8 dx = 0; dx < SOUNDMANAGER_SFX_RANGE; dx++)
+      {
+        float dist = sqrtf ((float) dx * dx + (float) dy * dy);
+        sfx_distance_volume[dy][dx] = (SOUNDMANAGER_SFX_RANGE - dist) / SOUNDMANAGER_SFX_RANGE;
+      }
 }
 
 // function object to delete map<T, SoundCollection *> items
@@ -1005,16 +1020,6 @@ void SoundManager::musicStop()
     m_pCurrentSong = NULL;
 }
 
-std::list < SoundManagerSfx >::iterator SoundManagerSfx_find( std::list < SoundManagerSfx >::iterator first, std::list < SoundManagerSfx >::iterator last, const SfxIdType &value )
-  {
-    for ( ;first!=last; first++)
-    {
-    	if ( (*first).sfx_id==value )
-    		break;
-    }
-    return first;
-  }
-
 void SoundManager::update_map_sfx ()
 {
   unsigned int i;
@@ -1024,47 +1029,31 @@ void SoundManager::update_map_sfx ()
   if(sfx_enabled == false)
     return;
 
-  string next_group = "";
   Player *p = Game::get_game ()->get_player ();
   MapWindow *mw = Game::get_game ()->get_map_window ();
-
-  vector < SfxIdType >currentlyActiveSounds;
-  map < SfxIdType, float >volumeLevels;
+  std::map < SfxIdType, SoundManagerSfx >::iterator it;
 
   p->get_location (&x, &y, &l);
 
-  //m_ViewableTiles
+  for (it = m_ActiveSounds.begin (); it != m_ActiveSounds.end (); it++)
+    it->second.level = 0;
 
-  //get a list of all the sounds
+  //find the loudest source of each sound
   for (i = 0; i < mw->m_ViewableObjects.size(); i++)
     {
-      uint16 obj_n = mw->m_ViewableObjects[i]->obj_n;
-      SfxIdType sfx_id = RequestObjectSfxId(obj_n); //does this object have an associated sound?
-      if (sfx_id != NUVIE_SFX_NONE)
-        {
-          //calculate the volume
-          uint16 ox = mw->m_ViewableObjects[i]->x;
-          uint16 oy = mw->m_ViewableObjects[i]->y;
-          float dist = sqrtf ((float) (x - ox) * (x - ox) + (float) (y - oy) * (y - oy));
-          float vol = (8.0f - dist) / 8.0f;
-          if (vol <= 0)
-            continue;  // Too far away, skip this sound
-          //sp->SetVolume(vol);
-          //need the map to adjust volume according to number of active elements
-          std::map < SfxIdType, float >::iterator it;
-          it = volumeLevels.find (sfx_id);
-          if (it != volumeLevels.end ())
-            {
-              if (volumeLevels[sfx_id] < vol)
-                volumeLevels[sfx_id] = vol;
-            }
-          else
-            {
-              volumeLevels.insert (std::make_pair (sfx_id, vol));
-            }
-          //add to currently active list
-          currentlyActiveSounds.push_back (sfx_id);
-        }
+      Obj *obj = mw->m_ViewableObjects[i];
+      SfxIdType sfx_id = RequestObjectSfxId(obj->obj_n); //does this object have an associated sound?
+      if (sfx_id == NUVIE_SFX_NONE)
+        continue;
+
+      uint16 dx = abs (x - obj->x);
+      uint16 dy = abs (y - obj->y);
+      if (dx >= SOUNDMANAGER_SFX_RANGE || dy >= SOUNDMANAGER_SFX_RANGE || sfx_distance_volume[dy][dx] <= 0)
+        continue;  // Too far away, skip this sound
+
+      SoundManagerSfx &sfx = m_ActiveSounds[sfx_id]; // new sounds start out stopped
+      if (sfx.level < sfx_distance_volume[dy][dx])
+        sfx.level = sfx_distance_volume[dy][dx];
     }
   // Tile-based ambient SFX
   const std::vector<TileInfo> &viewable_tiles = mw->get_viewable_map_tiles();
@@ -1078,37 +1067,29 @@ void SoundManager::update_map_sfx ()
       if (sfx_id == NUVIE_SFX_NONE)
         continue;
 
-      sint16 tx = mw->get_cur_x() + (sint16)ti.x;
-      sint16 ty = mw->get_cur_y() + (sint16)ti.y;
-      float dist = sqrtf ((float) (x - tx) * (x - tx) + (float) (y - ty) * (y - ty));
-      float vol = (8.0f - dist) / 8.0f;
-      if (vol <= 0)
+      uint16 dx = abs (x - (mw->get_cur_x() + (sint16)ti.x));
+      uint16 dy = abs (y - (mw->get_cur_y() + (sint16)ti.y));
+      if (dx >= SOUNDMANAGER_SFX_RANGE || dy >= SOUNDMANAGER_SFX_RANGE || sfx_distance_volume[dy][dx] <= 0)
         continue;
 
-      std::map < SfxIdType, float >::iterator it;
-      it = volumeLevels.find (sfx_id);
-      if (it != volumeLevels.end ())
+      SoundManagerSfx &sfx = m_ActiveSounds[sfx_id];
+      if (sfx.level < sfx_distance_volume[dy][dx])
+        sfx.level = sfx_distance_volume[dy][dx];
+    }
+  //start new sounds, stop sounds that are gone and set the volume of those that got nearer or further
+  it = m_ActiveSounds.begin ();
+  while (it != m_ActiveSounds.end ())
+    {
+      SoundManagerSfx &sfx = it->second;
+      if (sfx.level <= 0)
         {
-          if (volumeLevels[sfx_id] < vol)
-            volumeLevels[sfx_id] = vol;
+          if (sfx.playing)
+            mixer->getMixer()->stopHandle(sfx.handle);
+          m_ActiveSounds.erase (it++);
+          continue;
         }
-      else
+      if (!sfx.playing)
         {
-          volumeLevels.insert (std::make_pair (sfx_id, vol));
-        }
-      currentlyActiveSounds.push_back (sfx_id);
-    }
-  //is this sound new? - activate it.
-  for (i = 0; i < currentlyActiveSounds.size(); i++)
-    {
-      std::list < SoundManagerSfx >::iterator it;
-      it = SoundManagerSfx_find(m_ActiveSounds.begin (), m_ActiveSounds.end (), currentlyActiveSounds[i]);        //is the sound already active?
-      if (it == m_ActiveSounds.end ())
-        {                       //this is a new sound, add it to the active list
-          //currentlyActiveSounds[i]->Play (true);
-          //currentlyActiveSounds[i]->SetVolume (0);
-          SoundManagerSfx sfx;
-          sfx.sfx_id = currentlyActiveSounds[i];
           SfxManager *first_mgr = m_SfxManager;
           SfxManager *second_mgr = NULL;
           if(custom_sfx_enabled && m_FallbackSfxManager)
@@ -1116,35 +1097,25 @@ void SoundManager::update_map_sfx ()
         	  first_mgr = m_FallbackSfxManager;
         	  second_mgr = m_SfxManager;
           }
+          sfx.sfx_id = it->first;
+          sfx.volume = 0;
           if(first_mgr->playSfxLooping(sfx.sfx_id, &sfx.handle, 0))
-          {
-        	  m_ActiveSounds.push_back(sfx);
-          }
+        	  sfx.playing = true;
           else if(second_mgr && second_mgr->playSfxLooping(sfx.sfx_id, &sfx.handle, 0))
-          {
-        	  m_ActiveSounds.push_back(sfx);
-          }
-        }
-    }
-  //is this sound old? - deactivate it
-  std::list < SoundManagerSfx >::iterator it;
-  it = m_ActiveSounds.begin ();
-  while (it != m_ActiveSounds.end ())
-    {
-      std::vector < SfxIdType >::iterator fit;
-      SoundManagerSfx sfx = (*it);
-      fit = std::find (currentlyActiveSounds.begin (), currentlyActiveSounds.end (), sfx.sfx_id);       //is the sound in the new active list?
-      if (fit == currentlyActiveSounds.end ())
-        {                       //its not, stop this sound from playing.
-          //sfx_id->Stop ();
-    	  mixer->getMixer()->stopHandle(sfx.handle);
-          it = m_ActiveSounds.erase (it);
+        	  sfx.playing = true;
+          else
+            {
+              m_ActiveSounds.erase (it++); // try again next update
+              continue;
+            }
         }
-      else
+      uint8 volume = (uint8)(sfx.level*(sfx_volume/255.0f)*255.0f);
+      if (volume != sfx.volume)
         {
-    	  mixer->getMixer()->setChannelVolume(sfx.handle, (uint8)(volumeLevels[sfx.sfx_id]*(sfx_volume/255.0f)*255.0f));
-          it++;
+          mixer->getMixer()->setChannelVolume(sfx.handle, volume);
+          sfx.volume = volume;
         }
+      it++;
     }
 }
 
@@ -1227,30 +1198,18 @@ Sound *SoundManager::RequestObjectSound (int id)
 
 uint16 SoundManager::RequestObjectSfxId(uint16 obj_n)
 {
-	uint16 i = 0;
-	for(i=0;i<SOUNDMANANGER_OBJSFX_TBL_SIZE;i++)
-	{
-		if(u6_obj_lookup_tbl[i].obj_n == obj_n)
-		{
-			return u6_obj_lookup_tbl[i].sfx_id;
-		}
-	}
+	if(obj_n >= obj_sfx_ids.size())
+		return NUVIE_SFX_NONE;
 
-	return NUVIE_SFX_NONE;
+	return obj_sfx_ids[obj_n];
 }
 
 uint16 SoundManager::RequestTileSfxId(uint16 tile_num)
 {
-	uint16 i = 0;
-	for(i=0;i<SOUNDMANAGER_TILESFX_TBL_SIZE;i++)
-	{
-		if(u6_tile_lookup_tbl[i].tile_num == tile_num)
-		{
-			return u6_tile_lookup_tbl[i].sfx_id;
-		}
-	}
+	if(tile_num >= tile_sfx_ids.size())
+		return NUVIE_SFX_NONE;
 
-	return NUVIE_SFX_NONE;
+	return tile_sfx_ids[tile_num];
 }
 
 Sound *SoundManager::RequestSong (string group)
@@ -1429,11 +1388,12 @@ void SoundManager::set_custom_sfx_enabled(bool val)
 	// Stop all active ambient sounds so they restart with the new manager
 	if(mixer)
 	{
-		std::list<SoundManagerSfx>::iterator it = m_ActiveSounds.begin();
-		while(it != m_ActiveSounds.end())
+		std::map<SfxIdType,SoundManagerSfx>::iterator it;
+		for(it = m_ActiveSounds.begin(); it != m_ActiveSounds.end(); it++)
 		{
-			mixer->getMixer()->stopHandle((*it).handle);
-			it = m_ActiveSounds.erase(it);
+			if(it->second.playing)
+				mixer->getMixer()->stopHandle(it->second.handle);
 		}
+		m_ActiveSounds.clear();
 	}
 }
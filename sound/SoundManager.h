@@ -58,8 +58,13 @@ class CEmuopl;
 typedef struct {
 	SfxIdType sfx_id;
 	Audio::SoundHandle handle;
+	bool playing;
+	uint8 volume; // channel volume last set
+	float level; // loudest source of this sound in the last update_map_sfx()
 } SoundManagerSfx;
 
+#define SOUNDMANAGER_SFX_RANGE 8 // ambient sounds fade out over this many tiles
+
 class SoundManager {
 public:
 	SoundManager();
@@ -141,7 +146,10 @@ private:
 	//state info:
 	string m_CurrentGroup;
 	Sound *m_pCurrentSong;
-	list<SoundManagerSfx> m_ActiveSounds;
+	map<SfxIdType,SoundManagerSfx> m_ActiveSounds; // ambient sounds by sfx id
+	vector<SfxIdType> obj_sfx_ids; // by obj_n
+	vector<SfxIdType> tile_sfx_ids; // by tile_num
+	float sfx_distance_volume[SOUNDMANAGER_SFX_RANGE][SOUNDMANAGER_SFX_RANGE]; // by dy, dx
     bool audio_enabled;
     bool music_enabled;
     bool speech_enabled;
@@ -40,7 +40,6 @@ FMtownsDecoderStream::FMtownsDecoderStream(std::string filename, uint16 sample_n
 	 unsigned char *item_data;
 	 uint32 decomp_size;
 	 U6Lib_n sam_file;
-	 U6Lzw lzw;
 
 	 raw_audio_buf = NULL;
 	 buf_len = 0;
@@ -50,20 +49,20 @@ FMtownsDecoderStream::FMtownsDecoderStream(std::string filename, uint16 sample_n
 	 if(!sam_file.open(filename, 4))
 		 return;
 
-	 item_data = sam_file.get_item(sample_num, NULL);
-	 if(item_data == NULL)
-		 return;
-
 	 if(isCompressed)
 	 {
-		 raw_audio_buf = lzw.decompress_buffer(item_data, sam_file.get_item_size(sample_num), decomp_size);
-
-		 free(item_data);
+		 raw_audio_buf = sam_file.get_item_lzw(sample_num, decomp_size);
+		 if(raw_audio_buf == NULL)
+			 return;
 
 		 buf_len = decomp_size;
 	 }
 	 else
 	 {
+		 item_data = sam_file.get_item(sample_num, NULL);
+		 if(item_data == NULL)
+			 return;
+
 		 raw_audio_buf = item_data;
 		 buf_len = sam_file.get_item_size(sample_num);
 	 }
@@ -23,27 +23,43 @@
 // stb_vorbis - include implementation
 #include "stb_vorbis.c"
 
+static int mp3_decode_thread(void *data) {
+    ((MP3AudioStream *)data)->decodeLoop();
+    return 0;
+}
+
 MP3AudioStream::MP3AudioStream()
-    : _audioData(nullptr)
-    , _audioLength(0)
-    , _position(0)
+    : _type(DECODER_MP3)
+    , _decoder(nullptr)
+    , _wavDataStart(0)
+    , _wavDataLength(0)
+    , _wavDataPos(0)
+    , _ring(nullptr)
+    , _ringRead(0)
+    , _ringCount(0)
+    , _decodeDone(false)
+    , _decoding(false)
+    , _quit(false)
+    , _underruns(0)
+    , _mutex(nullptr)
+    , _cond(nullptr)
+    , _thread(nullptr)
     , _sampleRate(22050)
     , _channels(2)
-    , _endOfData(false)
+    , _endOfData(true)
     , _volume(255)
 {
 }
 
 MP3AudioStream::~MP3AudioStream() {
-    if (_audioData) {
-        free(_audioData);
-        _audioData = nullptr;
-    }
+    close();
 }
 
 bool MP3AudioStream::load(const std::string &filename) {
     DEBUG(0, LEVEL_INFORMATIONAL, "MP3AudioStream: Attempting to load: %s\n", filename.c_str());
 
+    close();
+
     // Check file extension
     std::string ext;
     size_t dot = filename.rfind('.');
@@ -53,147 +69,362 @@ bool MP3AudioStream::load(const std::string &filename) {
         std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
     }
 
-    bool result = false;
-    if (ext == ".mp3") {
-        result = loadMp3(filename);
-    } else if (ext == ".ogg") {
-        result = loadOgg(filename);
+    if (ext == ".ogg") {
+        _type = DECODER_OGG;
     } else if (ext == ".wav") {
-        result = loadWav(filename);
+        _type = DECODER_WAV;
     } else {
         // Try MP3 as default
-        result = loadMp3(filename);
+        _type = DECODER_MP3;
     }
+    _filename = filename;
 
-    if (!result) {
+    // Only the header is read here, decoding starts when the song is played
+    if (!openDecoder()) {
         DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load: %s\n", filename.c_str());
+        return false;
     }
-    return result;
-}
+    closeDecoder();
 
-bool MP3AudioStream::loadMp3(const std::string &filename) {
-    drmp3_config config;
-    drmp3_uint64 totalPCMFrameCount;
+    DEBUG(0, LEVEL_INFORMATIONAL, "MP3AudioStream: Loaded %s (%d Hz, %d ch)\n",
+          filename.c_str(), _sampleRate, _channels);
 
-    // Decode entire MP3 to memory
-    drmp3_int16 *pSampleData = drmp3_open_file_and_read_pcm_frames_s16(
-        filename.c_str(),
-        &config,
-        &totalPCMFrameCount,
-        NULL
-    );
+    return true;
+}
 
-    if (!pSampleData) {
-        DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load MP3: %s\n", filename.c_str());
-        return false;
+bool MP3AudioStream::openDecoder() {
+    if (_type == DECODER_MP3) {
+        drmp3 *mp3 = (drmp3 *)malloc(sizeof(drmp3));
+        if (!mp3 || !drmp3_init_file(mp3, _filename.c_str(), NULL)) {
+            DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load MP3: %s\n", _filename.c_str());
+            free(mp3);
+            return false;
+        }
+        _sampleRate = mp3->sampleRate;
+        _channels = mp3->channels;
+        _decoder = mp3;
+    } else if (_type == DECODER_OGG) {
+        int error;
+        stb_vorbis *ogg = stb_vorbis_open_filename(_filename.c_str(), &error, NULL);
+        if (!ogg) {
+            DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load OGG: %s\n", _filename.c_str());
+            return false;
+        }
+        stb_vorbis_info info = stb_vorbis_get_info(ogg);
+        _sampleRate = info.sample_rate;
+        _channels = info.channels;
+        _decoder = ogg;
+    } else {
+        SDL_RWops *wav = SDL_RWFromFile(_filename.c_str(), "rb");
+        if (!wav) {
+            DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load WAV: %s (%s)\n",
+                  _filename.c_str(), SDL_GetError());
+            return false;
+        }
+        _decoder = wav;
+
+        // Walk the RIFF chunks for the format and the start of the samples
+        bool have_format = false;
+        Uint32 id = SDL_ReadBE32(wav);
+        SDL_ReadLE32(wav);
+        if (id != 0x52494646 || SDL_ReadBE32(wav) != 0x57415645) { // "RIFF", "WAVE"
+            DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load WAV: %s\n", _filename.c_str());
+            closeDecoder();
+            return false;
+        }
+        for (;;) {
+            id = SDL_ReadBE32(wav);
+            Uint32 length = SDL_ReadLE32(wav);
+            Sint64 start = SDL_RWtell(wav);
+            if (start < 0 || SDL_RWsize(wav) < start) {
+                break;
+            }
+            if (id == 0x666d7420) { // "fmt "
+                Uint16 format = SDL_ReadLE16(wav);
+                _channels = SDL_ReadLE16(wav);
+                _sampleRate = SDL_ReadLE32(wav);
+                SDL_ReadLE32(wav);
+                SDL_ReadLE16(wav);
+                Uint16 bits = SDL_ReadLE16(wav);
+                if (format != 1 || bits != 16) {
+                    // Need to convert - for simplicity, just fail
+                    DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Unsupported WAV format\n");
+                    closeDecoder();
+                    return false;
+                }
+                have_format = true;
+            } else if (id == 0x64617461) { // "data"
+                if (!have_format) {
+                    break;
+                }
+                _wavDataStart = (uint32_t)start;
+                _wavDataLength = MIN(length, (uint32_t)(SDL_RWsize(wav) - start));
+                _wavDataPos = 0;
+                break;
+            }
+            if (SDL_RWseek(wav, start + length + (length & 1), RW_SEEK_SET) < 0) {
+                break;
+            }
+        }
+        if (_wavDataStart == 0) {
+            DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load WAV: %s\n", _filename.c_str());
+            closeDecoder();
+            return false;
+        }
     }
 
-    _sampleRate = config.sampleRate;
-    _channels = config.channels;
-    _audioLength = (uint32_t)(totalPCMFrameCount * _channels);
-    _audioData = (sint16 *)pSampleData;
-    _position = 0;
-    _endOfData = false;
-
-    DEBUG(0, LEVEL_INFORMATIONAL, "MP3AudioStream: Loaded %s (%d Hz, %d ch, %u samples)\n",
-          filename.c_str(), _sampleRate, _channels, _audioLength);
+    // The ring is filled in whole frames
+    if (_channels < 1 || _channels > 2) {
+        DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Unsupported channel count %d: %s\n", _channels, _filename.c_str());
+        closeDecoder();
+        return false;
+    }
 
-    return true;
+    return seekDecoderStart();
 }
 
-bool MP3AudioStream::loadOgg(const std::string &filename) {
-    int channels, sampleRate;
-    short *output;
+void MP3AudioStream::closeDecoder() {
+    if (!_decoder) {
+        return;
+    }
+    if (_type == DECODER_MP3) {
+        drmp3_uninit((drmp3 *)_decoder);
+        free(_decoder);
+    } else if (_type == DECODER_OGG) {
+        stb_vorbis_close((stb_vorbis *)_decoder);
+    } else {
+        SDL_RWclose((SDL_RWops *)_decoder);
+        _wavDataStart = 0;
+    }
+    _decoder = nullptr;
+}
 
-    int samples = stb_vorbis_decode_filename(filename.c_str(), &channels, &sampleRate, &output);
+bool MP3AudioStream::seekDecoderStart() {
+    if (_type == DECODER_MP3) {
+        return drmp3_seek_to_pcm_frame((drmp3 *)_decoder, 0);
+    } else if (_type == DECODER_OGG) {
+        return stb_vorbis_seek_start((stb_vorbis *)_decoder);
+    }
+    _wavDataPos = 0;
+    return SDL_RWseek((SDL_RWops *)_decoder, _wavDataStart, RW_SEEK_SET) >= 0;
+}
 
-    if (samples <= 0) {
-        DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load OGG: %s\n", filename.c_str());
+bool MP3AudioStream::open() {
+    if (_thread) {
+        return true;
+    }
+    if (_filename.empty() || !openDecoder()) {
         return false;
     }
 
-    _sampleRate = sampleRate;
-    _channels = channels;
-    _audioLength = samples * channels;
-    _audioData = (sint16 *)output;
-    _position = 0;
+    _ring = (sint16 *)malloc(MP3_STREAM_RING_SIZE * sizeof(sint16));
+    _mutex = SDL_CreateMutex();
+    _cond = SDL_CreateCond();
+    _ringRead = 0;
+    _ringCount = 0;
+    _decodeDone = false;
+    _decoding = false;
+    _quit = false;
+    _underruns = 0;
     _endOfData = false;
 
-    DEBUG(0, LEVEL_INFORMATIONAL, "MP3AudioStream: Loaded %s (%d Hz, %d ch, %u samples)\n",
-          filename.c_str(), _sampleRate, _channels, _audioLength);
+    if (_ring && _mutex && _cond) {
+        // The first chunk is decoded here so playback can start at once
+        decodeChunk();
+        _thread = SDL_CreateThread(mp3_decode_thread, "MP3 Decode", this);
+    }
+    if (!_thread) {
+        DEBUG(0, LEVEL_ERROR, "MP3AudioStream: Failed to start decoding %s\n", _filename.c_str());
+        close();
+        return false;
+    }
 
     return true;
 }
 
-bool MP3AudioStream::loadWav(const std::string &filename) {
-    // Use SDL_LoadWAV for WAV files
-    SDL_AudioSpec spec;
-    Uint8 *wavBuffer;
-    Uint32 wavLength;
-
-    if (!SDL_LoadWAV(filename.c_str(), &spec, &wavBuffer, &wavLength)) {
-        DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Failed to load WAV: %s (%s)\n",
-              filename.c_str(), SDL_GetError());
-        return false;
+void MP3AudioStream::close() {
+    if (_thread) {
+        SDL_LockMutex(_mutex);
+        _quit = true;
+        SDL_CondSignal(_cond);
+        SDL_UnlockMutex(_mutex);
+        SDL_WaitThread(_thread, NULL);
+        _thread = nullptr;
+
+        if (_underruns) {
+            DEBUG(0, LEVEL_DEBUGGING, "MP3AudioStream: %s ran dry %u times\n", _filename.c_str(), _underruns);
+        }
+    }
+    if (_cond) {
+        SDL_DestroyCond(_cond);
+        _cond = nullptr;
+    }
+    if (_mutex) {
+        SDL_DestroyMutex(_mutex);
+        _mutex = nullptr;
     }
+    free(_ring);
+    _ring = nullptr;
+    _ringCount = 0;
+    closeDecoder();
+    _endOfData = true;
+}
 
-    // Convert to 16-bit stereo if needed
-    _sampleRate = spec.freq;
-    _channels = spec.channels;
+// Return how much of one chunk fits after the write position and store that
+// position in write. Called with _mutex held.
+uint32_t MP3AudioStream::ringSpace(uint32_t *write) const {
+    *write = (_ringRead + _ringCount) & (MP3_STREAM_RING_SIZE - 1);
+    uint32_t space = MIN(MP3_STREAM_RING_SIZE - _ringCount, MP3_STREAM_RING_SIZE - *write);
 
-    if (spec.format == AUDIO_S16LSB || spec.format == AUDIO_S16MSB) {
-        _audioLength = wavLength / sizeof(sint16);
-        _audioData = (sint16 *)malloc(wavLength);
-        memcpy(_audioData, wavBuffer, wavLength);
+    space = MIN(space, (uint32_t)MP3_STREAM_CHUNK_SIZE);
+    return space - space % _channels;
+}
+
+// Decode up to space samples into dest and return how many were decoded.
+// Only the decoder is touched, so decodeLoop() calls this without _mutex.
+uint32_t MP3AudioStream::decodeSamples(sint16 *dest, uint32_t space) {
+    uint32_t decoded = 0;
+
+    if (_type == DECODER_MP3) {
+        decoded = (uint32_t)drmp3_read_pcm_frames_s16((drmp3 *)_decoder, space / _channels, dest) * _channels;
+    } else if (_type == DECODER_OGG) {
+        decoded = stb_vorbis_get_samples_short_interleaved((stb_vorbis *)_decoder, _channels, dest, space) * _channels;
     } else {
-        // Need to convert - for simplicity, just fail
-        DEBUG(0, LEVEL_WARNING, "MP3AudioStream: Unsupported WAV format\n");
-        SDL_FreeWAV(wavBuffer);
-        return false;
+        uint32_t bytes = MIN(space * sizeof(sint16), _wavDataLength - _wavDataPos);
+        bytes -= bytes % (_channels * sizeof(sint16));
+        if (bytes > 0) {
+            bytes = (uint32_t)SDL_RWread((SDL_RWops *)_decoder, dest, 1, bytes);
+            bytes -= bytes % (_channels * sizeof(sint16));
+        }
+        _wavDataPos += bytes;
+        decoded = bytes / sizeof(sint16);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        for (uint32_t i = 0; i < decoded; i++) {
+            dest[i] = SDL_SwapLE16(dest[i]);
+        }
+#endif
     }
 
-    SDL_FreeWAV(wavBuffer);
-    _position = 0;
-    _endOfData = false;
+    return decoded;
+}
 
-    DEBUG(0, LEVEL_INFORMATIONAL, "MP3AudioStream: Loaded %s (%d Hz, %d ch, %u samples)\n",
-          filename.c_str(), _sampleRate, _channels, _audioLength);
+// Make decoded samples after the write position readable. Called with _mutex held.
+void MP3AudioStream::commitChunk(uint32_t decoded) {
+    if (decoded == 0) {
+        _decodeDone = true;
+    }
+    _ringCount += decoded;
+}
 
-    return true;
+// Decode up to one chunk into the free space after the write position.
+// Called with _mutex held and the thread not _decoding.
+void MP3AudioStream::decodeChunk() {
+    uint32_t write;
+    uint32_t space = ringSpace(&write);
+
+    if (space == 0 || _decodeDone) {
+        return;
+    }
+    commitChunk(decodeSamples(_ring + write, space));
+}
+
+// The reader only touches samples before the write position and nobody else
+// uses the decoder while _decoding is set, so the chunk is decoded with
+// _mutex released and the lock is only held to claim space and publish it.
+void MP3AudioStream::decodeLoop() {
+    SDL_LockMutex(_mutex);
+    while (!_quit) {
+        if (_decodeDone || MP3_STREAM_RING_SIZE - _ringCount < MP3_STREAM_CHUNK_SIZE) {
+            SDL_CondWait(_cond, _mutex);
+            continue;
+        }
+        uint32_t write;
+        uint32_t space = ringSpace(&write);
+
+        _decoding = true;
+        SDL_UnlockMutex(_mutex);
+        uint32_t decoded = decodeSamples(_ring + write, space);
+        SDL_LockMutex(_mutex);
+        _decoding = false;
+
+        commitChunk(decoded);
+        SDL_CondBroadcast(_cond);
+    }
+    SDL_UnlockMutex(_mutex);
 }
 
 int MP3AudioStream::readBuffer(sint16 *buffer, const int numSamples) {
-    if (!_audioData || _endOfData) {
+    if (!_thread || _endOfData) {
         return 0;  // Return 0 to signal EOF for LoopingAudioStream
     }
 
-    int samplesRemaining = _audioLength - _position;
-    int samplesToCopy = std::min(numSamples, samplesRemaining);
+    int samplesCopied = 0;
+
+    SDL_LockMutex(_mutex);
+    while (samplesCopied < numSamples) {
+        if (_ringCount == 0) {
+            if (_decodeDone) {
+                break;
+            }
+            // The thread hasn't kept up. Wait for the chunk it is decoding,
+            // or decode here rather than leave a gap.
+            _underruns++;
+            if (_decoding) {
+                SDL_CondWait(_cond, _mutex);
+            } else {
+                decodeChunk();
+            }
+            continue;
+        }
+
+        int samplesToCopy = std::min(numSamples - samplesCopied,
+                                     (int)std::min(_ringCount, MP3_STREAM_RING_SIZE - _ringRead));
+        const sint16 *src = _ring + _ringRead;
 
-    if (samplesToCopy > 0) {
         // Apply volume
         if (_volume == 255) {
-            memcpy(buffer, _audioData + _position, samplesToCopy * sizeof(sint16));
+            memcpy(buffer + samplesCopied, src, samplesToCopy * sizeof(sint16));
         } else {
             for (int i = 0; i < samplesToCopy; i++) {
-                int sample = _audioData[_position + i];
+                int sample = src[i];
                 sample = (sample * _volume) / 255;
-                buffer[i] = (sint16)sample;
+                buffer[samplesCopied + i] = (sint16)sample;
             }
         }
-        _position += samplesToCopy;
+        samplesCopied += samplesToCopy;
+        _ringRead = (_ringRead + samplesToCopy) & (MP3_STREAM_RING_SIZE - 1);
+        _ringCount -= samplesToCopy;
     }
 
     // Mark end of data when we've read everything
-    if (_position >= _audioLength) {
+    if (_decodeDone && _ringCount == 0) {
         _endOfData = true;
     }
+    SDL_CondSignal(_cond);
+    SDL_UnlockMutex(_mutex);
 
-    return samplesToCopy;
+    return samplesCopied;
 }
 
 bool MP3AudioStream::rewind() {
-    _position = 0;
-    _endOfData = false;
-    return true;
+    if (!_thread) {
+        return open();
+    }
+
+    SDL_LockMutex(_mutex);
+    while (_decoding) {
+        SDL_CondWait(_cond, _mutex);
+    }
+    bool result = seekDecoderStart();
+    _ringRead = 0;
+    _ringCount = 0;
+    _decodeDone = !result;
+    _endOfData = !result;
+    if (result) {
+        decodeChunk();
+    }
+    SDL_CondSignal(_cond);
+    SDL_UnlockMutex(_mutex);
+
+    return result;
 }
@@ -27,15 +27,22 @@
 #include "SDL.h"
 #include "audiostream.h"
 
-// Forward declaration - we'll use SDL_RWops for file reading
-// and decode MP3/OGG ourselves using stb_vorbis or dr_mp3
+#define MP3_STREAM_RING_SIZE 0x8000  // samples buffered ahead, about 0.37s of 44.1kHz stereo
+#define MP3_STREAM_CHUNK_SIZE 0x1000 // samples decoded at a time
 
+/* Decodes an MP3, OGG or 16 bit PCM WAV file a chunk at a time. load() only
+ * reads the header. rewind() opens the decoder and starts a thread that keeps
+ * a small ring buffer filled; readBuffer() copies from it and decodes itself
+ * if the thread has fallen behind. close() frees everything again, so only
+ * the song that is playing holds any memory.
+ */
 class MP3AudioStream : public Audio::RewindableAudioStream {
 public:
     MP3AudioStream();
     ~MP3AudioStream();
 
     bool load(const std::string &filename);
+    void close();
 
     int readBuffer(sint16 *buffer, const int numSamples);
     bool isStereo() const { return _channels == 2; }
@@ -45,14 +52,39 @@ public:
 
     void setVolume(uint8_t volume) { _volume = volume; }
 
+    void decodeLoop();
+
 private:
-    bool loadWav(const std::string &filename);
-    bool loadOgg(const std::string &filename);
-    bool loadMp3(const std::string &filename);
+    enum DecoderType { DECODER_MP3, DECODER_OGG, DECODER_WAV };
+
+    bool open();
+    bool openDecoder();
+    void closeDecoder();
+    bool seekDecoderStart();
+    uint32_t ringSpace(uint32_t *write) const;
+    uint32_t decodeSamples(sint16 *dest, uint32_t space);
+    void commitChunk(uint32_t decoded);
+    void decodeChunk();
+
+    std::string _filename;
+    DecoderType _type;
+    void *_decoder;        // drmp3, stb_vorbis or SDL_RWops
+    uint32_t _wavDataStart;  // in bytes
+    uint32_t _wavDataLength;
+    uint32_t _wavDataPos;
+
+    sint16 *_ring;
+    uint32_t _ringRead;
+    uint32_t _ringCount;
+    bool _decodeDone;      // the decoder is at the end, the ring holds the rest
+    bool _decoding;        // the thread is filling the ring with _mutex released
+    bool _quit;
+    uint32_t _underruns;
+
+    SDL_mutex *_mutex;     // guards the decoder (unless _decoding) and the ring
+    SDL_cond *_cond;       // signals room in the ring, or a finished chunk
+    SDL_Thread *_thread;
 
-    sint16 *_audioData;
-    uint32_t _audioLength;  // in samples (not bytes)
-    uint32_t _position;
     int _sampleRate;
     int _channels;
     bool _endOfData;
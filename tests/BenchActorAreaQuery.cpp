@@ -0,0 +1,275 @@
+/*
+ *  BenchActorAreaQuery.cpp
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "nuvieDefs.h"
+#include "ActorLocationIndex.h"
+#include "lua.hpp"
+
+/* Checks ActorLocationIndex::find_in_area() against a plain scan, for areas
+ * that cross the map seam on the surface and underground, then times a
+ * script looking for actors around a point the way the reveal spell used to
+ * (map_get_actor() on each of 11x11 tiles) against one
+ * map_get_actors_in_area() call. Both script functions are cut down copies
+ * backed by the index, each handle is a small userdata like the real ones.
+ *
+ *   BenchActorAreaQuery [runs]
+ */
+
+#define BENCH_ACTORS 256
+#define BENCH_TOWN_SIZE 64 // actors are spread over a town this size
+
+static ActorLocationIndex location_index;
+static uint16 actor_x[BENCH_ACTORS], actor_y[BENCH_ACTORS];
+static uint8 actor_z[BENCH_ACTORS];
+
+static uint32 seed = 12345;
+
+static uint16 random_below(uint16 n)
+{
+ seed = seed * 1103515245 + 12345;
+ return (uint16)((seed >> 8) % n);
+}
+
+static void place_actor(uint8 id_n, uint16 x, uint16 y, uint8 z)
+{
+ actor_x[id_n] = WRAPPED_COORD(x, z);
+ actor_y[id_n] = WRAPPED_COORD(y, z);
+ actor_z[id_n] = z;
+ location_index.update(id_n, x, y, z);
+}
+
+static bool area_matches(uint16 x, uint16 y, uint16 w, uint16 h, uint8 z)
+{
+ int map_side = WRAPPED_COORD(0xffff, z) + 1;
+ bool found[ACTOR_LOCATION_MAX_ACTORS];
+
+ location_index.find_in_area(x, y, w, h, z, found);
+
+ for(uint16 i = 0; i < BENCH_ACTORS; i++)
+   {
+    // how far right of and below the corner the actor is, around the seam
+    int dx = ((actor_x[i] - x) % map_side + map_side) % map_side;
+    int dy = ((actor_y[i] - y) % map_side + map_side) % map_side;
+    bool inside = (actor_z[i] == z && dx < w && dy < h);
+
+    if(found[i] != inside)
+      {
+       printf("FAIL: actor %d at %d,%d,%d %s area %d,%d %dx%d on level %d\n", i, actor_x[i], actor_y[i], actor_z[i],
+              inside ? "missing from" : "wrongly in", x, y, w, h, z);
+       return false;
+      }
+   }
+
+ return true;
+}
+
+static bool test_seam()
+{
+ bool found[ACTOR_LOCATION_MAX_ACTORS];
+ uint16 i;
+
+ for(i = 0; i < BENCH_ACTORS; i++)
+   place_actor(i, 0, 0, 7); // out of the way
+
+ // 1024,5 used to share a key with 0,6
+ place_actor(0, 0, 6, 0);
+ place_actor(1, 1023, 5, 0);
+ place_actor(2, 1, 5, 0);
+ place_actor(3, 255, 10, 1);
+ place_actor(4, 0, 10, 1);
+ place_actor(5, 512, 0, 0);
+ place_actor(6, 512, 1023, 0);
+
+ location_index.find_in_area(1023, 5, 2, 1, 0, found);
+ if(found[0] || !found[1])
+   {
+    printf("FAIL: area across the surface seam\n");
+    return false;
+   }
+ if(location_index.find(1024, 5, 0) != ACTOR_LOCATION_NONE || location_index.find(1025, 5, 0) != 2
+    || location_index.find(256, 10, 1) != 4)
+   {
+    printf("FAIL: find() with an unwrapped coordinate\n");
+    return false;
+   }
+
+ for(int n = 0; n < 2000; n++)
+   {
+    uint8 z = random_below(2);
+    uint16 map_side = WRAPPED_COORD(0xffff, z) + 1;
+    uint16 x = map_side - 8 + random_below(16);
+    uint16 y = map_side - 8 + random_below(16);
+    // small areas are probed, large ones scanned, some wider than the map
+    uint16 w = 1 + random_below(n & 1 ? 16 : map_side + 40);
+    uint16 h = 1 + random_below(n & 1 ? 16 : 40);
+
+    i = 7 + random_below(BENCH_ACTORS - 7);
+    place_actor(i, x - 4 + random_below(w + 8), y - 4 + random_below(h + 8), z);
+
+    if(!area_matches(x, y, w, h, z) || !area_matches(x, 1020, w, 8, z)
+       || !area_matches(0, y, map_side, 8, z) || !area_matches(x, y, 0, h, z))
+      return false;
+   }
+
+ return true;
+}
+
+static int bench_map_get_actor(lua_State *L)
+{
+ uint8 z = (uint8)luaL_checkinteger(L, 3);
+ uint16 i = location_index.find(WRAPPED_COORD((uint16)luaL_checkinteger(L, 1), z),
+                                WRAPPED_COORD((uint16)luaL_checkinteger(L, 2), z), z);
+
+ if(i == ACTOR_LOCATION_NONE)
+   return 0;
+
+ *(uint16 *)lua_newuserdata(L, sizeof(uint16)) = i;
+ return 1;
+}
+
+static int bench_map_get_actors_in_area(lua_State *L)
+{
+ uint8 z = (uint8)luaL_checkinteger(L, 3);
+ bool found[ACTOR_LOCATION_MAX_ACTORS];
+ int n = 0;
+
+ location_index.find_in_area(WRAPPED_COORD((uint16)luaL_checkinteger(L, 1), z), WRAPPED_COORD((uint16)luaL_checkinteger(L, 2), z),
+                             (uint16)luaL_checkinteger(L, 4), (uint16)luaL_checkinteger(L, 5), z, found);
+
+ for(uint16 i = 0; i < ACTOR_LOCATION_MAX_ACTORS; i++)
+   if(found[i])
+     n++;
+
+ lua_createtable(L, n, 0);
+ n = 0;
+ for(uint16 i = 0; i < ACTOR_LOCATION_MAX_ACTORS; i++)
+   if(found[i])
+    {
+     *(uint16 *)lua_newuserdata(L, sizeof(uint16)) = i;
+     lua_rawseti(L, -2, ++n);
+    }
+
+ return 1;
+}
+
+static const char *bench_script =
+ "local per_tile, bulk, casts = ...\n"
+ "local count = 0\n"
+ "for n = 1, casts do\n"
+ "   local x, y, z = 100 + n % 64, 200 + (n * 7) % 64, 0\n"
+ "   if bulk then\n"
+ "      for _,actor in ipairs(map_get_actors_in_area(x - 5, y - 5, z, 11, 11)) do\n"
+ "         count = count + 1\n"
+ "      end\n"
+ "   else\n"
+ "      for i = x - 5, x + 5 do\n"
+ "         for j = y - 5, y + 5 do\n"
+ "            if map_get_actor(i, j, z) ~= nil then\n"
+ "               count = count + 1\n"
+ "            end\n"
+ "         end\n"
+ "      end\n"
+ "   end\n"
+ "end\n"
+ "return count\n";
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool run_script(lua_State *L, bool bulk, int casts, lua_Integer *count)
+{
+ if(luaL_loadstring(L, bench_script) != LUA_OK)
+   return false;
+ lua_pushboolean(L, !bulk);
+ lua_pushboolean(L, bulk);
+ lua_pushinteger(L, casts);
+ if(lua_pcall(L, 3, 1, 0) != LUA_OK)
+   {
+    printf("script error: %s\n", lua_tostring(L, -1));
+    return false;
+   }
+ *count = lua_tointeger(L, -1);
+ lua_pop(L, 1);
+ return true;
+}
+
+int main(int argc, char **argv)
+{
+ int runs = argc > 1 ? atoi(argv[1]) : 5;
+ int casts = 2000;
+ double best[2] = { 1e9, 1e9 };
+ lua_Integer counts[2] = { 0, 0 };
+
+ if(!test_seam())
+   return 1;
+
+ // a busy town: every actor within a few screens of each other on the surface
+ location_index.clear();
+ for(uint16 i = 0; i < BENCH_ACTORS; i++)
+   {
+    uint16 x, y;
+    do
+      {
+       x = 100 + random_below(BENCH_TOWN_SIZE);
+       y = 200 + random_below(BENCH_TOWN_SIZE);
+      }
+    while(location_index.find(x, y, 0) != ACTOR_LOCATION_NONE);
+    place_actor(i, x, y, 0);
+   }
+
+ lua_State *L = luaL_newstate();
+ luaL_openlibs(L);
+ lua_register(L, "map_get_actor", bench_map_get_actor);
+ lua_register(L, "map_get_actors_in_area", bench_map_get_actors_in_area);
+
+ for(int run = 0; run < runs; run++)
+   {
+    for(int bulk = 0; bulk < 2; bulk++)
+      {
+       std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+       if(!run_script(L, bulk != 0, casts, &counts[bulk]))
+         {
+          lua_close(L);
+          return 1;
+         }
+       best[bulk] = MIN(best[bulk], elapsed_ms(start));
+      }
+   }
+ lua_close(L);
+
+ printf("%d 11x11 searches among %d actors, best of %d runs\n", casts, BENCH_ACTORS, runs);
+ printf("map_get_actor per tile %.2f ms, map_get_actors_in_area %.2f ms (%.1fx)\n", best[0], best[1], best[0] / best[1]);
+
+ // actors were put on separate tiles, so both must see the same ones
+ if(counts[0] != counts[1])
+   {
+    printf("FAIL: per tile found %d actors, area query %d\n", (int)counts[0], (int)counts[1]);
+    return 1;
+   }
+
+ return 0;
+}
@@ -0,0 +1,256 @@
+/*
+ *  BenchNuvieIOFile.cpp
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "nuvieDefs.h"
+#include "NuvieIOFile.h"
+
+/* Times NuvieIOFileRead/Write against the stdio calls they made before they
+ * were buffered (one fgetc or fputc per byte), over the access pattern of a
+ * save game: 8 byte object records read a field at a time, a seek and a
+ * 256 byte block every 4K. Both sides must produce the same bytes.
+ *
+ *   BenchNuvieIOFile [file] [runs]
+ */
+
+#define BENCH_FILE_SIZE (1024 * 1024 + 12345)
+
+// NuvieIOFileRead and NuvieIOFileWrite as they were before buffering.
+class StdioFileRead : public NuvieIO
+{
+ FILE *fp;
+
+ public:
+
+ StdioFileRead() { fp = NULL; }
+ ~StdioFileRead() { close(); }
+
+ bool open(const char *filename)
+   {
+    fp = fopen(filename, "rb");
+    if(fp == NULL)
+      return false;
+    fseek(fp, 0, SEEK_END);
+    size = (uint32)ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    pos = 0;
+    return true;
+   }
+ void close() { if(fp) fclose(fp); fp = NULL; NuvieIO::close(); }
+
+ uint8 read1() { if(pos >= size) return 0; pos++; return fgetc(fp); }
+ uint16 read2()
+   {
+    if(pos > size - 2) return 0;
+    pos += 2;
+    unsigned char b0 = fgetc(fp), b1 = fgetc(fp);
+    return b0 + (b1 << 8);
+   }
+ uint32 read4()
+   {
+    if(pos > size - 4) return 0;
+    pos += 4;
+    unsigned char b0 = fgetc(fp), b1 = fgetc(fp), b2 = fgetc(fp), b3 = fgetc(fp);
+    return b0 + (b1 << 8) + (b2 << 16) + ((uint32)b3 << 24);
+   }
+ bool readToBuf(unsigned char *buf, uint32 buf_size)
+   {
+    if(pos + buf_size > size) return false;
+    fread(buf, 1, buf_size, fp);
+    pos += buf_size;
+    return true;
+   }
+ void seek(uint32 new_pos) { if(fp && new_pos <= size) { fseek(fp, new_pos, SEEK_SET); pos = new_pos; } }
+};
+
+class StdioFileWrite : public NuvieIO
+{
+ FILE *fp;
+
+ public:
+
+ StdioFileWrite() { fp = NULL; }
+ ~StdioFileWrite() { close(); }
+
+ bool open(const char *filename) { fp = fopen(filename, "wb"); size = pos = 0; return fp != NULL; }
+ void close() { if(fp) fclose(fp); fp = NULL; NuvieIO::close(); }
+
+ bool write1(uint8 src) { fputc(src, fp); if(++pos > size) size = pos; return true; }
+ bool write2(uint16 src) { write1(src & 0xff); return write1(src >> 8); }
+ bool write4(uint32 src) { write2(src & 0xffff); return write2(src >> 16); }
+ uint32 writeBuf(const unsigned char *src, uint32 src_size)
+   {
+    pos += src_size;
+    if(pos > size) size = pos;
+    return fwrite(src, 1, src_size, fp);
+   }
+ void seek(uint32 new_pos) { if(fp && new_pos <= size) { fseek(fp, new_pos, SEEK_SET); pos = new_pos; } }
+};
+
+static uint32 read_pattern(NuvieIO *io)
+{
+ unsigned char block[256];
+ uint32 sum = 0;
+ uint32 size = io->get_size();
+
+ io->seek(0);
+ while(io->position() + 8 + sizeof(block) <= size)
+   {
+    // an object record: status, x/y/z packed, obj_n/frame_n, qty, quality
+    sum = sum * 31 + io->read1();
+    sum = sum * 31 + io->read1();
+    sum = sum * 31 + io->read2();
+    sum = sum * 31 + io->read2();
+    sum = sum * 31 + io->read1();
+    sum = sum * 31 + io->read1();
+
+    if((io->position() & 0xfff) == 0)
+      {
+       io->seek(io->position() + 16);
+       io->readToBuf(block, sizeof(block));
+       for(uint16 i = 0; i < sizeof(block); i += 17)
+         sum = sum * 31 + block[i];
+       sum = sum * 31 + io->read4();
+      }
+   }
+
+ return sum;
+}
+
+static void write_pattern(NuvieIO *io)
+{
+ unsigned char block[256];
+ uint32 seed = 12345;
+
+ for(uint16 i = 0; i < sizeof(block); i++)
+   block[i] = (unsigned char)(i * 7);
+
+ while(io->position() + 8 + sizeof(block) <= BENCH_FILE_SIZE)
+   {
+    seed = seed * 1103515245 + 12345;
+    io->write1((uint8)(seed >> 8));
+    io->write1((uint8)(seed >> 16));
+    io->write2((uint16)(seed >> 4));
+    io->write2((uint16)(seed >> 12));
+    io->write1((uint8)seed);
+    io->write1((uint8)(seed >> 24));
+
+    if((io->position() & 0xfff) == 0)
+      {
+       io->writeBuf(block, 16);
+       io->writeBuf(block, sizeof(block));
+       io->write4(seed);
+      }
+   }
+ while(io->position() < BENCH_FILE_SIZE)
+   io->write1(0);
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool files_match(const char *a, const char *b)
+{
+ FILE *fa = fopen(a, "rb");
+ FILE *fb = fopen(b, "rb");
+ bool same = (fa && fb);
+
+ while(same)
+   {
+    int ca = fgetc(fa);
+    int cb = fgetc(fb);
+    if(ca != cb)
+      same = false;
+    if(ca == EOF)
+      break;
+   }
+
+ if(fa) fclose(fa);
+ if(fb) fclose(fb);
+ return same;
+}
+
+int main(int argc, char **argv)
+{
+ std::string filename = argc > 1 ? argv[1] : "bench_nuvieiofile.tmp";
+ std::string stdio_filename = filename + ".stdio";
+ int runs = argc > 2 ? atoi(argv[2]) : 5;
+ double best[4] = { 1e9, 1e9, 1e9, 1e9 };
+ uint32 sums[2] = { 0, 0 };
+
+ for(int run = 0; run < runs; run++)
+   {
+    std::chrono::steady_clock::time_point start;
+
+    StdioFileWrite stdio_write;
+    if(!stdio_write.open(stdio_filename.c_str()))
+      {
+       printf("can't write %s\n", stdio_filename.c_str());
+       return 1;
+      }
+    start = std::chrono::steady_clock::now();
+    write_pattern(&stdio_write);
+    stdio_write.close();
+    best[0] = MIN(best[0], elapsed_ms(start));
+
+    NuvieIOFileWrite buffered_write;
+    buffered_write.open(filename.c_str());
+    start = std::chrono::steady_clock::now();
+    write_pattern(&buffered_write);
+    buffered_write.close();
+    best[1] = MIN(best[1], elapsed_ms(start));
+
+    StdioFileRead stdio_read;
+    stdio_read.open(filename.c_str());
+    start = std::chrono::steady_clock::now();
+    sums[0] = read_pattern(&stdio_read);
+    best[2] = MIN(best[2], elapsed_ms(start));
+    stdio_read.close();
+
+    NuvieIOFileRead buffered_read;
+    buffered_read.open(filename.c_str());
+    start = std::chrono::steady_clock::now();
+    sums[1] = read_pattern(&buffered_read);
+    best[3] = MIN(best[3], elapsed_ms(start));
+    buffered_read.close();
+   }
+
+ bool same_file = files_match(filename.c_str(), stdio_filename.c_str());
+ remove(filename.c_str());
+ remove(stdio_filename.c_str());
+
+ printf("%d bytes, best of %d runs\n", BENCH_FILE_SIZE, runs);
+ printf("write: stdio %.2f ms, buffered %.2f ms (%.1fx)\n", best[0], best[1], best[0] / best[1]);
+ printf("read:  stdio %.2f ms, buffered %.2f ms (%.1fx)\n", best[2], best[3], best[2] / best[3]);
+
+ if(!same_file || sums[0] != sums[1])
+   {
+    printf("FAIL: buffered and stdio results differ\n");
+    return 1;
+   }
+
+ return 0;
+}
@@ -0,0 +1,449 @@
+/*
+ *  BenchScriptFieldAccess.cpp
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "nuvieDefs.h"
+#include "U6misc.h"
+#include "lua.hpp"
+
+/* Times a script reading Obj and Actor fields through the old __index
+ * functions (a chain of strcmp() calls for Obj, str_bsearch() over the
+ * sorted names for Actor) against the new ones, which find the field in an
+ * upvalue table of interned names like nscript_set_field_accessor() sets
+ * up. The accessors are cut down copies of the ones in Script.cpp and
+ * ScriptActor.cpp, reading from plain structs. Both must return the same
+ * values, and unknown fields nil.
+ *
+ *   BenchScriptFieldAccess [runs]
+ */
+
+#define BENCH_LOOPS 200000
+
+typedef struct
+{
+ uint16 x, y;
+ uint8 z;
+ uint16 obj_n;
+ uint8 frame_n, quality, qty, status;
+} BenchObj;
+
+//Obj variables - in the same order as obj_vars
+enum
+{
+ OBJ_VAR_FRAME_N,
+ OBJ_VAR_GETABLE,
+ OBJ_VAR_IN_CONTAINER,
+ OBJ_VAR_INVISIBLE,
+ OBJ_VAR_LOOK_STRING,
+ OBJ_VAR_LUATYPE,
+ OBJ_VAR_NAME,
+ OBJ_VAR_OBJ_N,
+ OBJ_VAR_OK_TO_TAKE,
+ OBJ_VAR_ON_MAP,
+ OBJ_VAR_PARENT,
+ OBJ_VAR_QTY,
+ OBJ_VAR_QUALITY,
+ OBJ_VAR_READIED,
+ OBJ_VAR_STACKABLE,
+ OBJ_VAR_STATUS,
+ OBJ_VAR_TEMPORARY,
+ OBJ_VAR_TILE_NUM,
+ OBJ_VAR_TILE_NUM_ORIGINAL,
+ OBJ_VAR_WEIGHT,
+ OBJ_VAR_X,
+ OBJ_VAR_XYZ,
+ OBJ_VAR_Y,
+ OBJ_VAR_Z
+};
+
+static const char *obj_vars[] =
+{
+ "frame_n",
+ "getable",
+ "in_container",
+ "invisible",
+ "look_string",
+ "luatype",
+ "name",
+ "obj_n",
+ "ok_to_take",
+ "on_map",
+ "parent",
+ "qty",
+ "quality",
+ "readied",
+ "stackable",
+ "status",
+ "temporary",
+ "tile_num",
+ "tile_num_original",
+ "weight",
+ "x",
+ "xyz",
+ "y",
+ "z"
+};
+
+//Actor variables - must be in alphabetical order
+static const char *actor_get_vars[] =
+{
+ "actor_num",
+ "align",
+ "alive",
+ "asleep",
+ "base_obj_n",
+ "charmed",
+ "cold",
+ "combat_mode",
+ "corpser_flag",
+ "cursed",
+ "dex",
+ "direction",
+ "exp",
+ "frame_n",
+ "frenzy",
+ "hit_flag",
+ "hp",
+ "hypoxia",
+ "in_party",
+ "in_vehicle",
+ "int",
+ "level",
+ "luatype",
+ "magic",
+ "max_hp",
+ "mpts",
+ "name",
+ "obj_flag_0",
+ "obj_n",
+ "old_align",
+ "old_frame_n",
+ "paralyzed",
+ "poisoned",
+ "protected",
+ "sched_loc",
+ "sched_wt",
+ "str",
+ "temp",
+ "tile_num",
+ "visible",
+ "wt",
+ "x",
+ "xyz",
+ "y",
+ "z"
+};
+
+#define BENCH_ACTOR_VARS (sizeof(actor_get_vars) / sizeof(actor_get_vars[0]))
+
+static BenchObj bench_obj;
+static sint32 bench_actor_values[256][BENCH_ACTOR_VARS];
+
+static BenchObj *bench_get_obj(lua_State *L)
+{
+ BenchObj **s_obj = (BenchObj **)lua_touserdata(L, 1);
+ if(s_obj == NULL)
+   return NULL;
+
+ return *s_obj;
+}
+
+// The fields a script loop typically reads, in the order the old
+// nscript_obj_get() tested them. The ones that need the game push nil.
+static int bench_obj_get_strcmp(lua_State *L)
+{
+ BenchObj *obj = bench_get_obj(L);
+ if(obj == NULL)
+   return 0;
+
+ const char *key = lua_tostring(L, 2);
+
+ if(!strcmp(key, "luatype"))
+   {
+    lua_pushstring(L, "obj"); return 1;
+   }
+ if(!strcmp(key, "x"))
+   {
+    lua_pushinteger(L, obj->x); return 1;
+   }
+ if(!strcmp(key, "y"))
+   {
+    lua_pushinteger(L, obj->y); return 1;
+   }
+ if(!strcmp(key, "z"))
+   {
+    lua_pushinteger(L, obj->z); return 1;
+   }
+ if(!strcmp(key, "obj_n"))
+   {
+    lua_pushinteger(L, obj->obj_n); return 1;
+   }
+ if(!strcmp(key, "frame_n"))
+   {
+    lua_pushinteger(L, obj->frame_n); return 1;
+   }
+ if(!strcmp(key, "quality"))
+   {
+    lua_pushinteger(L, obj->quality); return 1;
+   }
+ if(!strcmp(key, "qty"))
+   {
+    lua_pushinteger(L, obj->qty); return 1;
+   }
+ if(!strcmp(key, "name") || !strcmp(key, "look_string") || !strcmp(key, "on_map")
+    || !strcmp(key, "in_container") || !strcmp(key, "readied") || !strcmp(key, "stackable"))
+   return 0;
+ if(!strcmp(key, "status"))
+   {
+    lua_pushinteger(L, obj->status); return 1;
+   }
+
+ return 0;
+}
+
+// Copies of nscript_set_field_accessor() and nscript_get_field_id().
+static void bench_set_field_accessor(lua_State *L, const char *metamethod, lua_CFunction accessor, const char *names[], int num_names)
+{
+ lua_createtable(L, 0, num_names);
+ for(int i = 0; i < num_names; i++)
+   {
+    lua_pushinteger(L, i + 1);
+    lua_setfield(L, -2, names[i]);
+   }
+
+ lua_pushcclosure(L, accessor, 1);
+ lua_setfield(L, -2, metamethod);
+}
+
+static int bench_get_field_id(lua_State *L)
+{
+ lua_pushvalue(L, 2);
+ lua_rawget(L, lua_upvalueindex(1));
+ int id = (int)lua_tointeger(L, -1) - 1;
+ lua_pop(L, 1);
+
+ return id;
+}
+
+static int bench_obj_get_interned(lua_State *L)
+{
+ BenchObj *obj = bench_get_obj(L);
+ if(obj == NULL)
+   return 0;
+
+ switch(bench_get_field_id(L))
+   {
+    case OBJ_VAR_LUATYPE :
+      lua_pushstring(L, "obj"); return 1;
+    case OBJ_VAR_X :
+      lua_pushinteger(L, obj->x); return 1;
+    case OBJ_VAR_Y :
+      lua_pushinteger(L, obj->y); return 1;
+    case OBJ_VAR_Z :
+      lua_pushinteger(L, obj->z); return 1;
+    case OBJ_VAR_OBJ_N :
+      lua_pushinteger(L, obj->obj_n); return 1;
+    case OBJ_VAR_FRAME_N :
+      lua_pushinteger(L, obj->frame_n); return 1;
+    case OBJ_VAR_QUALITY :
+      lua_pushinteger(L, obj->quality); return 1;
+    case OBJ_VAR_QTY :
+      lua_pushinteger(L, obj->qty); return 1;
+    case OBJ_VAR_STATUS :
+      lua_pushinteger(L, obj->status); return 1;
+    default :
+      break;
+   }
+
+ return 0;
+}
+
+// actor_get_func[] holds one function per field, here they all read the
+// field's slot in bench_actor_values
+static int bench_actor_get_value(uint16 actor_num, int idx, lua_State *L)
+{
+ lua_pushinteger(L, bench_actor_values[actor_num][idx]);
+ return 1;
+}
+
+static int bench_actor_get_bsearch(lua_State *L)
+{
+ uint16 *actor_num = (uint16 *)lua_touserdata(L, 1);
+ if(actor_num == NULL)
+   return 0;
+
+ const char *key = lua_tostring(L, 2);
+
+ int idx = str_bsearch(actor_get_vars, BENCH_ACTOR_VARS, (char *)key);
+ if(idx == -1)
+   return 0;
+
+ return bench_actor_get_value(*actor_num, idx, L);
+}
+
+static int bench_actor_get_interned(lua_State *L)
+{
+ uint16 *actor_num = (uint16 *)lua_touserdata(L, 1);
+ if(actor_num == NULL)
+   return 0;
+
+ int idx = bench_get_field_id(L);
+ if(idx == -1)
+   return 0;
+
+ return bench_actor_get_value(*actor_num, idx, L);
+}
+
+static void bench_init_handles(lua_State *L, const char *obj_name, lua_CFunction obj_get, const char *actor_name, lua_CFunction actor_get, bool interned)
+{
+ luaL_newmetatable(L, obj_name);
+ if(interned)
+   bench_set_field_accessor(L, "__index", obj_get, obj_vars, sizeof(obj_vars) / sizeof(obj_vars[0]));
+ else
+   {
+    lua_pushcfunction(L, obj_get);
+    lua_setfield(L, -2, "__index");
+   }
+ lua_pop(L, 1);
+
+ luaL_newmetatable(L, actor_name);
+ if(interned)
+   bench_set_field_accessor(L, "__index", actor_get, actor_get_vars, BENCH_ACTOR_VARS);
+ else
+   {
+    lua_pushcfunction(L, actor_get);
+    lua_setfield(L, -2, "__index");
+   }
+ lua_pop(L, 1);
+}
+
+static void push_obj(lua_State *L, const char *metatable)
+{
+ *(BenchObj **)lua_newuserdata(L, sizeof(BenchObj *)) = &bench_obj;
+ luaL_getmetatable(L, metatable);
+ lua_setmetatable(L, -2);
+}
+
+static void push_actor(lua_State *L, const char *metatable, uint16 actor_num)
+{
+ *(uint16 *)lua_newuserdata(L, sizeof(uint16)) = actor_num;
+ luaL_getmetatable(L, metatable);
+ lua_setmetatable(L, -2);
+}
+
+// reads 7 Obj fields and 7 Actor fields per loop
+static const char *bench_script =
+ "local obj, actors, loops = ...\n"
+ "local obj_sum, actor_sum = 0, 0\n"
+ "for n = 1, loops do\n"
+ "   obj_sum = obj_sum + obj.x + obj.y + obj.z + obj.obj_n + obj.frame_n + obj.quality + obj.status\n"
+ "   local actor = actors[n % #actors + 1]\n"
+ "   actor_sum = actor_sum + actor.x + actor.y + actor.z + actor.obj_n + actor.hp + actor.wt + actor.align\n"
+ "end\n"
+ "if obj.no_such_field ~= nil or actors[1].no_such_field ~= nil then\n"
+ "   error(\"unknown field isn't nil\")\n"
+ "end\n"
+ "return obj_sum, actor_sum\n";
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+ return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool run_script(lua_State *L, bool interned, lua_Integer sums[2])
+{
+ const char *obj_metatable = interned ? "bench.ObjInterned" : "bench.ObjStrcmp";
+ const char *actor_metatable = interned ? "bench.ActorInterned" : "bench.ActorBsearch";
+
+ if(luaL_loadstring(L, bench_script) != LUA_OK)
+   return false;
+ push_obj(L, obj_metatable);
+ lua_createtable(L, 16, 0);
+ for(uint16 i = 0; i < 16; i++)
+   {
+    push_actor(L, actor_metatable, i * 16);
+    lua_rawseti(L, -2, i + 1);
+   }
+ lua_pushinteger(L, BENCH_LOOPS);
+ if(lua_pcall(L, 3, 2, 0) != LUA_OK)
+   {
+    printf("script error: %s\n", lua_tostring(L, -1));
+    return false;
+   }
+ sums[0] = lua_tointeger(L, -2);
+ sums[1] = lua_tointeger(L, -1);
+ lua_pop(L, 2);
+ return true;
+}
+
+int main(int argc, char **argv)
+{
+ int runs = argc > 1 ? atoi(argv[1]) : 5;
+ double best[2] = { 1e9, 1e9 };
+ lua_Integer sums[2][2] = { { 0, 0 }, { 0, 0 } };
+
+ bench_obj.x = 305;
+ bench_obj.y = 348;
+ bench_obj.z = 0;
+ bench_obj.obj_n = 98;
+ bench_obj.frame_n = 1;
+ bench_obj.quality = 3;
+ bench_obj.status = 0x21;
+ for(uint16 i = 0; i < 256; i++)
+   for(uint16 j = 0; j < BENCH_ACTOR_VARS; j++)
+     bench_actor_values[i][j] = i * 7 + j;
+
+ lua_State *L = luaL_newstate();
+ luaL_openlibs(L);
+ bench_init_handles(L, "bench.ObjStrcmp", bench_obj_get_strcmp, "bench.ActorBsearch", bench_actor_get_bsearch, false);
+ bench_init_handles(L, "bench.ObjInterned", bench_obj_get_interned, "bench.ActorInterned", bench_actor_get_interned, true);
+
+ for(int run = 0; run < runs; run++)
+   {
+    for(int interned = 0; interned < 2; interned++)
+      {
+       std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+       if(!run_script(L, interned != 0, sums[interned]))
+         {
+          lua_close(L);
+          return 1;
+         }
+       best[interned] = MIN(best[interned], elapsed_ms(start));
+      }
+   }
+ lua_close(L);
+
+ double reads = BENCH_LOOPS * 7.0 / 1000.0; // per ms, so this is millions per second
+ printf("%d loops reading 7 Obj and 7 Actor fields, best of %d runs\n", BENCH_LOOPS, runs);
+ printf("strcmp/str_bsearch %.2f ms (%.1fM field reads/s), interned names %.2f ms (%.1fM field reads/s) (%.2fx)\n",
+        best[0], reads * 2 / best[0], best[1], reads * 2 / best[1], best[0] / best[1]);
+
+ if(sums[0][0] != sums[1][0] || sums[0][1] != sums[1][1])
+   {
+    printf("FAIL: old accessors read %d/%d, new ones %d/%d\n", (int)sums[0][0], (int)sums[0][1], (int)sums[1][0], (int)sums[1][1]);
+    return 1;
+   }
+
+ return 0;
+}
@@ -0,0 +1,186 @@
+/*
+ *  TestBlitKernels.cpp
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "nuvieDefs.h"
+#include "BlitKernels.h"
+
+/* Runs every vector kernel set the CPU supports against the scalar one over
+ * random data and fails on the first byte that differs. Destinations are
+ * filled with random guard values, so writes outside the blocks (or skipped
+ * transparent pixels) that differ are caught too.
+ */
+
+#define TEST_MAX_W     200
+#define TEST_MAX_SCALE 5
+#define TEST_PAD       5
+#define TEST_BUF       ((TEST_MAX_W * TEST_MAX_SCALE + TEST_PAD) * TEST_MAX_SCALE + 8)
+
+typedef struct
+{
+ const char *name;
+ uint8 bits_per_pixel;
+ BlitPixelFormat format;
+} TestFormat;
+
+static const TestFormat test_formats[] =
+{
+ { "RGB565",   16, { 0xf800, 0x07e0, 0x001f, 11, 5, 0 } },
+ { "BGR565",   16, { 0x001f, 0x07e0, 0xf800, 0, 5, 11 } },
+ { "RGB555",   16, { 0x7c00, 0x03e0, 0x001f, 10, 5, 0 } },
+ { "ARGB8888", 32, { 0x00ff0000, 0x0000ff00, 0x000000ff, 16, 8, 0 } },
+ { "ABGR8888", 32, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0, 8, 16 } },
+ { "RGBA8888", 32, { 0xff000000, 0x00ff0000, 0x0000ff00, 24, 16, 8 } }
+};
+
+static uint32 test_seed = 1;
+
+static uint32 test_rand()
+{
+ test_seed = test_seed * 1103515245 + 12345;
+ return (test_seed >> 8) ^ (test_seed << 20);
+}
+
+template<class T> static bool compare(const char *what, const T *expect, const T *got, uint32 count)
+{
+ for(uint32 i = 0; i < count; i++)
+   {
+    if(expect[i] != got[i])
+      {
+       printf("FAIL %s: element %u is 0x%x, scalar gives 0x%x\n", what, i, (uint32)got[i], (uint32)expect[i]);
+       return false;
+      }
+   }
+
+ return true;
+}
+
+template<class T, class F> static uint32 test_scale_rows(const char *set_name, const char *kernel_name, F reference, F kernel)
+{
+ static T expect[TEST_BUF];
+ static T got[TEST_BUF];
+ uint32 colour32[256];
+ unsigned char src[TEST_MAX_W];
+ char what[128];
+ uint32 failures = 0;
+
+ for(uint16 i = 0; i < 256; i++)
+   colour32[i] = test_rand();
+
+ for(uint16 w = 0; w <= TEST_MAX_W; w++)
+   for(uint8 scale = 1; scale <= TEST_MAX_SCALE; scale++)
+     for(uint8 offset = 0; offset < 4; offset++)
+       for(uint8 trans = 0; trans < 2; trans++)
+         {
+          uint32 pitch = w * scale + TEST_PAD;
+          for(uint16 j = 0; j < w; j++)
+            src[j] = (test_rand() & 3) ? (unsigned char)test_rand() : 0xff;
+          for(uint32 i = 0; i < TEST_BUF; i++)
+            expect[i] = got[i] = (T)test_rand();
+
+          reference(expect + offset, pitch, src, w, colour32, scale, trans != 0);
+          kernel(got + offset, pitch, src, w, colour32, scale, trans != 0);
+
+          snprintf(what, sizeof(what), "%s %s width %d scale %d offset %d trans %d", set_name, kernel_name, w, scale, offset, trans);
+          if(!compare<T>(what, expect, got, TEST_BUF) && ++failures >= 10)
+            return failures;
+         }
+
+ return failures;
+}
+
+template<class T, class F> static uint32 test_shade_row(const char *set_name, const TestFormat *f, F reference, F kernel)
+{
+ static T expect[TEST_MAX_W + 8];
+ static T got[TEST_MAX_W + 8];
+ unsigned char shade[TEST_MAX_W + 8];
+ char what[128];
+ uint32 failures = 0;
+
+ for(uint16 w = 0; w <= TEST_MAX_W; w++)
+   for(uint8 offset = 0; offset < 4; offset++)
+     {
+      for(uint32 i = 0; i < TEST_MAX_W + 8; i++)
+        {
+         expect[i] = got[i] = (T)test_rand();
+         // plenty of the 0 and 255 edge cases
+         uint32 r = test_rand();
+         shade[i] = (r & 3) ? (unsigned char)(r >> 4) : ((r & 4) ? 0xff : 0);
+        }
+
+      reference(expect + offset, shade + offset, w, &f->format);
+      kernel(got + offset, shade + offset, w, &f->format);
+
+      snprintf(what, sizeof(what), "%s shade_row%d %s width %d offset %d", set_name, f->bits_per_pixel, f->name, w, offset);
+      if(!compare<T>(what, expect, got, TEST_MAX_W + 8) && ++failures >= 10)
+        return failures;
+     }
+
+ return failures;
+}
+
+int main(int argc, char **argv)
+{
+ static const char *set_names[] = { "sse2", "avx2" };
+ BlitKernels scalar;
+ uint32 failures = 0;
+ uint8 sets_tested = 0;
+
+ blit_kernels_scalar(&scalar);
+
+ for(uint8 s = 0; s < sizeof(set_names) / sizeof(set_names[0]); s++)
+   {
+    BlitKernels kernels;
+    if(!blit_kernels_named(&kernels, set_names[s]))
+      {
+       printf("skip %s: not in this build or CPU\n", set_names[s]);
+       continue;
+      }
+
+    sets_tested++;
+    failures += test_scale_rows<uint16>(set_names[s], "scale_rows16", scalar.scale_rows16, kernels.scale_rows16);
+    failures += test_scale_rows<uint32>(set_names[s], "scale_rows32", scalar.scale_rows32, kernels.scale_rows32);
+
+    for(uint8 i = 0; i < sizeof(test_formats) / sizeof(TestFormat); i++)
+      {
+       const TestFormat *f = &test_formats[i];
+       if(!blit_kernels_shade_supported(&f->format, f->bits_per_pixel))
+         {
+          printf("skip %s shade %s: format not handled by the vector kernels\n", set_names[s], f->name);
+          continue;
+         }
+
+       if(f->bits_per_pixel == 16)
+         failures += test_shade_row<uint16>(set_names[s], f, scalar.shade_row16, kernels.shade_row16);
+       else
+         failures += test_shade_row<uint32>(set_names[s], f, scalar.shade_row32, kernels.shade_row32);
+      }
+
+    printf("%s: %s\n", set_names[s], failures ? "FAILED" : "ok");
+   }
+
+ if(sets_tested == 0)
+   printf("no vector kernels to test\n");
+
+ return failures ? 1 : 0;
+}
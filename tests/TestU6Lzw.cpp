@@ -0,0 +1,243 @@
+/*
+ *  TestU6Lzw.cpp
+ *  Nuvie
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "nuvieDefs.h"
+#include "U6Lzw.h"
+
+/* Compresses known data with a small U6 style LZW encoder and checks that
+ * U6Lzw::decompress_buffer() gives it back. The data covers codewords sent
+ * before the decoder has them in its dictionary (the KwKwK case), codeword
+ * size changes up to 12 bits and dictionary resets once all 4096 codewords
+ * are used. Truncated and corrupt data must be rejected.
+ */
+
+typedef struct
+{
+ std::vector<unsigned char> data;
+ uint32 bits;
+ int codeword_size;
+ int dictionary_size;
+ int decoder_next; // next codeword the decoder will add
+ int kwkwk; // codewords sent one step ahead of the decoder
+ int resets;
+} TestLzwEncoder;
+
+static void put_codeword(TestLzwEncoder *enc, int codeword)
+{
+ for(int i = 0; i < enc->codeword_size; i++, enc->bits++)
+   {
+    if(enc->bits % 8 == 0)
+      enc->data.push_back(0);
+    if(codeword & (1 << i))
+      enc->data.back() |= 1 << (enc->bits % 8);
+   }
+}
+
+// Send a codeword, then follow the decoder's dictionary size the way
+// U6Lzw does. The first codeword after a reset doesn't add an entry.
+static void send_codeword(TestLzwEncoder *enc, int codeword, bool first)
+{
+ if(!first && codeword == enc->decoder_next)
+   enc->kwkwk++;
+
+ put_codeword(enc, codeword);
+ if(first)
+   return;
+
+ enc->decoder_next++;
+ if(enc->decoder_next >= enc->dictionary_size && enc->codeword_size < 12)
+   {
+    enc->codeword_size++;
+    enc->dictionary_size *= 2;
+   }
+}
+
+static void send_reset(TestLzwEncoder *enc, std::map<std::string, int> &dict)
+{
+ put_codeword(enc, 0x100);
+ enc->codeword_size = 9;
+ enc->dictionary_size = 0x200;
+ enc->decoder_next = 0x102;
+ dict.clear();
+ enc->resets++;
+}
+
+static int get_codeword(std::map<std::string, int> &dict, const std::string &s)
+{
+ if(s.size() == 1)
+   return (unsigned char)s[0];
+ return dict[s];
+}
+
+static void compress(const std::string &src, TestLzwEncoder *enc)
+{
+ std::map<std::string, int> dict;
+ int next = 0x102;
+ bool first = true;
+ std::string w;
+
+ enc->data.clear();
+ enc->bits = 0;
+ enc->codeword_size = 9;
+ enc->kwkwk = 0;
+ enc->resets = -1; // the one at the start doesn't count
+ for(int i = 0; i < 4; i++)
+   {
+    enc->data.push_back((src.size() >> (i * 8)) & 0xff);
+    enc->bits += 8;
+   }
+
+ send_reset(enc, dict);
+ w = src.substr(0, 1);
+ for(uint32 i = 1; i < src.size(); i++)
+   {
+    std::string wc = w + src[i];
+    if(dict.count(wc))
+      {
+       w = wc;
+       continue;
+      }
+
+    send_codeword(enc, get_codeword(dict, w), first);
+    first = false;
+    if(next < U6LZW_DICT_SIZE)
+      dict[wc] = next++;
+    else
+      {
+       send_reset(enc, dict);
+       next = 0x102;
+       first = true;
+      }
+    w = src.substr(i, 1);
+   }
+
+ send_codeword(enc, get_codeword(dict, w), first);
+ put_codeword(enc, 0x101);
+}
+
+static bool test_round_trip(const char *name, const std::string &src, bool want_kwkwk, bool want_reset)
+{
+ TestLzwEncoder enc;
+ U6Lzw lzw;
+ uint32 length = 0;
+
+ compress(src, &enc);
+ unsigned char *buf = lzw.decompress_buffer(&enc.data[0], enc.data.size(), length);
+
+ if(buf == NULL)
+   {
+    printf("FAIL: %s: %s\n", name, lzw.strerror());
+    return false;
+   }
+ if(length != src.size() || memcmp(buf, src.data(), length) != 0)
+   {
+    printf("FAIL: %s: decompressed data differs\n", name);
+    free(buf);
+    return false;
+   }
+ free(buf);
+
+ if((want_kwkwk && enc.kwkwk == 0) || (want_reset && enc.resets == 0))
+   {
+    printf("FAIL: %s: test data has %d KwKwK codewords and %d resets\n", name, enc.kwkwk, enc.resets);
+    return false;
+   }
+
+ // cut off before the end marker
+ if(lzw.decompress_buffer(&enc.data[0], enc.data.size() - 2, length) != NULL)
+   {
+    printf("FAIL: %s: truncated data was accepted\n", name);
+    return false;
+   }
+
+ // one byte less room than the data needs
+ std::vector<unsigned char> small(src.size());
+ if(lzw.decompress_buffer(&enc.data[0], enc.data.size(), &small[0], small.size() - 1))
+   {
+    printf("FAIL: %s: decompressed past the end of the destination\n", name);
+    return false;
+   }
+
+ printf("%s: %d bytes from %d, %d KwKwK codewords, %d resets\n", name, (int)src.size(), (int)enc.data.size(), enc.kwkwk, enc.resets);
+ return true;
+}
+
+static bool test_bad_codeword()
+{
+ TestLzwEncoder enc;
+ std::map<std::string, int> dict;
+ U6Lzw lzw;
+ uint32 length = 0;
+
+ // 0x103 comes before 0x102 is known
+ enc.bits = 0;
+ enc.codeword_size = 9;
+ for(int i = 0; i < 4; i++)
+   {
+    enc.data.push_back(i == 0 ? 4 : 0);
+    enc.bits += 8;
+   }
+ send_reset(&enc, dict);
+ send_codeword(&enc, 'a', true);
+ send_codeword(&enc, 0x103, false);
+ put_codeword(&enc, 0x101);
+
+ if(lzw.decompress_buffer(&enc.data[0], enc.data.size(), length) != NULL)
+   {
+    printf("FAIL: undefined codeword was accepted\n");
+    return false;
+   }
+
+ return true;
+}
+
+int main()
+{
+ std::string text, noise;
+ uint32 seed = 1;
+
+ for(int i = 0; i < 400; i++)
+   text += "Thou art the Avatar, and thou hast come to free Britannia! ";
+
+ // bytes from a short alphabet, so strings repeat without getting long
+ for(int i = 0; i < 60000; i++)
+   {
+    seed = seed * 1103515245 + 12345;
+    noise += (char)('a' + (seed >> 16) % 6);
+   }
+
+ if(!test_round_trip("single byte", "x", false, false)
+    || !test_round_trip("one byte repeated", std::string(5000, 'a'), true, false)
+    || !test_round_trip("two bytes repeated", "abababababababab", true, false)
+    || !test_round_trip("all byte values", std::string("\x00\xff\x01\xfe\x80\x7f", 6) + std::string(300, '\0'), true, false)
+    || !test_round_trip("text", text, false, false)
+    || !test_round_trip("noise", noise, true, true)
+    || !test_bad_codeword())
+   return 1;
+
+ return 0;
+}
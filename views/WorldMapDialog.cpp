@@ -47,6 +47,8 @@
 #include "Map.h"
 #include "TileManager.h"
 #include "Console.h"
+#include "MapWindow.h"
+#include "NuvieIOFile.h"
 
 // Wider dialog to include memo list panel
 #define WMD_WIDTH 420
@@ -137,8 +139,14 @@ WorldMapDialog::~WorldMapDialog()
         SDL_FreeSurface(worldmap_surface);
 }
 
+#define WORLD_MAP_HASHES_VERSION 1
+
 bool WorldMapDialog::loadWorldMap()
 {
+    MapWindow *map_window = Game::get_game()->get_map_window();
+    uint32 hashes[WORLD_MAP_NUM_SUPERCHUNKS];
+    map_window->get_world_map_hashes(hashes);
+
     // Try to load cached worldmap_4x.bmp from savedir first
     Configuration *config = Game::get_game()->get_config();
     std::string savedir;
@@ -146,10 +154,11 @@ bool WorldMapDialog::loadWorldMap()
     savedir_key.append("/savedir");
     config->value(savedir_key, savedir, "");
 
-    std::string cached_path;
+    std::string cached_path, hashes_path;
     if(!savedir.empty())
     {
         build_path(savedir, "worldmap_4x.bmp", cached_path);
+        build_path(savedir, "worldmap_4x.dat", hashes_path);
         SDL_Surface *loaded = SDL_LoadBMP(cached_path.c_str());
         if(loaded != NULL)
         {
@@ -160,7 +169,34 @@ bool WorldMapDialog::loadWorldMap()
                 map_width = worldmap_surface->w;
                 map_height = worldmap_surface->h;
                 DEBUG(0, LEVEL_INFORMATIONAL, "Loaded cached world map: %s (%dx%d)\n", cached_path.c_str(), map_width, map_height);
-                return true;
+
+                // Redraw the superchunks whose map or objects changed since the cache was saved.
+                // Without saved hashes (an older cache) everything is redrawn.
+                uint32 cached_hashes[WORLD_MAP_NUM_SUPERCHUNKS];
+                bool dirty[WORLD_MAP_NUM_SUPERCHUNKS];
+                bool have_hashes = loadWorldMapHashes(hashes_path, cached_hashes);
+                uint16 num_dirty = 0;
+
+                for(uint16 i = 0; i < WORLD_MAP_NUM_SUPERCHUNKS; i++)
+                {
+                    dirty[i] = (!have_hashes || cached_hashes[i] != hashes[i]);
+                    if(dirty[i])
+                        num_dirty++;
+                }
+
+                if(num_dirty == 0)
+                    return true;
+
+                DEBUG(0, LEVEL_INFORMATIONAL, "World map cache has %d of %d superchunks out of date\n", num_dirty, WORLD_MAP_NUM_SUPERCHUNKS);
+                if(map_window->update_world_map(worldmap_surface, 4, dirty))
+                {
+                    if(SDL_SaveBMP(worldmap_surface, cached_path.c_str()) == 0)
+                        saveWorldMapHashes(hashes_path, hashes);
+                    return true;
+                }
+
+                SDL_FreeSurface(worldmap_surface);
+                worldmap_surface = NULL;
             }
         }
     }
@@ -201,6 +237,7 @@ bool WorldMapDialog::loadWorldMap()
     {
         if(SDL_SaveBMP(worldmap_surface, cached_path.c_str()) == 0)
         {
+            saveWorldMapHashes(hashes_path, hashes);
             DEBUG(0, LEVEL_INFORMATIONAL, "Saved generated world map to: %s\n", cached_path.c_str());
             ConsoleAddInfo("World map saved to: %s", cached_path.c_str());
         }
@@ -211,120 +248,53 @@ bool WorldMapDialog::loadWorldMap()
 
 bool WorldMapDialog::generateWorldMap()
 {
-    Game *game = Game::get_game();
-    Map *map = game->get_game_map();
-    TileManager *tile_mgr = game->get_tile_manager();
-    Screen *scr = game->get_screen();
-
-    DEBUG(0, LEVEL_INFORMATIONAL, "generateWorldMap: map=%p, tile_mgr=%p, scr=%p\n", (void*)map, (void*)tile_mgr, (void*)scr);
-
-    if(!map || !tile_mgr || !scr)
-    {
-        DEBUG(0, LEVEL_ERROR, "generateWorldMap: Missing required objects\n");
-        return false;
-    }
+    MapWindow *map_window = Game::get_game()->get_map_window();
+    uint32 start_time = SDL_GetTicks();
 
     // Map is 1024x1024 tiles, we render at 4x scale (4 pixels per tile)
-    const int TILE_SCALE = 4;
-    const int MAP_SIZE = 1024;
-    map_width = MAP_SIZE * TILE_SCALE;
-    map_height = MAP_SIZE * TILE_SCALE;
-
-    // Create surface for world map
-    worldmap_surface = SDL_CreateRGBSurface(0, map_width, map_height, 32,
-        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    worldmap_surface = map_window->generate_world_map(4);
     if(!worldmap_surface)
-    {
-        DEBUG(0, LEVEL_ERROR, "Failed to create world map surface\n");
         return false;
-    }
 
-    // Get the screen's palette for color lookup (RGB values, 256 colors * 3 bytes)
-    const uint8 *palette = scr->get_palette();
-    if(!palette)
-    {
-        DEBUG(0, LEVEL_ERROR, "Failed to get screen palette\n");
-        SDL_FreeSurface(worldmap_surface);
-        worldmap_surface = NULL;
-        return false;
-    }
-
-    SDL_LockSurface(worldmap_surface);
-    uint32 *pixels = (uint32 *)worldmap_surface->pixels;
-    int pitch = worldmap_surface->pitch / 4;
-
-    // Debug: check first tile
-    Tile *first_tile = map->get_tile(0, 0, 0);
-    DEBUG(0, LEVEL_INFORMATIONAL, "generateWorldMap: first_tile=%p\n", (void*)first_tile);
-    if(first_tile)
-    {
-        DEBUG(0, LEVEL_INFORMATIONAL, "generateWorldMap: first tile data[0]=%d, palette[0]=%d,%d,%d\n",
-            first_tile->data[0], palette[0], palette[1], palette[2]);
-    }
+    map_width = worldmap_surface->w;
+    map_height = worldmap_surface->h;
+    ConsoleAddInfo("World map generated in %d ms", SDL_GetTicks() - start_time);
 
-    int tiles_processed = 0;
-    int tiles_null = 0;
+    return true;
+}
 
-    // Render each tile at 4x4 pixels using average/dominant color
-    for(int ty = 0; ty < MAP_SIZE; ty++)
-    {
-        for(int tx = 0; tx < MAP_SIZE; tx++)
-        {
-            Tile *tile = map->get_tile(tx, ty, 0);  // Surface level (z=0)
+// worldmap_4x.dat holds the MapWindow::get_world_map_hashes() of the cached bmp
+bool WorldMapDialog::loadWorldMapHashes(const std::string &filename, uint32 *hashes)
+{
+    NuvieIOFileRead file;
 
-            uint32 avg_color = 0xFF000000;  // Default black with full alpha
+    if(!file.open(filename))
+        return false;
 
-            if(tile)
-            {
-                tiles_processed++;
-                // Calculate average color from tile's 16x16 pixel data
-                int r_sum = 0, g_sum = 0, b_sum = 0;
+    if(file.get_size() != (WORLD_MAP_NUM_SUPERCHUNKS + 1) * 4 || file.read4() != WORLD_MAP_HASHES_VERSION)
+        return false;
 
-                for(int py = 0; py < 16; py++)
-                {
-                    for(int px = 0; px < 16; px++)
-                    {
-                        uint8 color_idx = tile->data[py * 16 + px];
-                        // palette is uint8[768]: 256 colors * 3 bytes (R, G, B)
-                        r_sum += palette[color_idx * 3 + 0];
-                        g_sum += palette[color_idx * 3 + 1];
-                        b_sum += palette[color_idx * 3 + 2];
-                    }
-                }
+    for(uint16 i = 0; i < WORLD_MAP_NUM_SUPERCHUNKS; i++)
+        hashes[i] = file.read4();
 
-                uint8 r = (uint8)(r_sum / 256);
-                uint8 g = (uint8)(g_sum / 256);
-                uint8 b = (uint8)(b_sum / 256);
-                avg_color = (0xFF << 24) | (r << 16) | (g << 8) | b;
-            }
-            else
-            {
-                tiles_null++;
-            }
+    return true;
+}
 
-            // Fill 4x4 pixel block with color
-            int base_x = tx * TILE_SCALE;
-            int base_y = ty * TILE_SCALE;
-            for(int dy = 0; dy < TILE_SCALE; dy++)
-            {
-                for(int dx = 0; dx < TILE_SCALE; dx++)
-                {
-                    pixels[(base_y + dy) * pitch + (base_x + dx)] = avg_color;
-                }
-            }
-        }
+bool WorldMapDialog::saveWorldMapHashes(const std::string &filename, const uint32 *hashes)
+{
+    NuvieIOFileWrite file;
 
-        // Progress indicator every 128 rows
-        if(ty % 128 == 0)
-        {
-            ConsoleAddInfo("Generating world map: %d%%", (ty * 100) / MAP_SIZE);
-        }
+    if(!file.open(filename))
+    {
+        DEBUG(0, LEVEL_WARNING, "Couldn't write %s\n", filename.c_str());
+        return false;
     }
 
-    SDL_UnlockSurface(worldmap_surface);
-    DEBUG(0, LEVEL_INFORMATIONAL, "generateWorldMap: tiles_processed=%d, tiles_null=%d\n", tiles_processed, tiles_null);
-    ConsoleAddInfo("World map: %d tiles processed, %d null", tiles_processed, tiles_null);
+    file.write4(WORLD_MAP_HASHES_VERSION);
+    for(uint16 i = 0; i < WORLD_MAP_NUM_SUPERCHUNKS; i++)
+        file.write4(hashes[i]);
 
+    file.close();
     return true;
 }
 
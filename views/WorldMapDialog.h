@@ -114,6 +114,8 @@ protected:
     // Internal methods
     bool loadWorldMap();
     bool generateWorldMap();  // Generate world map from tiles at runtime
+    bool loadWorldMapHashes(const std::string &filename, uint32 *hashes);
+    bool saveWorldMapHashes(const std::string &filename, const uint32 *hashes);
     void drawMapView();
     void drawPlayerMarker();
     void drawMarkers();